@@ -0,0 +1,72 @@
+// Include Guards - alignedbuffer.h
+#ifndef FTP_ALIGNED_BUFFER_H
+#define FTP_ALIGNED_BUFFER_H
+
+#include <cstddef>
+#include <cstdlib>
+
+#ifdef _WIN32
+    #include <malloc.h>
+#endif
+
+namespace ftp {
+
+/**
+ * @brief 按页对齐的可复用缓冲区
+ *
+ * 首次使用时才分配内存，之后在多次传输间复用，避免每次传输重新分配大块内存。
+ */
+class AlignedBuffer {
+public:
+    static const size_t PAGE_SIZE_BYTES = 4096;
+
+    AlignedBuffer() : ptr(nullptr), capacity(0) {}
+    ~AlignedBuffer() { release(); }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    /**
+     * @brief 确保缓冲区至少有 size 字节，失败返回 false
+     */
+    bool reserve(size_t size) {
+        if (size <= capacity) {
+            return true;
+        }
+        size = (size + PAGE_SIZE_BYTES - 1) / PAGE_SIZE_BYTES * PAGE_SIZE_BYTES;
+
+        release();
+#ifdef _WIN32
+        ptr = static_cast<char*>(_aligned_malloc(size, PAGE_SIZE_BYTES));
+#else
+        void* mem = nullptr;
+        ptr = posix_memalign(&mem, PAGE_SIZE_BYTES, size) == 0 ? static_cast<char*>(mem) : nullptr;
+#endif
+        capacity = ptr ? size : 0;
+        return ptr != nullptr;
+    }
+
+    char* data() { return ptr; }
+    size_t size() const { return capacity; }
+
+private:
+    void release() {
+        if (ptr) {
+#ifdef _WIN32
+            _aligned_free(ptr);
+#else
+            free(ptr);
+#endif
+            ptr = nullptr;
+            capacity = 0;
+        }
+    }
+
+private:
+    char* ptr;
+    size_t capacity;
+};
+
+} // namespace ftp
+
+#endif // FTP_ALIGNED_BUFFER_H
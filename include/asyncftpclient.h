@@ -0,0 +1,135 @@
+// Include Guards - asyncftpclient.h
+#ifndef FTP_ASYNC_CLIENT_H
+#define FTP_ASYNC_CLIENT_H
+
+#ifndef ASIO_STANDALONE
+#define ASIO_STANDALONE
+#endif
+
+#include <asio.hpp>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+#include "ftpclient.h"
+#include "replybuffer.h"
+
+namespace ftp {
+
+/**
+ * @brief 基于 Asio 的异步 FTP 客户端
+ *
+ * 所有 I/O 都在给定的 io_context 上以完成回调的方式进行，不占用线程等待网络，
+ * 少量线程即可驱动大量并发会话。同一客户端上提交的操作按提交顺序逐个执行，
+ * 客户端的所有处理函数与完成回调都在它自己的 strand 上执行，io_context 可由多个线程运行。
+ *
+ * 对象必须由 std::shared_ptr 管理（未完成的操作持有其引用）。
+ * 目前只支持明文 FTP 的被动模式；FTPS 会话仍使用 FTPClient。
+ */
+class AsyncFTPClient : public std::enable_shared_from_this<AsyncFTPClient> {
+public:
+    /**
+     * @brief 操作完成回调，失败时 error 为错误信息
+     */
+    using CompletionHandler = std::function<void(bool ok, const std::string& error)>;
+
+    /**
+     * @brief 目录列表完成回调
+     */
+    using ListHandler = std::function<void(bool ok, const std::string& error,
+                                           std::vector<FileEntry>& entries)>;
+
+    explicit AsyncFTPClient(asio::io_context& io);
+    ~AsyncFTPClient();
+
+    AsyncFTPClient(const AsyncFTPClient&) = delete;
+    AsyncFTPClient& operator=(const AsyncFTPClient&) = delete;
+
+    void asyncConnect(const std::string& host, uint16_t port, CompletionHandler handler);
+
+    /**
+     * @brief 登录并切换到 BINARY 传输类型
+     */
+    void asyncLogin(const std::string& username, const std::string& password,
+                    CompletionHandler handler);
+
+    /**
+     * @brief 获取解析后的目录列表（服务器支持时使用 MLSD）
+     * @param path 目录路径，为空时列出当前目录
+     */
+    void asyncList(const std::string& path, ListHandler handler);
+
+    /**
+     * @brief 流式获取目录列表，每解析出一个条目即在 strand 上回调一次，结束时调用 handler
+     *
+     * 数据边接收边解析，内存占用与目录大小无关；回调中的条目引用只在回调期间有效。
+     */
+    void asyncList(const std::string& path, ListCallback onEntry, CompletionHandler handler);
+
+    void asyncUpload(const std::string& localPath, const std::string& remotePath,
+                     bool resume, ProgressCallback progress, CompletionHandler handler);
+
+    void asyncDownload(const std::string& remotePath, const std::string& localPath,
+                       bool resume, ProgressCallback progress, CompletionHandler handler);
+
+    /**
+     * @brief 在操作队列中等待外部任务
+     *
+     * 轮到该操作时调用 start，之后提交的操作要等 start 收到的 done 被调用（可在任意线程）才开始执行。
+     */
+    void asyncWait(std::function<void(std::function<void()> done)> start);
+
+    /**
+     * @brief 关闭连接，未执行的操作以错误结束
+     */
+    void close();
+
+    /**
+     * @brief 设置进度上报节流配置，对之后开始的传输生效
+     */
+    void setProgressOptions(const ProgressOptions& options);
+
+private:
+    using Operation = std::function<void()>;
+    using ReplyHandler = std::function<void(const FTPResponse&)>;
+
+    struct ListState;
+    struct TransferState;
+
+    void enqueue(Operation op, CompletionHandler onCancel);
+    void startNext();
+    void complete(const CompletionHandler& handler, bool ok, const std::string& error);
+    void closeSockets();
+
+    void sendCommand(const std::string& command, ReplyHandler onReply);
+    void readReply(ReplyHandler onReply);
+    void probeFeatures(std::function<void()> next);
+    void openDataConnection(CompletionHandler onOpen);
+    void startTransfer(const std::string& command, int64_t restPos, CompletionHandler onStarted);
+    void readListing(const std::shared_ptr<ListState>& state);
+    void receiveFile(const std::shared_ptr<TransferState>& state);
+    void sendFile(const std::shared_ptr<TransferState>& state);
+    void finishTransfer(const std::shared_ptr<TransferState>& state, bool dataOk,
+                        const std::string& error);
+
+private:
+    asio::strand<asio::io_context::executor_type> strand;     ///< 串行执行本客户端的处理函数
+    asio::ip::tcp::resolver resolver;
+    asio::ip::tcp::socket controlSocket;
+    asio::ip::tcp::socket dataSocket;
+    ReplyBuffer replyBuffer;                ///< 控制连接接收缓冲区
+    std::string writeBuffer;                ///< 正在发送的命令
+    std::vector<char> dataBuffer;           ///< 数据连接缓冲区（跨传输复用）
+    std::deque<std::pair<Operation, CompletionHandler>> operations;    ///< 等待执行的操作
+    bool busy;                              ///< 是否有操作正在执行
+    bool connected;                         ///< 控制连接是否可用
+    int mlsdSupport;                        ///< MLSD 支持情况：-1 未检测，0 不支持，1 支持
+    ProgressOptions progressOptions;        ///< 进度上报节流配置
+};
+
+} // namespace ftp
+
+#endif // FTP_ASYNC_CLIENT_H
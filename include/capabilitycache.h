@@ -0,0 +1,70 @@
+// Include Guards - capabilitycache.h
+#ifndef FTP_CAPABILITY_CACHE_H
+#define FTP_CAPABILITY_CACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace ftp {
+
+/**
+ * @brief FTP 服务器能力：FEAT 响应与命令流水线的探测结果
+ */
+struct ServerCapabilities {
+    bool featSupported;                 ///< 服务器是否响应 FEAT；不响应时各特性未知，按逐条尝试处理
+    std::vector<std::string> features;  ///< FEAT 响应中的特性行（已去掉行首空格）
+    int pipelineSupport;                ///< 命令流水线支持情况：-1 未检测，0 不支持，1 支持
+
+    ServerCapabilities() : featSupported(false), pipelineSupport(-1) {}
+
+    /**
+     * @brief 查找以 name 开头的特性行（name 后为行尾或空格），未声明时返回空
+     */
+    const std::string* find(const std::string& name) const;
+};
+
+/**
+ * @brief 进程级服务器能力缓存，按 "host:port"、登录用户与是否加密保存
+ *
+ * 同一服务器的后续连接（连接池、分段下载与目录同步的并行会话）直接使用缓存的结果，
+ * 登录后不再发送 FEAT，也不再探测流水线。条目在 TTL 后过期，服务器升级后会重新探测。
+ */
+class CapabilityCache {
+public:
+    static CapabilityCache& instance();
+
+    static std::string makeKey(const std::string& host, uint16_t port,
+                               const std::string& user, bool secure);
+
+    /**
+     * @brief 取出未过期的条目，不存在时返回 false
+     */
+    bool get(const std::string& key, ServerCapabilities& capabilities);
+    void put(const std::string& key, const ServerCapabilities& capabilities);
+    void remove(const std::string& key);
+    void clear();
+
+private:
+    CapabilityCache() = default;
+
+    static const size_t MAX_ENTRIES = 1024;
+    static constexpr std::chrono::minutes TTL{60};    ///< 条目有效期
+
+    struct Entry {
+        ServerCapabilities capabilities;
+        std::chrono::steady_clock::time_point stored;
+    };
+
+    std::mutex mutex;
+    std::map<std::string, Entry> entries;
+    std::list<std::string> order;       ///< 写入顺序，超出容量时淘汰最早写入的条目
+};
+
+} // namespace ftp
+
+#endif // FTP_CAPABILITY_CACHE_H
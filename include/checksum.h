@@ -0,0 +1,70 @@
+// Include Guards - checksum.h
+#ifndef FTP_CHECKSUM_H
+#define FTP_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <openssl/evp.h>
+
+namespace ftp {
+
+/**
+ * @brief 校验算法
+ */
+enum class HashAlgorithm {
+    CRC32,      ///< CRC-32（与 zlib、XCRC 相同的多项式）
+    MD5,
+    SHA1,
+    SHA256
+};
+
+/**
+ * @brief 算法在 HASH 命令中的名称，例如 "SHA-256"
+ */
+const char* hashAlgorithmName(HashAlgorithm algorithm);
+
+/**
+ * @brief 按 HASH 命令中的名称（不区分大小写）查找算法，不支持的算法返回 false
+ */
+bool parseHashAlgorithm(const std::string& name, HashAlgorithm& algorithm);
+
+/**
+ * @brief 增量计算校验值
+ *
+ * CRC32 使用 zlib 的实现，MD5/SHA 使用 OpenSSL 的 EVP 接口；两者都按 CPU 能力
+ * 选用 SIMD 或专用指令（PCLMULQDQ、SHA-NI 等）的实现。
+ */
+class Hasher {
+public:
+    explicit Hasher(HashAlgorithm algorithm);
+    ~Hasher();
+
+    Hasher(const Hasher&) = delete;
+    Hasher& operator=(const Hasher&) = delete;
+
+    bool valid() const { return algo == HashAlgorithm::CRC32 || context != nullptr; }
+    HashAlgorithm algorithm() const { return algo; }
+
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief 已输入数据的校验值（小写十六进制），不影响之后继续 update
+     */
+    std::string digest() const;
+
+    /**
+     * @brief 丢弃已输入的数据，重新开始计算
+     */
+    void reset();
+
+private:
+    HashAlgorithm algo;
+    EVP_MD_CTX* context;    ///< MD5/SHA 的计算状态
+    uint32_t crc;           ///< CRC32 的当前值
+};
+
+} // namespace ftp
+
+#endif // FTP_CHECKSUM_H
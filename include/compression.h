@@ -0,0 +1,115 @@
+// Include Guards - compression.h
+#ifndef FTP_COMPRESSION_H
+#define FTP_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+namespace ftp {
+
+/**
+ * @brief 压缩/解压输出回调，返回 false 时中止
+ */
+using CompressOutput = std::function<bool(const char* data, size_t size)>;
+
+/**
+ * @brief MODE Z 上传使用的流式压缩器（zlib 格式）
+ *
+ * 压缩前 SAMPLE_SIZE 字节后若压缩率不足 MIN_SAVING，说明数据基本不可压缩，
+ * 其余数据改为不压缩的存储块输出，避免无谓的 CPU 开销。
+ */
+class Deflater {
+public:
+    static const size_t SAMPLE_SIZE = 1024 * 1024;     ///< 判断可压缩性的输入长度
+    static constexpr double MIN_SAVING = 0.05;         ///< 继续压缩所需的最低节省比例
+
+    /**
+     * @param level zlib 压缩级别（1~9）
+     */
+    explicit Deflater(int level);
+    ~Deflater();
+
+    Deflater(const Deflater&) = delete;
+    Deflater& operator=(const Deflater&) = delete;
+
+    bool valid() const { return initialized; }
+
+    /**
+     * @brief 压缩一块数据并通过 output 输出
+     * @param finish 为 true 时结束压缩流（data 可为空）
+     * @return 压缩出错或 output 返回 false 时返回 false
+     */
+    bool write(const char* data, size_t size, bool finish, const CompressOutput& output);
+
+    /**
+     * @brief 是否已因数据不可压缩而停止压缩
+     */
+    bool stored() const { return storedMode; }
+
+private:
+    /**
+     * @brief 取出 deflate 产生的输出
+     */
+    bool drain(int flush, const CompressOutput& output);
+
+private:
+    z_stream stream;
+    bool initialized;
+    bool storedMode;
+    uint64_t bytesIn;           ///< 已输入的字节数
+    uint64_t bytesOut;          ///< 已输出的字节数
+    std::vector<char> buffer;   ///< 压缩输出缓冲区
+};
+
+/**
+ * @brief MODE Z 下载使用的流式解压器（zlib 格式）
+ */
+class Inflater {
+public:
+    Inflater();
+    ~Inflater();
+
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+    bool valid() const { return initialized; }
+
+    /**
+     * @brief 解压一块数据并通过 output 输出，压缩流结束后的数据被忽略
+     * @return 数据格式错误或 output 返回 false 时返回 false
+     */
+    bool write(const char* data, size_t size, const CompressOutput& output);
+
+    /**
+     * @brief 是否已读到压缩流的结尾
+     */
+    bool finished() const { return streamEnd; }
+
+    const std::string& error() const { return lastError; }
+
+private:
+    z_stream stream;
+    bool initialized;
+    bool streamEnd;
+    std::vector<char> buffer;   ///< 解压输出缓冲区
+    std::string lastError;
+};
+
+/**
+ * @brief 用一段数据试压缩，判断是否值得以 MODE Z 传输
+ */
+bool isCompressible(const char* data, size_t size);
+
+/**
+ * @brief 按扩展名判断文件是否已是压缩格式（压缩包、图片、音视频等）
+ */
+bool hasCompressedExtension(const std::string& path);
+
+} // namespace ftp
+
+#endif // FTP_COMPRESSION_H
@@ -3,10 +3,20 @@
 #define FTP_CLIENT_H
 
 #include <string>
+#include <chrono>
 #include <vector>
 #include <memory>
 #include <functional>
 #include <cstdint>
+#include <atomic>
+#include <mutex>
+
+#include "alignedbuffer.h"
+#include "progressreporter.h"
+#include "ftplistparser.h"
+#include "replybuffer.h"
+#include "ratelimiter.h"
+#include "capabilitycache.h"
 
 #ifdef _WIN32
     #include <winsock2.h>
@@ -32,6 +42,74 @@
 
 namespace ftp {
 
+class LocalFile;
+class Hasher;
+enum class HashAlgorithm;
+
+/**
+ * @brief 目录列表条目回调
+ */
+using ListCallback = std::function<void(const FileEntry&)>;
+
+/**
+ * @brief 流式下载的数据回调，返回 false 时中止传输
+ */
+using DataSink = std::function<bool(const char* data, size_t size)>;
+
+/**
+ * @brief 流式上传的数据来源：向 buffer 写入最多 capacity 字节并设置 size，
+ *        size 为 0 表示数据结束；返回 false 时中止传输
+ */
+using DataSource = std::function<bool(char* buffer, size_t capacity, size_t& size)>;
+
+/**
+ * @brief 传输控制：在其他线程中取消或暂停正在进行的传输
+ *
+ * 传输循环在每个数据块之间检查请求；请求发出时立即关闭已登记数据连接的收发方向，
+ * 使阻塞在 recv/send 上的传输线程及时返回。客户端随后发送 ABOR 并读取服务器响应。
+ */
+class TransferControl {
+public:
+    /**
+     * @brief 停止请求
+     */
+    enum class Request {
+        NONE,       ///< 继续传输
+        PAUSE,      ///< 暂停：中止传输并保留已传输部分，之后以续传方式继续
+        CANCEL      ///< 取消
+    };
+
+    TransferControl() : request(static_cast<int>(Request::NONE)) {}
+
+    TransferControl(const TransferControl&) = delete;
+    TransferControl& operator=(const TransferControl&) = delete;
+
+    void cancel() { stop(Request::CANCEL); }
+    void pause() { stop(Request::PAUSE); }
+
+    /**
+     * @brief 清除停止请求（开始新的传输前调用）
+     */
+    void reset() { request = static_cast<int>(Request::NONE); }
+
+    Request pending() const { return static_cast<Request>(request.load()); }
+    bool stopRequested() const { return pending() != Request::NONE; }
+
+    /**
+     * @brief 登记/注销正在使用的数据连接（由 FTPClient 调用）
+     */
+    void attach(SOCKET socket);
+    void detach(SOCKET socket);
+
+private:
+    void stop(Request type);
+
+private:
+    std::atomic<int> request;
+    std::mutex mutex;
+    std::vector<SOCKET> sockets;    ///< 已登记的数据连接
+};
+
 /**
  * @brief FTP响应结构体
  */
@@ -57,21 +135,64 @@ enum class TransferType {
 };
 
 /**
- * @brief 传输进度回调函数类型
+ * @brief 目录同步选项
  */
-using ProgressCallback = std::function<void(int64_t current, int64_t total)>;
+struct MirrorOptions {
+    /**
+     * @brief 同步方向
+     */
+    enum class Direction {
+        DOWNLOAD,   ///< 以远程目录为准更新本地目录
+        UPLOAD      ///< 以本地目录为准更新远程目录
+    };
+
+    Direction direction;    ///< 同步方向
+    int parallel;           ///< 并行传输的连接数
+    bool dryRun;            ///< 只生成同步计划，不创建目录也不传输文件
+
+    MirrorOptions() : direction(Direction::DOWNLOAD), parallel(4), dryRun(false) {}
+};
+
+/**
+ * @brief 目录同步结果
+ */
+struct MirrorSummary {
+    int dirsCreated;                    ///< 创建的目录数
+    int filesTransferred;               ///< 传输成功的文件数
+    int filesSkipped;                   ///< 大小与修改时间均未变化而跳过的文件数
+    int filesFailed;                    ///< 传输失败的文件数
+    int64_t bytesTransferred;           ///< 传输成功的文件总字节数
+    std::vector<std::string> dirs;      ///< 需要创建的目录（相对路径，空字符串表示同步根目录本身）
+    std::vector<std::string> files;     ///< 需要传输的文件（相对路径）
+    std::vector<std::string> errors;    ///< 失败原因，格式为 "<相对路径>: <错误信息>"
+
+    MirrorSummary() : dirsCreated(0), filesTransferred(0), filesSkipped(0),
+                      filesFailed(0), bytesTransferred(0) {}
+};
+
+/**
+ * @brief 传输完整性校验结果
+ */
+struct IntegrityResult {
+    bool verified;          ///< 是否已与服务器的校验值比较且一致（服务器不支持校验命令时为 false）
+    bool restarted;         ///< 续传时已有部分与服务器不一致，改为从头传输
+    std::string algorithm;  ///< 使用的算法，例如 "SHA-256"
+    std::string digest;     ///< 本地计算的校验值（小写十六进制）
+
+    IntegrityResult() : verified(false), restarted(false) {}
+};
 
 /**
  * @brief SSL/TLS支持结构体
  */
 struct SSLSupport {
-    SSL_CTX* ctx;          ///< SSL上下文
+    std::shared_ptr<SSL_CTX> ctx;  ///< SSL上下文（进程内按 TLSConfig 共享）
     SSL* ssl;              ///< 控制连接SSL
     SSL* dataSSL;          ///< 数据连接SSL
     bool initialized;       ///< SSL初始化标志
     bool protected_mode;    ///< 保护模式标志
 
-    SSLSupport() : ctx(nullptr), ssl(nullptr), dataSSL(nullptr), 
+    SSLSupport() : ssl(nullptr), dataSSL(nullptr), 
                    initialized(false), protected_mode(false) {}
 };
 
@@ -94,14 +215,57 @@ public:
                       cert_file(""), key_file("") {}
     };
 
+    /**
+     * @brief 超时配置（毫秒），0 表示不限
+     */
+    struct Timeouts {
+        int connectMs;      ///< 建立控制/数据连接（含 TLS 握手、主动模式等待服务器连入）
+        int readMs;         ///< 等待服务器响应或数据连接读写的空闲时间
+        int transferMs;     ///< 单次数据传输（打开数据连接到关闭）的总时长
+        int checksumMs;     ///< 等待 HASH/XCRC 等校验命令的响应（服务器需读完整个文件），不短于 readMs
+
+        Timeouts() : connectMs(30000), readMs(120000), transferMs(0), checksumMs(600000) {}
+    };
+
+    /**
+     * @brief socket 选项，在连接建立前设置；系统不支持的选项被忽略
+     */
+    struct SocketOptions {
+        int sendBuffer;             ///< 数据连接 SO_SNDBUF（字节），0 使用系统默认（自动调整）
+        int receiveBuffer;          ///< 数据连接 SO_RCVBUF（字节），0 使用系统默认（自动调整）
+        bool controlNoDelay;        ///< 控制连接设置 TCP_NODELAY，命令不因 Nagle 算法延迟发送
+        std::string congestion;     ///< 数据连接的 TCP_CONGESTION，例如 "bbr"，空为系统默认（Linux）
+        int notSentLowat;           ///< 数据连接 TCP_NOTSENT_LOWAT（字节），0 不设置
+        bool keepAlive;             ///< 控制连接与数据连接设置 SO_KEEPALIVE
+        int keepAliveIdle;          ///< 开始发送保活探测前的空闲时间（秒），0 使用系统默认
+        int keepAliveInterval;      ///< 保活探测的间隔（秒），0 使用系统默认
+
+        SocketOptions() : sendBuffer(0), receiveBuffer(0), controlNoDelay(true), notSentLowat(0),
+                          keepAlive(false), keepAliveIdle(0), keepAliveInterval(0) {}
+    };
+
+    static const int DEFAULT_COMPRESSION_LEVEL = 6;     ///< MODE Z 默认压缩级别
+
     FTPClient();
     ~FTPClient();
 
     bool initSSL();
     bool upgradeToTLS();
     bool connect(const std::string& host, uint16_t port = 21);
+
+    /**
+     * @brief 登录，成功后获取服务器能力（FEAT 与流水线探测结果）
+     *
+     * 同一服务器、同一用户的能力缓存在进程级的 CapabilityCache 中，后续连接登录后不再发送 FEAT。
+     */
     bool login(const std::string& username, const std::string& password);
     void disconnect();
+    bool isConnected() const { return controlSocket != INVALID_SOCKET; }
+
+    /**
+     * @brief 发送 NOOP 检查控制连接是否可用
+     */
+    bool noop();
 
     bool uploadFile(const std::string& localPath, 
                    const std::string& remotePath,
@@ -113,28 +277,368 @@ public:
                      bool resume = false,
                      const ProgressCallback& progress = nullptr);
 
+    /**
+     * @brief 流式下载：数据从数据连接直接交给 sink，不经过本地文件
+     * @param offset 起始位置，大于 0 时通过 REST 从该位置开始
+     * @param onStart 传输开始前以远程文件大小回调（服务器不支持 SIZE 时为 -1）
+     */
+    bool downloadStream(const std::string& remotePath,
+                        int64_t offset,
+                        const std::function<void(int64_t size)>& onStart,
+                        const DataSink& sink,
+                        const ProgressCallback& progress = nullptr);
+
+    /**
+     * @brief 流式上传：从 source 读取数据直接写入数据连接，不经过本地文件
+     * @param offset 起始位置，大于 0 时通过 REST 从该位置续传
+     * @param totalSize 数据总长度（含 offset 之前的部分），仅用于进度上报，未知时为 -1
+     */
+    bool uploadStream(const std::string& remotePath,
+                      int64_t offset,
+                      int64_t totalSize,
+                      const DataSource& source,
+                      const ProgressCallback& progress = nullptr);
+
+    /**
+     * @brief 分段并行下载
+     *
+     * 分段进度保存在 "<localPath>.segments" 中，resume 时按分段继续；分段表无法使用时从头下载。
+     * 分段进度保存在 "<localPath>.segments" 中，resume 时按分段继续。
+     * @param segments 分段数，不大于 1 时等同于 downloadFile
+     */
+    bool downloadFileSegmented(const std::string& remotePath,
+                               const std::string& localPath,
+                               int segments,
+                               bool resume = false,
+                               const ProgressCallback& progress = nullptr);
+
+    /**
+     * @brief 递归同步本地目录与远程目录
+     *
+     * 遍历两侧目录树，按大小和修改时间（MLSD 或 MDTM）比较，创建缺失的目录，
+     * 并通过 parallel 个并行会话传输新增或变化的文件。下载的文件会同步远程修改时间。
+     * 不删除目标端多出的文件。
+     * @return 遍历失败或有文件传输失败时返回 false，详情见 summary
+     */
+    bool mirror(const std::string& localDir,
+                const std::string& remoteDir,
+                const MirrorOptions& options,
+                MirrorSummary& summary,
+                const ProgressCallback& progress = nullptr);
+
     void setTransferMode(TransferMode mode) { transferMode = mode; }
+    TransferMode getTransferMode() const { return transferMode; }
+    TransferType getTransferType() const { return transferType; }
     bool setTransferType(TransferType type);
     std::vector<std::string> listFiles();
+
+    /**
+     * @brief 获取解析后的目录列表
+     *
+     * 服务器在 FEAT 中声明 MLSD 时使用 MLSD，否则解析 LIST 输出。
+     * @param path 目录路径，为空时列出当前目录
+     */
+    bool listDirectory(std::vector<FileEntry>& entries, const std::string& path = "");
+
+    /**
+     * @brief 流式获取目录列表，每解析出一个条目即回调一次
+     *
+     * 数据边接收边解析，内存占用与目录大小无关；回调中的条目引用只在回调期间有效。
+     */
+    bool listDirectory(const std::string& path, const ListCallback& onEntry);
     std::string getCurrentDir();
     bool changeDir(const std::string& path);
     bool makeDir(const std::string& path);
     bool removeDir(const std::string& path);
     bool deleteFile(const std::string& path);
 
+    /**
+     * @brief 批量删除文件
+     *
+     * 在控制连接上以流水线方式发送 DELE，不逐条等待响应。
+     * @param recursive 为 true 时，DELE 失败的目录连同其内容一起删除
+     * @param results 与 paths 一一对应的最终响应，成功为 250；code 为 0 表示未能完成
+     * @return 全部删除成功时返回 true
+     */
+    bool deleteFiles(const std::vector<std::string>& paths, bool recursive,
+                     std::vector<FTPResponse>& results);
+
+    /**
+     * @brief 批量发送控制命令，按顺序返回每条命令的最终响应
+     *
+     * 服务器支持时以流水线方式发送，不逐条等待响应；否则退化为逐条发送。
+     * 支持情况在每个连接上首次批量发送时探测一次。
+     * @return 连接出错时返回 false，已收到的响应保留在 replies 中
+     */
+    bool sendCommands(const std::vector<std::string>& commands,
+                      std::vector<FTPResponse>& replies);
+
+    /**
+     * @brief 设置之后传输使用的传输控制，为空时传输不可中止
+     *
+     * 中止的传输返回 false，错误信息为 "Transfer cancelled" 或 "Transfer paused"；
+     * 已传输的部分保留，可通过 resume（或分段表）继续。
+     */
+    void setTransferControl(std::shared_ptr<TransferControl> control) { transferControl = std::move(control); }
+
+    /**
+     * @brief 设置之后传输使用的限速，为空时不限速
+     *
+     * 同一 RateLimits 可交给多个客户端，其共享令牌桶在这些客户端的所有传输间分配带宽。
+     * 限速按数据连接上实际收发的字节数计算（MODE Z 下为压缩后的字节数）。
+     */
+    void setRateLimits(std::shared_ptr<const RateLimits> limits) { rateLimits = std::move(limits); }
+
+    /**
+     * @brief 设置 uploadFile/downloadFile 是否使用 MODE Z 压缩传输
+     *
+     * 仅在服务器的 FEAT 声明 MODE Z 时生效。扩展名表明已是压缩格式的文件、
+     * 试压缩表明不可压缩的上传文件不使用压缩；上传过程中压缩率过低时改为不压缩的存储块。
+     * 分段下载与流式传输始终不压缩。
+     * @param level 压缩级别 1~9，用于上传时的本地压缩，并通过 OPTS MODE Z LEVEL 告知服务器
+     */
+    void setCompression(bool enabled, int level = DEFAULT_COMPRESSION_LEVEL);
+    bool getCompression() const { return compression; }
+
+    /**
+     * @brief 设置 uploadFile/downloadFile 是否校验传输完整性
+     *
+     * 传输过程中对数据增量计算校验值，完成后与服务器 HASH（或 XSHA256/XSHA1/XMD5/XCRC）的结果比较，
+     * 不一致时传输返回 false。续传前先比较已有部分，不一致时从头传输。
+     * 服务器的 FEAT 未声明校验命令时不校验。启用后不使用 sendfile/splice 零拷贝路径；
+     * 分段下载的数据乱序到达，在全部分段完成后读取本地文件计算校验值。
+     */
+    void setIntegrityCheck(bool enabled) { integrityCheck = enabled; }
+    bool getIntegrityCheck() const { return integrityCheck; }
+
+    /**
+     * @brief 最近一次文件传输的完整性校验结果
+     */
+    const IntegrityResult& getLastIntegrity() const { return lastIntegrity; }
+
+    /**
+     * @brief 服务器在 FEAT 中声明的特性行，例如 "MLST type*;size*;"、"MODE Z"
+     */
+    std::vector<std::string> getFeatures();
+
     std::string getLastError() const { return lastError; }
     std::string getSSLInfo() const;
 
     TLSConfig tlsConfig;
+    ProgressOptions progressOptions;    ///< 进度上报节流配置
+    Timeouts timeouts;                  ///< 连接、读写与传输超时
+    SocketOptions socketOptions;        ///< 控制连接与数据连接的 socket 选项
 
 private:
     bool sendCommand(const std::string& command);
+    bool sendRaw(const std::string& data);
     FTPResponse getResponse();
-    SOCKET createDataConnection();
+
+    /**
+     * @brief 读取控制连接数据到响应缓冲区；超时、出错或对端关闭时关闭控制连接
+     */
+    bool readControlData(std::string& error);
+
+    /**
+     * @brief 不发送 QUIT，直接关闭控制连接（连接已不能再使用时）
+     */
+    void closeControlConnection();
+
+    /**
+     * @brief 等待一条完整响应到达（不取出），超时或出错返回 false
+     */
+    bool waitForResponse(int timeoutMs);
+
+    /**
+     * @brief 流水线发送命令：最多 window 条命令同时等待响应，按顺序收集全部响应
+     * @return 连接出错时返回 false，已收到的响应保留在 replies 中
+     */
+    bool pipelineCommands(const std::vector<std::string>& commands,
+                          std::vector<FTPResponse>& replies,
+                          size_t window);
+    bool supportsPipelining();
+
+    /**
+     * @brief 以 PWD 为标记重新对齐命令与响应，丢弃 257 之前最多 maxStale 条迟到的响应
+     *
+     * 未能找到标记时断开连接（连接不能再使用）并返回 false。
+     */
+    bool resyncReplies(int maxStale);
+
+    /**
+     * @brief 建立数据连接，setup 中的命令与 PASV/PORT 一起发送
+     * @param setupReplies 接收 setup 命令的响应
+     * @return 被动模式返回已连接的数据 socket，主动模式返回监听 socket
+     */
+    SOCKET createDataConnection(const std::vector<std::string>& setup = {},
+                                std::vector<FTPResponse>* setupReplies = nullptr,
+                                bool compress = false);
+
+    /**
+     * @brief 处理 createDataConnection 中切换 MODE Z/S 的响应，并从 replies 末尾移除
+     *
+     * 服务器拒绝 MODE Z 时按未压缩传输；无法切回 MODE S 时返回 false。
+     */
+    bool applyModeReplies(std::vector<FTPResponse>& replies, size_t count, bool compress);
+
+    /**
+     * @brief 判断本次传输是否使用 MODE Z
+     * @param sample 上传的本地文件，用于试压缩；下载时为空
+     */
+    bool useCompression(const std::string& path, LocalFile* sample);
+
+    /**
+     * @brief 按当前传输的限速扣除 bytes 字节，必要时等待（传输被中止时提前返回）
+     */
+    void throttle(size_t bytes);
+
+    /**
+     * @brief 当前限速下每次收发的数据块长度，不限速时为 max
+     */
+    size_t transferChunk(size_t max) const { return limiter ? limiter->batchSize(max) : max; }
+
+    /**
+     * @brief 在数据连接上发送全部数据
+     */
+    bool sendAll(SOCKET dataSocket, const char* data, size_t size);
+
+    /**
+     * @brief 以 poll 等待 socket 可读或可写，超时或出错时设置 lastError 并返回 false
+     * @param connecting 为 true 时按连接超时等待，否则按读写空闲超时与传输总时长中先到期者等待
+     */
+    bool waitSocket(SOCKET socket, bool writable, bool connecting = false);
+
+    /**
+     * @brief 在非阻塞 socket 上读取（tls 不为空时经 TLS 读取），数据未就绪时等待
+     * @return 读取的字节数；连接关闭返回 0；出错或超时返回 -1 并设置 lastError
+     */
+    int receiveSome(SOCKET socket, SSL* tls, char* buffer, size_t length);
+
+    /**
+     * @brief 在非阻塞 socket 上发送（tls 不为空时经 TLS 发送），发送缓冲区满时等待
+     * @return 发送的字节数；出错或超时返回 -1 并设置 lastError
+     */
+    int sendSome(SOCKET socket, SSL* tls, const char* data, size_t length);
+
+    /**
+     * @brief 在非阻塞 socket 上完成 TLS 握手，失败时设置 lastError
+     */
+    bool tlsHandshake(SSL* tls, SOCKET socket);
+
+    /**
+     * @brief 发送传输命令（restPos 大于 0 时与 REST 一起发送）并完成数据连接的建立
+     *
+     * 收到 1xx 响应后才接受主动模式连接、进行数据连接的 TLS 握手。
+     * 失败时关闭 dataSocket，并读取服务器的最终响应。
+     */
+    bool startTransfer(const std::string& command, int64_t restPos, SOCKET& dataSocket);
+    bool secureDataConnection(SOCKET dataSocket);
+    void closeDataConnection(SOCKET dataSocket, bool drain = false);
+
+    /**
+     * @brief 传输控制是否要求停止当前传输
+     */
+    bool transferStopped() const { return transferControl && transferControl->stopRequested(); }
+
+    /**
+     * @brief 中止正在进行的传输：关闭数据连接，发送 ABOR 并读取服务器响应，设置 lastError
+     */
+    void abortTransfer(SOCKET dataSocket);
     bool parsePasvResponse(const std::string& response, 
                           std::string& ip, uint16_t& port);
     int64_t getFileSize(const std::string& path);
-    bool setFilePosition(int64_t pos);
+    int64_t getModificationTime(const std::string& path);
+    bool removeTree(const std::string& path, FTPResponse& result);
+
+    /**
+     * @brief path 是否为目录：服务器支持 MLST 时看 type 事实，否则尝试 CWD 进入后再返回原目录
+     */
+    bool isDirectory(const std::string& path);
+    bool supportsMLSD();
+
+    /**
+     * @brief 服务器是否在 FEAT 中声明了 name（例如 "MODE Z"），FEAT 每个连接只发送一次
+     */
+    bool hasFeature(const std::string& name) { return findFeature(name) != nullptr; }
+
+    /**
+     * @brief 查找 FEAT 中以 name 开头的特性行，未声明时返回空
+     */
+    const std::string* findFeature(const std::string& name);
+
+    /**
+     * @brief 服务器响应了 FEAT 且其中没有 name，据此可以不发送注定失败的命令
+     */
+    bool featureMissing(const std::string& name);
+
+    /**
+     * @brief 获取服务器能力：已登录且缓存中有同一服务器的结果时直接使用，否则发送 FEAT 并存入缓存
+     */
+    void loadFeatures();
+    void saveCapabilities();
+
+    /**
+     * @brief 查询文件大小的命令：服务器未声明 SIZE 但 MLST 提供 size 时使用 MLST
+     */
+    std::string sizeCommand(const std::string& path);
+
+    /**
+     * @brief 服务器是否支持 REST（FEAT 中的 "REST STREAM"，服务器不响应 FEAT 时假定支持）
+     */
+    bool supportsRestart() { return !featureMissing("REST STREAM"); }
+
+    /**
+     * @brief 选择服务器支持的校验算法（优先 SHA-256），服务器不支持任何校验命令时返回 false
+     */
+    bool checksumAlgorithm(HashAlgorithm& algorithm);
+
+    /**
+     * @brief 获取远程文件前 length 字节的校验值，length 小于 0 时为整个文件
+     * @return 服务器无法计算时返回 false（不设置 lastError）
+     */
+    bool remoteChecksum(const std::string& path, HashAlgorithm algorithm,
+                        int64_t length, std::string& digest);
+
+    /**
+     * @brief 读取本地文件的前 length 字节计入 hasher
+     */
+    bool hashLocalFile(LocalFile& file, int64_t length, Hasher& hasher);
+
+    /**
+     * @brief 续传前校验已有部分：读取本地前 length 字节计入 hasher，并与服务器同一区间的校验值比较
+     * @param wholeFile length 是否为远程文件的全部长度
+     * @return 不一致时返回 false（hasher 已清空）；服务器无法计算该区间时返回 true，由传输完成后的校验把关
+     */
+    bool verifyPrefix(const std::string& remotePath, LocalFile& file, int64_t length,
+                      bool wholeFile, Hasher& hasher);
+
+    /**
+     * @brief 传输完成后比较 hasher 与服务器的整个文件的校验值，结果记入 lastIntegrity
+     * @return 不一致时返回 false 并设置 lastError
+     */
+    bool verifyTransfer(const std::string& remotePath, const Hasher& hasher);
+    bool readListing(const std::string& command, const std::function<void(std::string_view)>& onLine);
+    std::unique_ptr<FTPClient> openSiblingSession(const std::string& workDir,
+                                                  std::string& error) const;
+
+    /**
+     * @brief 文件数据的发送与接收，hasher 不为空时对经过的数据计算校验值（此时不使用零拷贝）
+     */
+    bool sendFileData(SOCKET dataSocket, LocalFile& file, int64_t& transferred,
+                      int64_t fileSize, ProgressReporter& reporter, Hasher* hasher);
+    bool receiveFileData(SOCKET dataSocket, LocalFile& file, int64_t& offset, int64_t end,
+                         const std::function<void(int64_t)>& onData, Hasher* hasher);
+
+    /**
+     * @brief MODE Z 下的文件发送与接收，transferred/offset 为未压缩数据的位置
+     */
+    bool sendCompressedData(SOCKET dataSocket, LocalFile& file, int64_t& transferred,
+                            int64_t fileSize, ProgressReporter& reporter, Hasher* hasher);
+    bool receiveCompressedData(SOCKET dataSocket, LocalFile& file, int64_t& offset,
+                               const std::function<void(int64_t)>& onData, Hasher* hasher);
+    bool downloadRange(const std::string& remotePath, LocalFile& file,
+                       int64_t start, int64_t end,
+                       const std::function<void(int64_t)>& onData);
     static bool initNetwork();
 
 private:
@@ -143,6 +647,28 @@ private:
     TransferType transferType;   ///< 传输类型
     std::string lastError;       ///< 最后的错误信息
     SSLSupport ssl;             ///< SSL/TLS支持
+    std::string serverHost;      ///< 服务器地址（用于建立并行会话）
+    uint16_t serverPort;         ///< 服务器端口
+    AlignedBuffer transferBuffer;    ///< 数据传输缓冲区（按页对齐，跨传输复用）
+    std::string loginUser;       ///< 登录用户名
+    std::string loginPassword;   ///< 登录密码
+    std::string tlsSessionKey;   ///< TLS 会话缓存键（host:port 与 TLS 配置）
+    bool featuresLoaded;         ///< 是否已获取服务器能力
+    ServerCapabilities capabilities;    ///< 服务器能力（FEAT 与流水线探测结果）
+    std::string capabilityKey;   ///< 能力缓存键，登录后设置
+    bool epsvRejected;           ///< 服务器是否拒绝过 EPSV（本会话改用 PASV）
+    std::chrono::steady_clock::time_point transferDeadline;  ///< 当前数据传输的截止时间，不限时为 max
+    bool transferTimedOut;       ///< 当前数据传输开始后是否发生过读写超时
+    ReplyBuffer replyBuffer;     ///< 控制连接接收缓冲区（保留尚未取出的响应）
+    std::shared_ptr<TransferControl> transferControl;   ///< 传输控制（可为空）
+    std::shared_ptr<const RateLimits> rateLimits;       ///< 限速设置（可为空）
+    std::shared_ptr<RateLimiter> limiter;               ///< 当前传输的限速器（分段下载的各连接共用）
+    bool compression;            ///< 文件传输是否使用 MODE Z
+    int compressionLevel;        ///< MODE Z 压缩级别
+    bool modeZ;                  ///< 服务器当前是否处于 MODE Z
+    bool integrityCheck;         ///< 文件传输是否校验完整性
+    std::string hashSelection;   ///< 服务器 HASH 命令当前使用的算法
+    IntegrityResult lastIntegrity;  ///< 最近一次文件传输的校验结果
 
     static bool networkInit;     ///< 网络初始化标志
 };
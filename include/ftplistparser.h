@@ -0,0 +1,79 @@
+// Include Guards - ftplistparser.h
+#ifndef FTP_LIST_PARSER_H
+#define FTP_LIST_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace ftp {
+
+/**
+ * @brief 目录列表中的一项
+ */
+struct FileEntry {
+    /**
+     * @brief 条目类型
+     */
+    enum class Type : uint8_t {
+        FILE,           ///< 普通文件
+        DIRECTORY,      ///< 目录
+        LINK,           ///< 符号链接
+        OTHER           ///< 其他（设备文件等）
+    };
+
+    std::string name;   ///< 文件名（不含路径）
+    int64_t size;       ///< 文件大小，未知时为 -1
+    int64_t mtime;      ///< 修改时间（Unix 时间戳，秒），未知时为 -1
+    int32_t perms;      ///< Unix 权限位（如 0644），未知时为 -1
+    Type type;          ///< 条目类型
+
+    FileEntry() : size(-1), mtime(-1), perms(-1), type(Type::FILE) {}
+};
+
+/**
+ * @brief 解析 MLSD/MDTM 使用的 "YYYYMMDDHHMMSS[.sss]" 时间（UTC）
+ * @return Unix 时间戳（秒），格式错误返回 -1
+ */
+int64_t parseFTPTimestamp(std::string_view value);
+
+/**
+ * @brief 目录列表行解析器
+ *
+ * MLSD 按 RFC 3659 的 "fact=value;... name" 格式解析；LIST 支持 Unix "ls -l" 与 Windows/IIS 两种常见格式。
+ * 解析过程只在 string_view 上切分字段，除文件名外不分配内存。
+ */
+class ListingParser {
+public:
+    /**
+     * @brief 列表格式
+     */
+    enum class Format {
+        MLSD,       ///< 机器可读格式（RFC 3659）
+        LIST        ///< LIST 命令的自由格式
+    };
+
+    explicit ListingParser(Format format);
+
+    /**
+     * @brief 解析一行列表
+     * @return 行格式无法识别，或是 "."、".." 等非目录内容的条目时返回 false
+     */
+    bool parseLine(std::string_view line, FileEntry& entry) const;
+
+    Format format() const { return listFormat; }
+
+private:
+    bool parseMLSD(std::string_view line, FileEntry& entry) const;
+    bool parseUnix(std::string_view line, FileEntry& entry) const;
+    bool parseDOS(std::string_view line, FileEntry& entry) const;
+
+private:
+    Format listFormat;
+    int currentYear;    ///< 用于补全 Unix 列表中省略的年份
+    int currentMonth;
+};
+
+} // namespace ftp
+
+#endif // FTP_LIST_PARSER_H
@@ -0,0 +1,120 @@
+// Include Guards - ftppool.h
+#ifndef FTP_POOL_H
+#define FTP_POOL_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <map>
+#include <deque>
+#include <unordered_map>
+
+#include "ftpclient.h"
+
+namespace ftp {
+
+/**
+ * @brief 已登录 FTP 控制连接的连接池
+ *
+ * 连接按（主机、端口、用户、TLS 配置）分组复用；借出前对空闲较久的连接发送 NOOP 检查，
+ * 空闲超时的连接被关闭，同一 host:port 的连接总数（借出 + 空闲）受上限约束。
+ */
+class FTPConnectionPool {
+public:
+    /**
+     * @brief 连接池配置
+     */
+    struct Options {
+        size_t maxPerHost;                          ///< 每个 host:port 的最大连接数
+        std::chrono::seconds idleTimeout;           ///< 空闲超过该时间的连接被关闭
+        std::chrono::seconds healthCheckAfter;      ///< 空闲超过该时间的连接借出前先发送 NOOP
+        std::chrono::milliseconds leaseTimeout;     ///< 达到上限时等待连接归还的最长时间
+
+        Options() : maxPerHost(16), idleTimeout(300), healthCheckAfter(15), leaseTimeout(10000) {}
+    };
+
+    /**
+     * @brief 连接目标
+     */
+    struct Target {
+        std::string host;
+        uint16_t port;
+        std::string username;
+        bool useTLS;
+        FTPClient::TLSConfig tlsConfig;
+        FTPClient::Timeouts timeouts;   ///< 借出的连接使用的超时（不参与连接的匹配）
+        FTPClient::SocketOptions socketOptions;     ///< 新建连接的 socket 选项（不参与连接的匹配）
+
+        Target() : port(21), useTLS(false) {}
+    };
+
+    explicit FTPConnectionPool(const Options& options = Options());
+    ~FTPConnectionPool();
+
+    FTPConnectionPool(const FTPConnectionPool&) = delete;
+    FTPConnectionPool& operator=(const FTPConnectionPool&) = delete;
+
+    /**
+     * @brief 借出一个已登录的连接，没有可用的空闲连接时新建
+     * @param error 失败时的错误信息
+     * @return 失败返回 nullptr
+     */
+    std::shared_ptr<FTPClient> lease(const Target& target, const std::string& password, std::string& error);
+
+    /**
+     * @brief 归还借出的连接
+     * @param reusable 为 false 时直接关闭连接（例如连接状态已无法确定）
+     */
+    void release(const std::shared_ptr<FTPClient>& client, bool reusable = true);
+
+    /**
+     * @brief 关闭空闲超时的连接
+     */
+    void evictIdle();
+
+    /**
+     * @brief 关闭所有空闲连接
+     */
+    void clear();
+
+    size_t idleCount();
+    size_t leasedCount();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct IdleConnection {
+        std::shared_ptr<FTPClient> client;
+        std::string homeDir;            ///< 登录后的初始目录，归还时恢复
+        Clock::time_point since;        ///< 进入空闲状态的时间
+    };
+
+    struct LeaseInfo {
+        std::string poolKey;
+        std::string hostKey;
+        std::string homeDir;
+    };
+
+    static std::string makeHostKey(const Target& target);
+    static std::string makePoolKey(const Target& target, const std::string& password);
+
+    std::shared_ptr<FTPClient> connectNew(const Target& target, const std::string& password,
+                                          std::string& homeDir, std::string& error);
+    bool resetState(FTPClient& client, const std::string& homeDir);
+    void dropHostSlot(const std::string& hostKey);
+
+private:
+    Options options;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::map<std::string, std::deque<IdleConnection>> idle;        ///< poolKey -> 空闲连接（队尾最近使用）
+    std::map<std::string, std::string> idleHost;                    ///< poolKey -> hostKey
+    std::map<std::string, size_t> hostCount;                        ///< hostKey -> 连接总数
+    std::unordered_map<FTPClient*, LeaseInfo> leased;
+};
+
+} // namespace ftp
+
+#endif // FTP_POOL_H
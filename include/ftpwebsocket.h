@@ -8,15 +8,25 @@
 #include <websocketpp/server.hpp>
 #include <json/json.h>
 #include <memory>
-#include <map>
 #include <functional>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <unordered_map>
+
+#include "sessiondispatcher.h"
+#include "sessionregistry.h"
+#include "streamchannel.h"
+#include "transferscheduler.h"
+#include "ftppool.h"
 
 namespace ftp {
 
 // Forward declarations
-class FTPClient;
+struct TransferProgress;
+class AsyncFTPClient;
 using WebSocketServer = websocketpp::server<websocketpp::config::asio>;
+using Strand = websocketpp::lib::asio::strand<websocketpp::lib::asio::io_context::executor_type>;
 using WebSocketConnectionPtr = websocketpp::connection_hdl;
 using json = Json::Value;
 
@@ -28,11 +38,15 @@ public:
     /**
      * @brief 构造函数
      * @param port WebSocket服务器端口
+     * @param workerCount 执行FTP命令的工作线程数（0 表示使用硬件并发数）
+     * @param ioThreadCount 运行 io_context 的线程数（0 表示使用硬件并发数）
+     * @param schedulerOptions 后台传输任务的并发上限
      */
-    FTPWebSocketServer(uint16_t port = 9002);
+    FTPWebSocketServer(uint16_t port = 9002, size_t workerCount = 0, size_t ioThreadCount = 1,
+                       const TransferScheduler::Options& schedulerOptions = TransferScheduler::Options());
 
     /**
-     * @brief 启动服务器
+     * @brief 启动服务器，阻塞到 io_context 的所有线程退出
      */
     void run();
 
@@ -41,7 +55,53 @@ public:
      */
     void stop();
 
+    /**
+     * @brief 当前打开的 WebSocket 会话数
+     */
+    size_t sessionCount() const { return sessions.size(); }
+
 private:
+    /**
+     * @brief WebSocket 会话状态
+     *
+     * 只在会话自己的工作线程中修改；最后一个持有者释放时归还（或断开）FTP 连接。
+     */
+    struct Session {
+        const uint64_t id;                  ///< 会话 ID，进程内唯一
+        FTPConnectionPool& pool;
+        Strand strand;                      ///< 按提交顺序向该连接发送消息
+        std::shared_ptr<FTPClient> client;
+        bool leased;                        ///< client 借自连接池
+        bool pendingLease;                  ///< connect 已记录目标，login 时从连接池借出连接
+        FTPConnectionPool::Target target;   ///< 连接目标，也用于后台传输任务借出连接
+        std::string password;               ///< 登录密码，后台传输任务借出连接时使用
+        bool loggedIn;                      ///< 是否已登录
+        std::atomic<bool> closed;           ///< WebSocket 连接已关闭
+        std::shared_ptr<AsyncFTPClient> asyncClient;    ///< async 会话的客户端，只在连接的处理函数中访问
+        ProgressOptions asyncProgress;                  ///< async 会话的进度上报配置
+        const std::shared_ptr<TransferControl> transfer;    ///< 本会话直接执行的传输的控制
+        std::atomic<int> pendingTransfers;  ///< 已提交但尚未结束的传输命令数
+        const std::shared_ptr<TokenBucket> sessionLimit;    ///< 本会话全部传输共享的令牌桶
+        const std::shared_ptr<RateLimits> limits;   ///< 本会话传输的限速，共享令牌桶依次为会话级、当前主机级
+        StreamChannel upload;               ///< 流式上传的数据通道
+        std::mutex streamMutex;
+        std::condition_variable streamDrained;  ///< streamPending 回落或连接关闭时通知
+        size_t streamPending;               ///< 已提交但尚未发送完毕的二进制帧字节数，由 streamMutex 保护
+
+        Session(uint64_t id, FTPConnectionPool& pool, websocketpp::lib::asio::io_context& io);
+        ~Session();
+
+        /**
+         * @brief 归还或断开当前连接，换上新的未连接客户端
+         */
+        void resetClient();
+
+        /**
+         * @brief 扣除已发送完毕的 size 字节，唤醒等待发送缓冲回落的工作线程（连接关闭时以 0 调用）
+         */
+        void releaseStream(size_t size);
+    };
+
     /**
      * @brief WebSocket连接打开时的回调
      */
@@ -58,30 +118,133 @@ private:
     void onMessage(WebSocketConnectionPtr hdl, WebSocketServer::message_ptr msg);
 
     /**
-     * @brief 处理FTP命令
+     * @brief 处理二进制帧：交给当前的流式上传
+     */
+    void onBinaryMessage(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                         WebSocketServer::message_ptr msg);
+
+    /**
+     * @brief 以二进制帧发送流式下载的数据（在会话工作线程中调用）
+     *
+     * 已提交但尚未发送完毕的数据超过上限时阻塞等待，直到其回落或连接关闭。
+     * @return 连接已关闭时返回 false
+     */
+    bool sendBinary(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                    const char* data, size_t size);
+
+    /**
+     * @brief 在会话的 strand 中确认二进制帧已发送：websocketpp 的发送缓冲低于上限时释放 size 字节，
+     *        否则稍后再检查（websocketpp 没有发送缓冲排空的通知）
+     */
+    void drainStream(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session, size_t size);
+
+    /**
+     * @brief 查找连接对应的会话
+     */
+    std::shared_ptr<Session> findSession(WebSocketConnectionPtr hdl);
+
+    /**
+     * @brief 处理FTP命令（在会话工作线程中执行）
+     */
+    void handleFTPCommand(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                          const json& command);
+
+    /**
+     * @brief 在 io_context 线程中直接发起 async 会话的命令
+     * @return 命令已处理时返回 true，否则交给工作线程处理
+     */
+    bool handleAsyncCommand(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                            const json& command);
+
+    /**
+     * @brief 把 upload/download/mirror 命令作为后台任务提交给调度器
+     */
+    void submitTransferJob(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                           const json& command, json& response);
+
+    /**
+     * @brief 处理 jobStatus/cancel/pause/resume 命令（在 io_context 线程中执行，不经过工作线程）
+     *
+     * 未指定 jobId 的 cancel/pause 作用于本会话直接执行的传输。
      */
-    void handleFTPCommand(WebSocketConnectionPtr hdl, const json& command);
+    void handleJobCommand(const std::shared_ptr<Session>& session, const std::string& cmd,
+                          const json& command, json& response);
 
     /**
-     * @brief 发送响应给客户端
+     * @brief 处理 setRateLimit 命令（在 io_context 线程中执行，对正在进行的传输立即生效）
+     */
+    void handleRateLimitCommand(const std::shared_ptr<Session>& session, const json& command,
+                                json& response);
+
+    /**
+     * @brief 取得 FTP 主机（host:port）的共享令牌桶，不存在时创建（不限速）
+     *
+     * 表中只保存弱引用，令牌桶随最后一个使用它的会话或后台任务释放；每次查找时清理已释放的项。
+     */
+    std::shared_ptr<TokenBucket> hostLimit(const std::string& hostKey);
+
+    /**
+     * @brief 定期关闭连接池中空闲超时的连接
+     */
+    void scheduleIdleEviction();
+
+    /**
+     * @brief 发送响应给客户端（序列化后投递到会话的 strand 上发送）
      */
     void sendResponse(WebSocketConnectionPtr hdl, const json& response);
 
     /**
      * @brief 进度回调函数
      */
-    void onProgress(WebSocketConnectionPtr hdl, int64_t current, int64_t total);
+    void onProgress(WebSocketConnectionPtr hdl, const TransferProgress& progress);
+
+    /**
+     * @brief 将传输进度转换为 progress 消息
+     */
+    static json progressToJson(const TransferProgress& progress);
+
+    /**
+     * @brief 将后台任务信息转换为 JSON 对象
+     */
+    static json jobToJson(const TransferScheduler::JobInfo& info);
+
+    /**
+     * @brief 将传输完整性校验结果转换为 JSON 对象
+     */
+    static json integrityToJson(const IntegrityResult& integrity);
+
+    /**
+     * @brief 将目录同步结果转换为 JSON 对象
+     */
+    static json mirrorSummaryToJson(const MirrorSummary& summary);
+
+    /**
+     * @brief 将目录条目转换为 JSON 对象
+     */
+    static json fileEntryToJson(const FileEntry& entry);
 
     /**
      * @brief 批量删除文件
+     * @param recursive 是否递归删除目录
+     * @param results 每个路径的删除结果（JSON 数组）
+     * @return 全部删除成功时返回 true
      */
-    bool batchDeleteFiles(const std::vector<std::string>& files, std::shared_ptr<FTPClient> client);
+    bool batchDeleteFiles(const std::vector<std::string>& files, bool recursive,
+                          std::shared_ptr<FTPClient> client, json& results);
 
 private:
     WebSocketServer server;
     uint16_t port;
-    std::map<void*, std::shared_ptr<FTPClient>> clientMap;
-    std::mutex mutex;
+    size_t ioThreadCount;
+    FTPConnectionPool pool;     ///< 必须晚于会话析构，会话析构时向其归还连接
+    SessionRegistry<Session> sessions;  ///< 以连接句柄地址为键的会话表
+    std::mutex timerMutex;
+    WebSocketServer::timer_ptr evictTimer;
+    bool evictStopped;
+    SessionDispatcher dispatcher;
+    std::mutex hostLimitMutex;
+    std::unordered_map<std::string, std::weak_ptr<TokenBucket>> hostLimits;    ///< 每个 FTP 主机的令牌桶
+    TransferScheduler scheduler;    ///< 后台传输任务，必须最先析构（任务使用连接池与会话表）
 };
 
 } // namespace ftp
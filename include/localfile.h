@@ -0,0 +1,72 @@
+// Include Guards - localfile.h
+#ifndef FTP_LOCAL_FILE_H
+#define FTP_LOCAL_FILE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace ftp {
+
+/**
+ * @brief 本地文件句柄封装
+ *
+ * 基于文件描述符的轻量封装，提供按偏移写入与预分配等 std::fstream 不具备的操作。
+ * Windows 下 readAt/writeAt 通过 seek + read/write 实现，同一句柄不可被多个线程同时使用。
+ */
+class LocalFile {
+public:
+    /**
+     * @brief 打开方式
+     */
+    enum class Mode {
+        READ,           ///< 只读
+        WRITE,          ///< 读写，不存在则创建，存在则清空
+        READ_WRITE      ///< 读写，不存在则创建，保留原有内容
+    };
+
+    LocalFile();
+    ~LocalFile();
+
+    LocalFile(const LocalFile&) = delete;
+    LocalFile& operator=(const LocalFile&) = delete;
+
+    bool open(const std::string& path, Mode mode);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    /**
+     * @brief 获取文件当前大小，失败返回 -1
+     */
+    int64_t size() const;
+
+    /**
+     * @brief 从指定偏移处读取数据
+     * @return 实际读取的字节数，0 表示文件结束，-1 表示失败
+     */
+    int64_t readAt(int64_t offset, void* buffer, size_t length);
+
+    /**
+     * @brief 在指定偏移处写入全部数据
+     */
+    bool writeAt(int64_t offset, const void* data, size_t length);
+
+    /**
+     * @brief 将文件大小调整为 length，并尽量为其分配磁盘空间
+     */
+    bool resize(int64_t length);
+
+    /**
+     * @brief 为前 length 字节预留磁盘空间，不改变文件大小（平台不支持时返回 false）
+     */
+    bool preallocate(int64_t length);
+
+    int nativeHandle() const { return fd; }
+
+private:
+    int fd;     ///< 文件描述符
+};
+
+} // namespace ftp
+
+#endif // FTP_LOCAL_FILE_H
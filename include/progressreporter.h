@@ -0,0 +1,87 @@
+// Include Guards - progressreporter.h
+#ifndef FTP_PROGRESS_REPORTER_H
+#define FTP_PROGRESS_REPORTER_H
+
+#include <cstdint>
+#include <chrono>
+#include <functional>
+
+namespace ftp {
+
+/**
+ * @brief 传输进度信息
+ */
+struct TransferProgress {
+    int64_t current;        ///< 已传输字节数（含续传前已有部分）
+    int64_t total;          ///< 文件总字节数
+    double instantRate;     ///< 瞬时速率（字节/秒，自上次上报以来）
+    double averageRate;     ///< 平均速率（字节/秒，自本次传输开始）
+    double etaSeconds;      ///< 预计剩余时间（秒），无法估算时为 -1
+};
+
+/**
+ * @brief 传输进度回调函数类型
+ */
+using ProgressCallback = std::function<void(const TransferProgress& progress)>;
+
+/**
+ * @brief 进度上报节流配置
+ *
+ * 两次上报之间需同时满足时间间隔与字节数要求；传输完成时总会上报最终进度。
+ */
+struct ProgressOptions {
+    int intervalMs;         ///< 最小上报间隔（毫秒）
+    int64_t minBytes;       ///< 最小上报字节增量
+
+    ProgressOptions() : intervalMs(250), minBytes(64 * 1024) {}
+};
+
+/**
+ * @brief 进度上报器，按 ProgressOptions 合并进度事件并计算速率与剩余时间
+ */
+class ProgressReporter {
+public:
+    /**
+     * @param callback 进度回调（可为空）
+     * @param options 节流配置
+     * @param total 文件总字节数
+     * @param start 起始字节数（续传时为已有部分的长度）
+     */
+    ProgressReporter(const ProgressCallback& callback, const ProgressOptions& options,
+                     int64_t total, int64_t start);
+
+    /**
+     * @brief 更新进度，满足节流条件时才调用回调
+     */
+    void update(int64_t current) {
+        if (callback && current - lastBytes >= options.minBytes) {
+            maybeEmit(current);
+        }
+    }
+
+    /**
+     * @brief 传输结束，若有未上报的进度则立即上报
+     */
+    void finish(int64_t current);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void maybeEmit(int64_t current);
+    void emit(int64_t current, Clock::time_point now);
+
+private:
+    ProgressCallback callback;
+    ProgressOptions options;
+    int64_t total;
+    int64_t startBytes;
+    Clock::time_point startTime;
+    int64_t lastBytes;              ///< 上次上报时的字节数
+    Clock::time_point lastTime;     ///< 上次上报的时间
+    double smoothedRate;            ///< 平滑后的速率，用于估算剩余时间
+    bool emitted;                   ///< 是否已上报过
+};
+
+} // namespace ftp
+
+#endif // FTP_PROGRESS_REPORTER_H
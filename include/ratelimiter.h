@@ -0,0 +1,115 @@
+// Include Guards - ratelimiter.h
+#ifndef FTP_RATE_LIMITER_H
+#define FTP_RATE_LIMITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ftp {
+
+/**
+ * @brief 令牌桶，可被多个传输线程共享
+ *
+ * 令牌按速率持续补充，最多积累 BURST_SECONDS 秒的量。consume 允许欠账：
+ * 令牌不足时立即扣除并返回还清欠账所需的等待时间，调用方以大块数据为单位扣除，
+ * 每块只需加锁一次、等待一次；多个线程的欠账依次累积，共享带宽按扣除顺序分配。
+ */
+class TokenBucket {
+public:
+    static constexpr double BURST_SECONDS = 0.25;   ///< 空闲后允许突发的时长
+
+    /**
+     * @param bytesPerSecond 速率上限（字节/秒），0 表示不限速
+     */
+    explicit TokenBucket(int64_t bytesPerSecond = 0);
+
+    TokenBucket(const TokenBucket&) = delete;
+    TokenBucket& operator=(const TokenBucket&) = delete;
+
+    /**
+     * @brief 修改速率上限，已累积的令牌与欠账清零，正在进行的传输从下一块数据起按新速率计算
+     */
+    void setRate(int64_t bytesPerSecond);
+    int64_t getRate() const { return rate.load(); }
+
+    /**
+     * @brief 扣除 bytes 个令牌
+     * @return 需要等待的时间，不限速或令牌充足时为 0
+     */
+    std::chrono::nanoseconds consume(size_t bytes);
+
+private:
+    std::atomic<int64_t> rate;
+    std::mutex mutex;
+    double tokens;                                  ///< 当前令牌数，为负表示欠账
+    std::chrono::steady_clock::time_point last;     ///< 上次补充令牌的时间
+};
+
+/**
+ * @brief 限速设置，由调用方持有并交给 FTPClient，修改后对正在进行的传输生效
+ *
+ * 每个传输按 transferRate 使用独立的令牌桶；shared 中的令牌桶由使用同一设置的所有传输共享
+ * （例如同一 WebSocket 会话、同一 FTP 主机）。
+ */
+class RateLimits {
+public:
+    RateLimits() : transferRate(0) {}
+
+    void setTransferRate(int64_t bytesPerSecond) { transferRate = bytesPerSecond; }
+    int64_t getTransferRate() const { return transferRate.load(); }
+
+    void setShared(std::vector<std::shared_ptr<TokenBucket>> buckets);
+    std::vector<std::shared_ptr<TokenBucket>> getShared() const;
+
+private:
+    std::atomic<int64_t> transferRate;      ///< 单个传输的速率上限（字节/秒），0 表示不限速
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<TokenBucket>> shared;
+};
+
+/**
+ * @brief 一次传输的限速器
+ *
+ * 在传输开始时按 RateLimits 创建，组合本次传输独占的令牌桶与共享令牌桶，
+ * 每块数据取所有令牌桶中最长的等待时间。分段下载的各个连接共用同一个限速器。
+ */
+class RateLimiter {
+public:
+    static const size_t MIN_BATCH = 16 * 1024;      ///< 限速时每块数据的最小长度
+    static const int BATCH_MILLISECONDS = 50;       ///< 限速时每块数据约等于多少毫秒的流量
+
+    /**
+     * @param limits 限速设置，为空时不限速
+     */
+    explicit RateLimiter(std::shared_ptr<const RateLimits> limits = nullptr);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    /**
+     * @brief 下一块数据的长度：不限速时为 max，否则约为最低速率下 BATCH_MILLISECONDS 的流量
+     */
+    size_t batchSize(size_t max) const;
+
+    /**
+     * @brief 扣除已传输的 bytes 字节，必要时等待
+     * @param stopped 等待期间定期检查，返回 true 时提前结束等待
+     * @return 等待被 stopped 打断时返回 false
+     */
+    bool consume(size_t bytes, const std::function<bool()>& stopped = nullptr);
+
+private:
+    std::shared_ptr<const RateLimits> limits;
+    TokenBucket transfer;                               ///< 本次传输独占的令牌桶
+    std::vector<std::shared_ptr<TokenBucket>> shared;   ///< 传输开始时的共享令牌桶
+};
+
+} // namespace ftp
+
+#endif // FTP_RATE_LIMITER_H
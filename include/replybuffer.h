@@ -0,0 +1,67 @@
+// Include Guards - replybuffer.h
+#ifndef FTP_REPLY_BUFFER_H
+#define FTP_REPLY_BUFFER_H
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+namespace ftp {
+
+/**
+ * @brief 控制连接的接收缓冲区与响应解析器
+ *
+ * 套接字数据直接读入缓冲区，按行增量查找响应结尾：已扫描过的行不会重复扫描，
+ * 一次读取中多出的字节（流水线中后续命令的响应）保留给下一次解析。
+ * 多行响应以 "ddd-" 开头，以相同响应码加空格 "ddd " 开头的行结束。
+ */
+class ReplyBuffer {
+public:
+    static const size_t MIN_READ_SIZE = 4096;           ///< 每次读取预留的最小空间
+    static const size_t MAX_BUFFERED = 1024 * 1024;     ///< 单条响应的最大长度
+
+    ReplyBuffer();
+
+    /**
+     * @brief 准备可写区域，读入数据后调用 commit
+     * @return 可写区域的起始位置；缓冲数据超过 MAX_BUFFERED 时返回 nullptr
+     */
+    char* prepare(size_t& available);
+
+    /**
+     * @brief 确认写入了 n 字节
+     */
+    void commit(size_t n) { tail += n; }
+
+    /**
+     * @brief 缓冲区中是否已有一条完整响应
+     */
+    bool hasReply();
+
+    /**
+     * @brief 取出一条完整响应
+     * @param code 响应码，首行不以三位数字开头时为 0
+     * @param text 响应码之后的文本（多行响应包含后续各行，去掉末尾换行），
+     *             在下一次 prepare 或 clear 之前有效
+     * @return 响应不完整时返回 false
+     */
+    bool next(int& code, std::string_view& text);
+
+    /**
+     * @brief 丢弃全部缓冲数据（连接断开或重建时调用）
+     */
+    void clear();
+
+    bool empty() const { return head == tail; }
+
+private:
+    std::vector<char> storage;
+    size_t head;        ///< 未取出数据的起始位置
+    size_t tail;        ///< 未取出数据的结束位置
+    size_t scanPos;     ///< 当前响应中下一个待扫描行的起始位置
+    size_t replyEnd;    ///< 已找到的响应结束位置，未找到时为 0
+};
+
+} // namespace ftp
+
+#endif // FTP_REPLY_BUFFER_H
@@ -0,0 +1,81 @@
+// Include Guards - sessiondispatcher.h
+#ifndef FTP_SESSION_DISPATCHER_H
+#define FTP_SESSION_DISPATCHER_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ftp {
+
+/**
+ * @brief 会话任务分发器
+ *
+ * 固定数量的工作线程执行所有会话的FTP任务：同一会话的任务按提交顺序串行执行，
+ * 不同会话之间并行执行。每个会话的待处理任务数有上限，避免单个客户端无限堆积命令。
+ */
+class SessionDispatcher {
+public:
+    using Task = std::function<void()>;
+    using SessionKey = const void*;
+
+    /**
+     * @brief 构造函数
+     * @param workerCount 工作线程数（0 表示使用硬件并发数）
+     * @param maxPendingPerSession 单个会话允许排队的最大任务数
+     */
+    explicit SessionDispatcher(size_t workerCount = 0, size_t maxPendingPerSession = 64);
+    ~SessionDispatcher();
+
+    SessionDispatcher(const SessionDispatcher&) = delete;
+    SessionDispatcher& operator=(const SessionDispatcher&) = delete;
+
+    /**
+     * @brief 提交会话任务
+     * @return 队列已满或分发器已停止时返回 false
+     */
+    bool post(SessionKey key, Task task);
+
+    /**
+     * @brief 移除会话，已提交的任务执行完毕后释放其队列
+     */
+    void removeSession(SessionKey key);
+
+    /**
+     * @brief 停止所有工作线程（未执行的任务将被丢弃）
+     */
+    void shutdown();
+
+    size_t workerCount() const { return workers.size(); }
+
+private:
+    struct SessionQueue {
+        SessionKey key;
+        std::deque<Task> tasks;
+        bool scheduled;     ///< 是否已在就绪队列中或正在执行
+        bool removed;       ///< 会话已关闭
+
+        explicit SessionQueue(SessionKey k) : key(k), scheduled(false), removed(false) {}
+    };
+
+    void workerLoop();
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<SessionKey, std::shared_ptr<SessionQueue>> sessions;
+    std::deque<std::shared_ptr<SessionQueue>> ready;   ///< 有待执行任务的会话
+    std::vector<std::thread> workers;
+    size_t maxPending;
+    bool stopping;
+};
+
+} // namespace ftp
+
+#endif // FTP_SESSION_DISPATCHER_H
@@ -0,0 +1,148 @@
+// Include Guards - sessionregistry.h
+#ifndef FTP_SESSION_REGISTRY_H
+#define FTP_SESSION_REGISTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ftp {
+
+/**
+ * @brief 分片的会话表
+ *
+ * 以连接句柄地址为键，按键的哈希分布到多个分片，每个分片有自己的锁：
+ * 不同连接的打开、关闭与查找很少争用同一把锁，且锁只在查表期间持有，
+ * 取出的会话以 shared_ptr 返回，之后的 FTP 操作不再持有任何锁。
+ */
+template <typename Session>
+class SessionRegistry {
+public:
+    using Key = const void*;
+    using SessionPtr = std::shared_ptr<Session>;
+
+    /**
+     * @param shardCount 分片数，向上取整为 2 的幂
+     */
+    explicit SessionRegistry(size_t shardCount = 64) : nextId(1), count(0) {
+        size_t n = 1;
+        while (n < shardCount) {
+            n <<= 1;
+        }
+        shards.reset(new Shard[n]);
+        shardMask = n - 1;
+    }
+
+    SessionRegistry(const SessionRegistry&) = delete;
+    SessionRegistry& operator=(const SessionRegistry&) = delete;
+
+    /**
+     * @brief 分配一个进程内唯一、不复用的会话 ID
+     */
+    uint64_t newId() {
+        return nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 登记会话，键已存在时替换（连接句柄地址可能被新连接复用）
+     */
+    void insert(Key key, SessionPtr session) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto result = shard.sessions.emplace(key, nullptr);
+        if (result.second) {
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+        result.first->second = std::move(session);
+    }
+
+    SessionPtr find(Key key) const {
+        const Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(key);
+        return it != shard.sessions.end() ? it->second : nullptr;
+    }
+
+    /**
+     * @brief 移除会话，返回被移除的会话（不存在时为空）
+     */
+    SessionPtr remove(Key key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(key);
+        if (it == shard.sessions.end()) {
+            return nullptr;
+        }
+        SessionPtr session = std::move(it->second);
+        shard.sessions.erase(it);
+        count.fetch_sub(1, std::memory_order_relaxed);
+        return session;
+    }
+
+    size_t size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 当前全部会话的快照（逐个分片加锁复制，不阻塞其他分片）
+     */
+    std::vector<SessionPtr> snapshot() const {
+        std::vector<SessionPtr> result;
+        result.reserve(size());
+        for (size_t i = 0; i <= shardMask; ++i) {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            for (const auto& pair : shards[i].sessions) {
+                result.push_back(pair.second);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief 移除并返回全部会话（用于停止服务器）
+     */
+    std::vector<SessionPtr> clear() {
+        std::vector<SessionPtr> result;
+        for (size_t i = 0; i <= shardMask; ++i) {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            for (auto& pair : shards[i].sessions) {
+                result.push_back(std::move(pair.second));
+            }
+            count.fetch_sub(shards[i].sessions.size(), std::memory_order_relaxed);
+            shards[i].sessions.clear();
+        }
+        return result;
+    }
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<Key, SessionPtr> sessions;
+    };
+
+    size_t shardIndex(Key key) const {
+        // 堆地址的低位总是对齐为 0，混合高位后再取分片
+        uintptr_t value = reinterpret_cast<uintptr_t>(key);
+        value ^= value >> 17;
+        value *= static_cast<uintptr_t>(0x9E3779B97F4A7C15ull);
+        value ^= value >> 29;
+        return static_cast<size_t>(value) & shardMask;
+    }
+
+    Shard& shardFor(Key key) { return shards[shardIndex(key)]; }
+    const Shard& shardFor(Key key) const { return shards[shardIndex(key)]; }
+
+private:
+    std::unique_ptr<Shard[]> shards;
+    size_t shardMask;
+    std::atomic<uint64_t> nextId;
+    std::atomic<size_t> count;
+};
+
+} // namespace ftp
+
+#endif // FTP_SESSION_REGISTRY_H
@@ -0,0 +1,105 @@
+// Include Guards - streamchannel.h
+#ifndef FTP_STREAM_CHANNEL_H
+#define FTP_STREAM_CHANNEL_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+
+namespace ftp {
+
+/**
+ * @brief 流式上传的数据通道
+ *
+ * WebSocket 的 I/O 线程把收到的二进制帧放入通道，执行上传命令的工作线程从中读取并写入数据连接。
+ * 缓冲数据超过 HIGH_WATERMARK 时 push 要求暂停读取 WebSocket，
+ * 消费到 LOW_WATERMARK 以下时调用恢复回调，背压由此传到浏览器一侧的 TCP 连接。
+ *
+ * 每个会话一个通道，同一时间只能有一个上传流：空的二进制帧表示数据结束。
+ */
+class StreamChannel {
+public:
+    static const size_t HIGH_WATERMARK = 8 * 1024 * 1024;  ///< 暂停读取的缓冲上限
+    static const size_t LOW_WATERMARK = 2 * 1024 * 1024;   ///< 恢复读取的缓冲下限
+
+    /**
+     * @brief 恢复读取回调，在消费者线程中调用
+     */
+    using ResumeCallback = std::function<void()>;
+
+    StreamChannel();
+
+    StreamChannel(const StreamChannel&) = delete;
+    StreamChannel& operator=(const StreamChannel&) = delete;
+
+    void setResumeCallback(ResumeCallback callback);
+
+    /**
+     * @brief 开始一个新的上传流（I/O 线程）
+     * @return 上一个流尚未结束或通道已关闭时返回 false
+     */
+    bool open();
+
+    /**
+     * @brief 追加一帧数据，空帧表示数据结束（I/O 线程）
+     * @param pause 返回是否应暂停读取 WebSocket
+     * @return 当前没有等待数据的上传流时返回 false
+     */
+    bool push(std::string data, bool& pause);
+
+    /**
+     * @brief 阻塞读取数据（工作线程）
+     * @param size 读取的字节数，为 0 表示数据已结束
+     * @return 通道被中止或读取被打断时返回 false
+     */
+    bool read(char* buffer, size_t capacity, size_t& size);
+
+    /**
+     * @brief 结束当前上传流（工作线程，上传命令结束时调用）
+     *
+     * 数据尚未收完时丢弃剩余的帧，直到收到结束帧后才能开始下一个流。
+     */
+    void close();
+
+    /**
+     * @brief 打断正在等待数据的读取（取消或暂停传输时调用），直到 close 前的读取都返回 false
+     */
+    void interrupt();
+
+    /**
+     * @brief 永久关闭通道，唤醒等待中的读取（WebSocket 连接关闭时调用）
+     */
+    void abort();
+
+private:
+    enum class State {
+        IDLE,           ///< 没有上传流
+        OPEN,           ///< 正在接收数据
+        FINISHED,       ///< 已收到结束帧，数据尚未读完
+        DISCARDING,     ///< 上传已结束，丢弃剩余的帧直到结束帧
+        ABORTED         ///< 通道已关闭
+    };
+
+    /**
+     * @brief 清空缓冲区，若读取已暂停则返回 true（调用方负责在锁外恢复读取）
+     */
+    bool discardLocked();
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::string> chunks;     ///< 尚未读取的帧
+    size_t frontOffset;                 ///< 首帧中已读取的字节数
+    size_t buffered;                    ///< 尚未读取的总字节数
+    bool paused;                        ///< 是否已要求暂停读取
+    bool interrupted;                   ///< 当前上传流已被取消或暂停
+    State state;
+    ResumeCallback onResume;
+};
+
+} // namespace ftp
+
+#endif // FTP_STREAM_CHANNEL_H
@@ -0,0 +1,92 @@
+// Include Guards - tlscontext.h
+#ifndef FTP_TLS_CONTEXT_H
+#define FTP_TLS_CONTEXT_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <list>
+
+#include "ftpclient.h"
+
+namespace ftp {
+
+/**
+ * @brief 进程级 SSL_CTX 缓存
+ *
+ * 相同 TLSConfig 的连接共享同一个 SSL_CTX，CA 与证书文件只在首次使用时解析。
+ * 证书文件在磁盘上更新后需调用 clear() 使新连接重新加载。
+ */
+class TLSContextCache {
+public:
+    static TLSContextCache& instance();
+
+    /**
+     * @brief 获取与配置对应的 SSL_CTX，不存在时创建
+     * @param error 失败时的错误信息
+     */
+    std::shared_ptr<SSL_CTX> acquire(const FTPClient::TLSConfig& config, std::string& error);
+
+    /**
+     * @brief 生成配置的缓存键，同时用于区分会话缓存
+     */
+    static std::string makeKey(const FTPClient::TLSConfig& config);
+
+    void clear();
+
+private:
+    TLSContextCache() = default;
+    std::shared_ptr<SSL_CTX> create(const FTPClient::TLSConfig& config, std::string& error);
+
+private:
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<SSL_CTX>> contexts;
+};
+
+/**
+ * @brief 客户端 TLS 会话缓存，按 "host:port" 与 TLS 配置保存可恢复的会话
+ *
+ * 控制连接握手时通过 SSL_set_ex_data 登记缓存键，服务器下发的新会话（含 TLS 1.3 票据）
+ * 由 SSL_CTX 的 new_session 回调存入缓存，重连时用于恢复会话。
+ */
+class TLSSessionCache {
+public:
+    static TLSSessionCache& instance();
+
+    /**
+     * @brief SSL 对象上保存缓存键（const std::string*）的 ex_data 索引
+     */
+    static int keyIndex();
+
+    /**
+     * @brief 取出会话副本，由调用者释放（SSL_SESSION_free）
+     */
+    SSL_SESSION* get(const std::string& key);
+
+    /**
+     * @brief 保存会话，接管调用者持有的一个引用
+     */
+    void put(const std::string& key, SSL_SESSION* session);
+
+    void remove(const std::string& key);
+
+    /**
+     * @brief 安装到 SSL_CTX 的 new_session 回调
+     */
+    static int onNewSession(SSL* ssl, SSL_SESSION* session);
+
+private:
+    TLSSessionCache() = default;
+    ~TLSSessionCache();
+
+    static const size_t MAX_SESSIONS = 1024;
+
+    std::mutex mutex;
+    std::map<std::string, SSL_SESSION*> sessions;
+    std::list<std::string> order;       ///< 插入顺序，超出容量时淘汰最早的会话
+};
+
+} // namespace ftp
+
+#endif // FTP_TLS_CONTEXT_H
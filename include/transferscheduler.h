@@ -0,0 +1,193 @@
+// Include Guards - transferscheduler.h
+#ifndef FTP_TRANSFER_SCHEDULER_H
+#define FTP_TRANSFER_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ftpclient.h"
+
+namespace ftp {
+
+/**
+ * @brief 传输任务调度器
+ *
+ * 接收上传、下载、目录同步等后台任务并返回任务 ID，由固定数量的线程执行，
+ * 同时运行的任务数受全局上限与每个 FTP 主机的上限约束。
+ * 就绪任务按优先级从高到低选取；优先级相同时先选正在运行任务最少的会话，
+ * 再按提交顺序，单个会话提交大量任务也不会占满所有执行线程。
+ *
+ * 每次执行任务时提供一个 TransferControl：取消或暂停正在运行的任务通过它中止传输，
+ * 被暂停的任务保留任务体，恢复后重新排队执行（任务体负责以续传方式继续）。
+ */
+class TransferScheduler {
+public:
+    using JobId = uint64_t;
+    using OwnerId = uint64_t;
+
+    /**
+     * @brief 任务状态
+     */
+    enum class JobState {
+        QUEUED,     ///< 等待执行
+        PAUSED,     ///< 已暂停，恢复后重新排队
+        RUNNING,    ///< 正在执行
+        SUCCEEDED,  ///< 执行成功
+        FAILED,     ///< 执行失败
+        CANCELLED   ///< 已取消
+    };
+
+    /**
+     * @brief 调度器配置
+     */
+    struct Options {
+        size_t maxConcurrent;       ///< 同时运行的任务总数上限（即执行线程数）
+        size_t maxPerHost;          ///< 每个 FTP 主机同时运行的任务数上限
+        size_t maxFinishedJobs;     ///< 保留供查询的已结束任务数上限
+
+        Options() : maxConcurrent(8), maxPerHost(4), maxFinishedJobs(1024) {}
+    };
+
+    /**
+     * @brief 任务信息快照
+     */
+    struct JobInfo {
+        JobId id;
+        OwnerId owner;          ///< 提交任务的会话
+        std::string type;       ///< 任务类型，例如 "upload"
+        std::string host;       ///< 限流所用的主机键
+        int priority;           ///< 优先级，越大越先执行
+        JobState state;
+        int64_t current;        ///< 已传输字节数
+        int64_t total;          ///< 总字节数，未知时为 -1
+        std::string error;      ///< 失败或取消的原因
+    };
+
+    /**
+     * @brief 任务体，在执行线程中调用；暂停后恢复时会再次调用
+     * @param control 本次执行的传输控制，任务体应将其交给 FTPClient
+     * @param error 失败时的错误信息
+     * @return 执行成功返回 true
+     */
+    using Work = std::function<bool(JobId id, const std::shared_ptr<TransferControl>& control,
+                                    std::string& error)>;
+
+    /**
+     * @brief 任务结束回调（成功、失败或取消），参数为最终状态
+     */
+    using DoneCallback = std::function<void(const JobInfo& info)>;
+
+    explicit TransferScheduler(const Options& options = Options());
+    ~TransferScheduler();
+
+    TransferScheduler(const TransferScheduler&) = delete;
+    TransferScheduler& operator=(const TransferScheduler&) = delete;
+
+    /**
+     * @brief 提交任务
+     * @return 任务 ID；调度器已停止时返回 0
+     */
+    JobId submit(OwnerId owner, const std::string& type, const std::string& host, int priority,
+                 Work work, DoneCallback onDone);
+
+    /**
+     * @brief 查询任务状态，任务不存在或不属于 owner 时返回 false
+     */
+    bool status(OwnerId owner, JobId id, JobInfo& info) const;
+
+    /**
+     * @brief 列出 owner 的全部任务（按提交顺序）
+     */
+    std::vector<JobInfo> list(OwnerId owner) const;
+
+    /**
+     * @brief 取消任务：未运行的任务立即取消，正在运行的任务中止传输后结束
+     * @param error 失败原因
+     */
+    bool cancel(OwnerId owner, JobId id, std::string& error);
+
+    /**
+     * @brief 暂停任务：排队中的任务不再被调度，正在运行的任务中止传输后进入暂停状态
+     */
+    bool pause(OwnerId owner, JobId id, std::string& error);
+
+    /**
+     * @brief 恢复已暂停的任务，重新排队
+     *
+     * 正在暂停（请求已发出、传输尚未停止）的任务在停止后直接重新排队，不进入 PAUSED 状态。
+     */
+    bool resume(OwnerId owner, JobId id, std::string& error);
+
+    /**
+     * @brief 更新任务的传输进度（任务体中调用）
+     */
+    void updateProgress(JobId id, int64_t current, int64_t total);
+
+    /**
+     * @brief 会话关闭：取消其全部任务（包括正在运行的）并丢弃任务记录，不再调用其回调
+     */
+    void removeOwner(OwnerId owner);
+
+    /**
+     * @brief 停止执行线程：中止正在执行的任务并等待其返回，未开始的任务被丢弃
+     *
+     * 可以在任务或完成回调中调用，此时不等待当前线程，当前线程在回调返回后退出；
+     * 但调度器对象不能在其执行线程中析构。
+     */
+    void shutdown();
+
+    size_t queuedCount() const;
+    size_t runningCount() const;
+
+private:
+    struct Job {
+        JobInfo info;
+        Work work;
+        DoneCallback onDone;
+        std::shared_ptr<TransferControl> control;   ///< 运行期间的传输控制
+        bool detached;      ///< 所属会话已关闭，结束后直接丢弃
+        bool resumed;       ///< 暂停请求生效前又被恢复，停止后重新排队
+    };
+
+    void workerLoop();
+
+    /**
+     * @brief 选出下一个可运行的任务，没有时返回 nullptr
+     */
+    std::shared_ptr<Job> pickLocked();
+    void finishLocked(const std::shared_ptr<Job>& job);
+    std::shared_ptr<Job> findLocked(OwnerId owner, JobId id) const;
+
+private:
+    Options options;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<JobId, std::shared_ptr<Job>> jobs;   ///< 全部未被清理的任务
+    std::map<JobId, std::shared_ptr<Job>> queued;           ///< 排队中的任务（按提交顺序）
+    std::deque<JobId> finished;                             ///< 已结束的任务（按结束顺序）
+    std::unordered_map<std::string, size_t> runningPerHost;
+    std::unordered_map<OwnerId, size_t> runningPerOwner;
+    std::vector<std::thread> workers;
+    JobId nextId;
+    size_t running;
+    bool stopping;
+};
+
+/**
+ * @brief 任务状态的名称，例如 "queued"
+ */
+const char* jobStateName(TransferScheduler::JobState state);
+
+} // namespace ftp
+
+#endif // FTP_TRANSFER_SCHEDULER_H
@@ -0,0 +1,680 @@
+/**
+ * @file asyncftpclient.cpp
+ * @brief 异步 FTP 客户端的实现文件
+ */
+
+#include "asyncftpclient.h"
+#include "localfile.h"
+#include <cstdio>
+#include <string_view>
+#include <filesystem>
+#include <system_error>
+
+namespace ftp {
+
+namespace {
+
+const size_t DATA_BUFFER_SIZE = 256 * 1024;     ///< 数据连接每次读写的最大字节数
+
+/**
+ * @brief 解析 "227 Entering Passive Mode (h1,h2,h3,h4,p1,p2)"
+ */
+bool parsePasvReply(const std::string& msg, asio::ip::tcp::endpoint& endpoint) {
+    size_t start = msg.find('(');
+    start = start == std::string::npos ? msg.find_first_of("0123456789") : start + 1;
+    if (start == std::string::npos) {
+        return false;
+    }
+
+    int n[6];
+    if (std::sscanf(msg.c_str() + start, "%d,%d,%d,%d,%d,%d",
+                    &n[0], &n[1], &n[2], &n[3], &n[4], &n[5]) != 6) {
+        return false;
+    }
+    for (int value : n) {
+        if (value < 0 || value > 255) {
+            return false;
+        }
+    }
+
+    asio::ip::address_v4::bytes_type bytes = {{
+        static_cast<unsigned char>(n[0]), static_cast<unsigned char>(n[1]),
+        static_cast<unsigned char>(n[2]), static_cast<unsigned char>(n[3])
+    }};
+    endpoint = asio::ip::tcp::endpoint(asio::ip::address_v4(bytes),
+                                       static_cast<unsigned short>(n[4] * 256 + n[5]));
+    return true;
+}
+
+/**
+ * @brief 解析 "229 Entering Extended Passive Mode (|||port|)" 中的端口
+ */
+bool parseEpsvReply(const std::string& msg, unsigned short& port) {
+    size_t start = msg.find('(');
+    if (start == std::string::npos || start + 4 >= msg.size()) {
+        return false;
+    }
+
+    char d = msg[start + 1];
+    unsigned int value = 0;
+    char tail[3] = {};
+    std::string format = std::string(3, d) + "%u%2c";
+    if (std::sscanf(msg.c_str() + start + 1, format.c_str(), &value, tail) != 2 ||
+        tail[0] != d || tail[1] != ')' || value == 0 || value > 65535) {
+        return false;
+    }
+    port = static_cast<unsigned short>(value);
+    return true;
+}
+
+int64_t parseSize(const FTPResponse& response) {
+    if (response.code != 213) {
+        return -1;
+    }
+    try {
+        return std::stoll(response.msg);
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+} // namespace
+
+/**
+ * @brief 一次目录列表的状态
+ */
+struct AsyncFTPClient::ListState {
+    ListingParser parser;
+    std::string pending;        ///< 跨越两次接收的不完整行
+    ListCallback onEntry;
+    CompletionHandler handler;
+
+    ListState(ListingParser::Format format, ListCallback onEntry, CompletionHandler handler) :
+        parser(format), onEntry(std::move(onEntry)), handler(std::move(handler)) {}
+};
+
+/**
+ * @brief 一次文件传输的状态
+ */
+struct AsyncFTPClient::TransferState {
+    LocalFile file;
+    int64_t offset;             ///< 本地文件中下一个读写位置
+    int64_t total;              ///< 文件总字节数
+    ProgressReporter reporter;
+    CompletionHandler handler;
+
+    TransferState(const ProgressCallback& progress, const ProgressOptions& options,
+                  int64_t total, int64_t start, CompletionHandler handler) :
+        offset(start), total(total), reporter(progress, options, total, start),
+        handler(std::move(handler)) {}
+};
+
+AsyncFTPClient::AsyncFTPClient(asio::io_context& io) :
+    strand(asio::make_strand(io)),
+    resolver(strand),
+    controlSocket(strand),
+    dataSocket(strand),
+    busy(false),
+    connected(false),
+    mlsdSupport(-1) {}
+
+AsyncFTPClient::~AsyncFTPClient() {
+    closeSockets();
+}
+
+void AsyncFTPClient::enqueue(Operation op, CompletionHandler onCancel) {
+    // 成员只在 strand 上访问，其他线程提交的操作先投递过去
+    auto self = shared_from_this();
+    asio::post(strand, [this, self, op = std::move(op), onCancel = std::move(onCancel)]() mutable {
+        operations.emplace_back(std::move(op), std::move(onCancel));
+        startNext();
+    });
+}
+
+void AsyncFTPClient::startNext() {
+    if (busy || operations.empty()) {
+        return;
+    }
+    busy = true;
+    Operation op = std::move(operations.front().first);
+    operations.pop_front();
+    op();
+}
+
+void AsyncFTPClient::complete(const CompletionHandler& handler, bool ok, const std::string& error) {
+    busy = false;
+    if (handler) {
+        handler(ok, error);
+    }
+    startNext();
+}
+
+void AsyncFTPClient::closeSockets() {
+    asio::error_code ignored;
+    resolver.cancel();
+    dataSocket.close(ignored);
+    controlSocket.close(ignored);
+    replyBuffer.clear();
+    connected = false;
+}
+
+void AsyncFTPClient::close() {
+    auto self = shared_from_this();
+    asio::post(strand, [this, self]() {
+        // 正在执行的操作会因套接字关闭而以错误结束
+        closeSockets();
+        auto pending = std::move(operations);
+        operations.clear();
+        for (auto& item : pending) {
+            if (item.second) {
+                item.second(false, "Connection closed");
+            }
+        }
+    });
+}
+
+void AsyncFTPClient::asyncWait(std::function<void(std::function<void()> done)> start) {
+    enqueue([this, start]() {
+        auto self = shared_from_this();
+        start([this, self]() {
+            asio::post(strand, [this, self]() {
+                complete(nullptr, true, "");
+            });
+        });
+    }, nullptr);
+}
+
+void AsyncFTPClient::setProgressOptions(const ProgressOptions& options) {
+    auto self = shared_from_this();
+    asio::post(strand, [this, self, options]() {
+        progressOptions = options;
+    });
+}
+
+void AsyncFTPClient::asyncConnect(const std::string& host, uint16_t port, CompletionHandler handler) {
+    enqueue([this, host, port, handler]() {
+        auto self = shared_from_this();
+        closeSockets();
+        mlsdSupport = -1;
+
+        resolver.async_resolve(host, std::to_string(port),
+            [this, self, handler](const auto& ec, const auto& results) {
+                if (ec) {
+                    complete(handler, false, "Failed to resolve host: " + ec.message());
+                    return;
+                }
+                asio::async_connect(controlSocket, results,
+                    [this, self, handler](const auto& ec, const auto&) {
+                        if (ec) {
+                            closeSockets();
+                            complete(handler, false, "Failed to connect to server: " + ec.message());
+                            return;
+                        }
+                        readReply([this, handler](const FTPResponse& response) {
+                            if (response.code != 220) {
+                                closeSockets();
+                                complete(handler, false, "Server rejected connection: " + response.msg);
+                                return;
+                            }
+                            connected = true;
+                            complete(handler, true, "");
+                        });
+                    });
+            });
+    }, handler);
+}
+
+void AsyncFTPClient::asyncLogin(const std::string& username, const std::string& password,
+                                CompletionHandler handler) {
+    enqueue([this, username, password, handler]() {
+        // 登录成功后切换到二进制传输
+        auto setBinary = [this, handler]() {
+            sendCommand("TYPE I", [this, handler](const FTPResponse& response) {
+                if (response.code != 200) {
+                    complete(handler, false, "Failed to set transfer type: " + response.msg);
+                    return;
+                }
+                complete(handler, true, "");
+            });
+        };
+
+        sendCommand("USER " + username, [this, password, handler, setBinary](const FTPResponse& response) {
+            if (response.code == 230) {
+                setBinary();
+                return;
+            }
+            if (response.code != 331) {
+                complete(handler, false, "Login failed: " + response.msg);
+                return;
+            }
+            sendCommand("PASS " + password, [this, handler, setBinary](const FTPResponse& response) {
+                if (response.code != 230) {
+                    complete(handler, false, "Login failed: " + response.msg);
+                    return;
+                }
+                setBinary();
+            });
+        });
+    }, handler);
+}
+
+void AsyncFTPClient::asyncList(const std::string& path, ListHandler handler) {
+    auto entries = std::make_shared<std::vector<FileEntry>>();
+    asyncList(path,
+        [entries](const FileEntry& entry) {
+            entries->push_back(entry);
+        },
+        [entries, handler](bool ok, const std::string& error) {
+            handler(ok, error, *entries);
+        });
+}
+
+void AsyncFTPClient::asyncList(const std::string& path, ListCallback onEntry, CompletionHandler handler) {
+    enqueue([this, path, onEntry, handler]() {
+        probeFeatures([this, path, onEntry, handler]() {
+            bool mlsd = mlsdSupport == 1;
+            auto state = std::make_shared<ListState>(
+                mlsd ? ListingParser::Format::MLSD : ListingParser::Format::LIST, onEntry, handler);
+
+            // 列表失败时以错误结束操作
+            auto fail = [this, state](const std::string& error) {
+                complete(state->handler, false, error);
+            };
+
+            openDataConnection([this, path, mlsd, state, fail](bool ok, const std::string& error) {
+                if (!ok) {
+                    fail(error);
+                    return;
+                }
+                std::string command = mlsd ? "MLSD" : "LIST";
+                if (!path.empty()) {
+                    command += " " + path;
+                }
+                startTransfer(command, 0, [this, state, fail](bool ok, const std::string& error) {
+                    if (!ok) {
+                        fail(error);
+                        return;
+                    }
+                    readListing(state);
+                });
+            });
+        });
+    }, handler);
+}
+
+void AsyncFTPClient::asyncDownload(const std::string& remotePath, const std::string& localPath,
+                                   bool resume, ProgressCallback progress, CompletionHandler handler) {
+    enqueue([this, remotePath, localPath, resume, progress, handler]() {
+        sendCommand("SIZE " + remotePath,
+            [this, remotePath, localPath, resume, progress, handler](const FTPResponse& response) {
+                int64_t fileSize = parseSize(response);
+                if (fileSize < 0) {
+                    complete(handler, false, "Failed to get file size: " + response.msg);
+                    return;
+                }
+
+                // 续传位置取本地已有文件的大小
+                int64_t startPos = 0;
+                if (resume) {
+                    std::error_code ec;
+                    auto localSize = std::filesystem::file_size(localPath, ec);
+                    if (!ec) {
+                        startPos = static_cast<int64_t>(localSize);
+                    }
+                }
+
+                auto state = std::make_shared<TransferState>(progress, progressOptions,
+                                                             fileSize, startPos, handler);
+                if (resume && startPos >= fileSize) {
+                    state->reporter.finish(fileSize);
+                    complete(handler, true, "");    // 文件已完全下载
+                    return;
+                }
+
+                if (!state->file.open(localPath, resume ? LocalFile::Mode::READ_WRITE
+                                                        : LocalFile::Mode::WRITE)) {
+                    complete(handler, false, "Cannot open local file: " + localPath);
+                    return;
+                }
+                state->file.preallocate(fileSize);
+
+                openDataConnection([this, remotePath, startPos, state](bool ok, const std::string& error) {
+                    if (!ok) {
+                        complete(state->handler, false, error);
+                        return;
+                    }
+                    startTransfer("RETR " + remotePath, startPos,
+                        [this, state](bool ok, const std::string& error) {
+                            if (!ok) {
+                                complete(state->handler, false, error);
+                                return;
+                            }
+                            receiveFile(state);
+                        });
+                });
+            });
+    }, handler);
+}
+
+void AsyncFTPClient::asyncUpload(const std::string& localPath, const std::string& remotePath,
+                                 bool resume, ProgressCallback progress, CompletionHandler handler) {
+    enqueue([this, localPath, remotePath, resume, progress, handler]() {
+        auto begin = [this, localPath, remotePath, progress, handler](int64_t startPos) {
+            std::error_code ec;
+            auto fileSize = std::filesystem::file_size(localPath, ec);
+            auto state = std::make_shared<TransferState>(progress, progressOptions,
+                                                         ec ? 0 : static_cast<int64_t>(fileSize),
+                                                         startPos, handler);
+            if (ec || !state->file.open(localPath, LocalFile::Mode::READ)) {
+                complete(handler, false, "Cannot open local file: " + localPath);
+                return;
+            }
+
+            openDataConnection([this, remotePath, startPos, state](bool ok, const std::string& error) {
+                if (!ok) {
+                    complete(state->handler, false, error);
+                    return;
+                }
+                startTransfer("STOR " + remotePath, startPos,
+                    [this, state](bool ok, const std::string& error) {
+                        if (!ok) {
+                            complete(state->handler, false, error);
+                            return;
+                        }
+                        sendFile(state);
+                    });
+            });
+        };
+
+        if (!resume) {
+            begin(0);
+            return;
+        }
+        // 续传时从远程文件的大小处继续，远程文件不存在时从头上传
+        sendCommand("SIZE " + remotePath, [begin](const FTPResponse& response) {
+            begin(std::max<int64_t>(parseSize(response), 0));
+        });
+    }, handler);
+}
+
+void AsyncFTPClient::sendCommand(const std::string& command, ReplyHandler onReply) {
+    if (!connected) {
+        onReply(FTPResponse{0, "Not connected"});
+        return;
+    }
+
+    // 同一时刻只有一条命令在发送，缓冲区在写完成前保持不变
+    writeBuffer = command + "\r\n";
+    auto self = shared_from_this();
+    asio::async_write(controlSocket, asio::buffer(writeBuffer),
+        [this, self, onReply](const auto& ec, std::size_t) {
+            if (ec) {
+                closeSockets();
+                onReply(FTPResponse{0, "Failed to send command: " + ec.message()});
+                return;
+            }
+            readReply(onReply);
+        });
+}
+
+void AsyncFTPClient::readReply(ReplyHandler onReply) {
+    int code;
+    std::string_view text;
+    if (replyBuffer.next(code, text)) {
+        FTPResponse response;
+        response.code = code;
+        response.msg = code == 0 ? "Malformed server reply: " + std::string(text) : std::string(text);
+        onReply(response);
+        return;
+    }
+
+    size_t available;
+    char* buffer = replyBuffer.prepare(available);
+    if (!buffer) {
+        closeSockets();
+        onReply(FTPResponse{0, "Server reply too long"});
+        return;
+    }
+
+    auto self = shared_from_this();
+    controlSocket.async_read_some(asio::buffer(buffer, available),
+        [this, self, onReply](const auto& ec, std::size_t received) {
+            if (ec) {
+                std::string error = ec == asio::error::eof ? "Connection closed by server" : ec.message();
+                closeSockets();
+                onReply(FTPResponse{0, error});
+                return;
+            }
+            replyBuffer.commit(received);
+            readReply(onReply);
+        });
+}
+
+void AsyncFTPClient::probeFeatures(std::function<void()> next) {
+    if (mlsdSupport >= 0) {
+        next();
+        return;
+    }
+
+    mlsdSupport = 0;
+    sendCommand("FEAT", [this, next](const FTPResponse& response) {
+        if (response.code == 211) {
+            // 多行响应，每行一个特性，例如 " MLST type*;size*;modify*;"
+            size_t pos = 0;
+            while (pos < response.msg.size()) {
+                size_t eol = response.msg.find('\n', pos);
+                size_t end = eol == std::string::npos ? response.msg.size() : eol;
+                size_t start = response.msg.find_first_not_of(' ', pos);
+                if (start < end && (response.msg.compare(start, 4, "MLST") == 0 ||
+                                    response.msg.compare(start, 4, "MLSD") == 0)) {
+                    mlsdSupport = 1;
+                    break;
+                }
+                pos = end + 1;
+            }
+        }
+        next();
+    });
+}
+
+void AsyncFTPClient::openDataConnection(CompletionHandler onOpen) {
+    // IPv6 控制连接只能使用 EPSV，数据连接连向控制连接的对端地址
+    asio::error_code error;
+    asio::ip::tcp::endpoint peer = controlSocket.remote_endpoint(error);
+    bool extended = !error && peer.address().is_v6();
+
+    sendCommand(extended ? "EPSV" : "PASV", [this, onOpen, extended, peer](const FTPResponse& response) {
+        asio::ip::tcp::endpoint endpoint;
+        if (extended) {
+            unsigned short port = 0;
+            if (response.code != 229) {
+                onOpen(false, "Failed to enter extended passive mode: " + response.msg);
+                return;
+            }
+            if (!parseEpsvReply(response.msg, port)) {
+                onOpen(false, "Invalid EPSV response format");
+                return;
+            }
+            endpoint = asio::ip::tcp::endpoint(peer.address(), port);
+        } else {
+            if (response.code != 227) {
+                onOpen(false, "Failed to enter passive mode: " + response.msg);
+                return;
+            }
+            if (!parsePasvReply(response.msg, endpoint)) {
+                onOpen(false, "Invalid PASV response format");
+                return;
+            }
+        }
+
+        asio::error_code ignored;
+        dataSocket.close(ignored);
+        auto self = shared_from_this();
+        dataSocket.async_connect(endpoint, [this, self, onOpen](const auto& ec) {
+            if (ec) {
+                onOpen(false, "Failed to connect to data port: " + ec.message());
+                return;
+            }
+            onOpen(true, "");
+        });
+    });
+}
+
+void AsyncFTPClient::startTransfer(const std::string& command, int64_t restPos,
+                                   CompletionHandler onStarted) {
+    auto send = [this, command, onStarted]() {
+        sendCommand(command, [this, onStarted](const FTPResponse& response) {
+            if (response.code != 150 && response.code != 125) {
+                asio::error_code ignored;
+                dataSocket.close(ignored);
+                onStarted(false, "Failed to initiate file transfer: " + response.msg);
+                return;
+            }
+            onStarted(true, "");
+        });
+    };
+
+    if (restPos <= 0) {
+        send();
+        return;
+    }
+    sendCommand("REST " + std::to_string(restPos), [this, send, onStarted](const FTPResponse& response) {
+        if (response.code != 350) {
+            asio::error_code ignored;
+            dataSocket.close(ignored);
+            onStarted(false, "Failed to set file position: " + response.msg);
+            return;
+        }
+        send();
+    });
+}
+
+void AsyncFTPClient::readListing(const std::shared_ptr<ListState>& state) {
+    dataBuffer.resize(DATA_BUFFER_SIZE);
+    auto self = shared_from_this();
+    dataSocket.async_read_some(asio::buffer(dataBuffer),
+        [this, self, state](const auto& ec, std::size_t received) {
+            auto emit = [&state](std::string_view line) {
+                if (!line.empty() && line.back() == '\r') {
+                    line.remove_suffix(1);
+                }
+                FileEntry entry;
+                if (state->parser.parseLine(line, entry)) {
+                    state->onEntry(entry);
+                }
+            };
+
+            if (!ec) {
+                // 按行切分，不完整的行留到下次接收
+                std::string_view chunk(dataBuffer.data(), received);
+                size_t start = 0;
+                size_t eol;
+                while ((eol = chunk.find('\n', start)) != std::string_view::npos) {
+                    if (state->pending.empty()) {
+                        emit(chunk.substr(start, eol - start));
+                    } else {
+                        state->pending.append(chunk.data() + start, eol - start);
+                        emit(state->pending);
+                        state->pending.clear();
+                    }
+                    start = eol + 1;
+                }
+                state->pending.append(chunk.data() + start, chunk.size() - start);
+                readListing(state);
+                return;
+            }
+
+            bool dataOk = ec == asio::error::eof;
+            if (dataOk && !state->pending.empty()) {
+                emit(state->pending);
+            }
+            asio::error_code ignored;
+            dataSocket.close(ignored);
+
+            std::string dataError = dataOk ? "" : "Failed to receive listing: " + ec.message();
+            readReply([this, state, dataOk, dataError](const FTPResponse& response) {
+                if (!dataOk) {
+                    complete(state->handler, false, dataError);
+                } else if (response.code != 226 && response.code != 250) {
+                    complete(state->handler, false, "Failed to list directory: " + response.msg);
+                } else {
+                    complete(state->handler, true, "");
+                }
+            });
+        });
+}
+
+void AsyncFTPClient::receiveFile(const std::shared_ptr<TransferState>& state) {
+    dataBuffer.resize(DATA_BUFFER_SIZE);
+    auto self = shared_from_this();
+    dataSocket.async_read_some(asio::buffer(dataBuffer),
+        [this, self, state](const auto& ec, std::size_t received) {
+            if (ec) {
+                if (ec == asio::error::eof) {
+                    finishTransfer(state, true, "");
+                } else {
+                    finishTransfer(state, false, "Failed to receive data: " + ec.message());
+                }
+                return;
+            }
+
+            if (!state->file.writeAt(state->offset, dataBuffer.data(), received)) {
+                finishTransfer(state, false, "Failed to write to local file");
+                return;
+            }
+            state->offset += static_cast<int64_t>(received);
+            state->reporter.update(state->offset);
+            receiveFile(state);
+        });
+}
+
+void AsyncFTPClient::sendFile(const std::shared_ptr<TransferState>& state) {
+    dataBuffer.resize(DATA_BUFFER_SIZE);
+    int64_t read = state->file.readAt(state->offset, dataBuffer.data(), dataBuffer.size());
+    if (read < 0) {
+        finishTransfer(state, false, "Failed to read local file");
+        return;
+    }
+    if (read == 0) {
+        // 关闭数据连接表示文件结束
+        asio::error_code ignored;
+        dataSocket.shutdown(asio::ip::tcp::socket::shutdown_send, ignored);
+        finishTransfer(state, true, "");
+        return;
+    }
+
+    auto self = shared_from_this();
+    asio::async_write(dataSocket, asio::buffer(dataBuffer.data(), static_cast<size_t>(read)),
+        [this, self, state](const auto& ec, std::size_t sent) {
+            if (ec) {
+                finishTransfer(state, false, "Failed to send data: " + ec.message());
+                return;
+            }
+            state->offset += static_cast<int64_t>(sent);
+            state->reporter.update(state->offset);
+            sendFile(state);
+        });
+}
+
+void AsyncFTPClient::finishTransfer(const std::shared_ptr<TransferState>& state, bool dataOk,
+                                    const std::string& error) {
+    asio::error_code ignored;
+    dataSocket.close(ignored);
+    state->file.close();
+
+    // 读取传输结果；数据连接出错时服务器通常回复 426，同样需要读取以保持同步
+    readReply([this, state, dataOk, error](const FTPResponse& response) {
+        if (!dataOk) {
+            complete(state->handler, false, error);
+            return;
+        }
+        if (response.code != 226 && response.code != 250) {
+            complete(state->handler, false, "File transfer failed: " + response.msg);
+            return;
+        }
+        state->reporter.finish(state->offset);
+        complete(state->handler, true, "");
+    });
+}
+
+} // namespace ftp
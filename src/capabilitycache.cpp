@@ -0,0 +1,90 @@
+/**
+ * @file capabilitycache.cpp
+ * @brief 服务器能力缓存的实现文件
+ */
+
+#include "capabilitycache.h"
+#include <algorithm>
+
+namespace ftp {
+
+constexpr std::chrono::minutes CapabilityCache::TTL;
+
+const std::string* ServerCapabilities::find(const std::string& name) const {
+    // 特性名后为行尾或参数，例如 "MODE Z"、"MLST type*;size*;"
+    for (const auto& feature : features) {
+        if (feature.size() >= name.size() &&
+            feature.compare(0, name.size(), name) == 0 &&
+            (feature.size() == name.size() || feature[name.size()] == ' ')) {
+            return &feature;
+        }
+    }
+    return nullptr;
+}
+
+CapabilityCache& CapabilityCache::instance() {
+    static CapabilityCache cache;
+    return cache;
+}
+
+std::string CapabilityCache::makeKey(const std::string& host, uint16_t port,
+                                     const std::string& user, bool secure) {
+    // 同一服务器对不同用户、明文与 TLS 连接可能声明不同的特性
+    return host + ":" + std::to_string(port) + "\n" + user + (secure ? "\ntls" : "\nplain");
+}
+
+bool CapabilityCache::get(const std::string& key, ServerCapabilities& capabilities) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return false;
+    }
+    if (std::chrono::steady_clock::now() - it->second.stored > TTL) {
+        entries.erase(it);
+        order.erase(std::find(order.begin(), order.end(), key));
+        return false;
+    }
+    capabilities = it->second.capabilities;
+    return true;
+}
+
+void CapabilityCache::put(const std::string& key, const ServerCapabilities& capabilities) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        // 重新写入的条目按最新写入计算有效期与淘汰顺序
+        it->second.capabilities = capabilities;
+        it->second.stored = std::chrono::steady_clock::now();
+        auto pos = std::find(order.begin(), order.end(), key);
+        if (pos != order.end()) {
+            order.splice(order.end(), order, pos);
+        }
+        return;
+    }
+
+    if (entries.size() >= MAX_ENTRIES && !order.empty()) {
+        entries.erase(order.front());
+        order.pop_front();
+    }
+
+    entries[key] = {capabilities, std::chrono::steady_clock::now()};
+    order.push_back(key);
+}
+
+void CapabilityCache::remove(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.erase(key) > 0) {
+        auto pos = std::find(order.begin(), order.end(), key);
+        if (pos != order.end()) {
+            order.erase(pos);
+        }
+    }
+}
+
+void CapabilityCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    order.clear();
+}
+
+} // namespace ftp
@@ -0,0 +1,133 @@
+/**
+ * @file checksum.cpp
+ * @brief 增量校验值计算的实现文件
+ */
+
+#include "checksum.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+
+#include <zlib.h>
+
+namespace ftp {
+
+namespace {
+
+const EVP_MD* digestOf(HashAlgorithm algorithm) {
+    switch (algorithm) {
+        case HashAlgorithm::MD5:    return EVP_md5();
+        case HashAlgorithm::SHA1:   return EVP_sha1();
+        case HashAlgorithm::SHA256: return EVP_sha256();
+        default:                    return nullptr;
+    }
+}
+
+} // namespace
+
+const char* hashAlgorithmName(HashAlgorithm algorithm) {
+    switch (algorithm) {
+        case HashAlgorithm::CRC32:  return "CRC32";
+        case HashAlgorithm::MD5:    return "MD5";
+        case HashAlgorithm::SHA1:   return "SHA-1";
+        case HashAlgorithm::SHA256: return "SHA-256";
+    }
+    return "";
+}
+
+bool parseHashAlgorithm(const std::string& name, HashAlgorithm& algorithm) {
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) {
+        return static_cast<char>(std::toupper(c));
+    });
+
+    for (HashAlgorithm candidate : {HashAlgorithm::CRC32, HashAlgorithm::MD5,
+                                    HashAlgorithm::SHA1, HashAlgorithm::SHA256}) {
+        if (upper == hashAlgorithmName(candidate)) {
+            algorithm = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+Hasher::Hasher(HashAlgorithm algorithm) :
+    algo(algorithm),
+    context(nullptr),
+    crc(0) {
+
+    if (algo != HashAlgorithm::CRC32) {
+        context = EVP_MD_CTX_new();
+        if (context && EVP_DigestInit_ex(context, digestOf(algo), nullptr) != 1) {
+            EVP_MD_CTX_free(context);
+            context = nullptr;
+        }
+    }
+}
+
+Hasher::~Hasher() {
+    if (context) {
+        EVP_MD_CTX_free(context);
+    }
+}
+
+void Hasher::update(const void* data, size_t size) {
+    if (algo != HashAlgorithm::CRC32) {
+        if (context) {
+            EVP_DigestUpdate(context, data, size);
+        }
+        return;
+    }
+
+    // zlib 的长度参数为 uInt，超长数据分块计算
+    const Bytef* bytes = static_cast<const Bytef*>(data);
+    uLong value = crc;
+    while (size > 0) {
+        uInt chunk = static_cast<uInt>(std::min<size_t>(size, UINT_MAX));
+        value = crc32(value, bytes, chunk);
+        bytes += chunk;
+        size -= chunk;
+    }
+    crc = static_cast<uint32_t>(value);
+}
+
+std::string Hasher::digest() const {
+    if (algo == HashAlgorithm::CRC32) {
+        char hex[9];
+        std::snprintf(hex, sizeof(hex), "%08x", static_cast<unsigned>(crc));
+        return hex;
+    }
+    if (!context) {
+        return "";
+    }
+
+    // 在副本上结束计算，原状态可以继续 update
+    EVP_MD_CTX* copy = EVP_MD_CTX_new();
+    unsigned char value[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    bool ok = copy && EVP_MD_CTX_copy_ex(copy, context) == 1 &&
+              EVP_DigestFinal_ex(copy, value, &length) == 1;
+    EVP_MD_CTX_free(copy);
+    if (!ok) {
+        return "";
+    }
+
+    static const char DIGITS[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(length * 2);
+    for (unsigned int i = 0; i < length; ++i) {
+        hex.push_back(DIGITS[value[i] >> 4]);
+        hex.push_back(DIGITS[value[i] & 0x0f]);
+    }
+    return hex;
+}
+
+void Hasher::reset() {
+    crc = 0;
+    if (context) {
+        EVP_DigestInit_ex(context, digestOf(algo), nullptr);
+    }
+}
+
+} // namespace ftp
@@ -0,0 +1,189 @@
+/**
+ * @file compression.cpp
+ * @brief MODE Z 流式压缩与解压的实现文件
+ */
+
+#include "compression.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace ftp {
+
+namespace {
+
+const size_t ZLIB_BUFFER_SIZE = 256 * 1024;     ///< 压缩/解压输出缓冲区大小
+const size_t PROBE_SIZE = 64 * 1024;            ///< isCompressible 最多试压缩的字节数
+
+} // namespace
+
+Deflater::Deflater(int level) :
+    initialized(false),
+    storedMode(false),
+    bytesIn(0),
+    bytesOut(0),
+    buffer(ZLIB_BUFFER_SIZE) {
+
+    std::memset(&stream, 0, sizeof(stream));
+    level = std::min(std::max(level, 1), 9);
+    initialized = deflateInit(&stream, level) == Z_OK;
+}
+
+Deflater::~Deflater() {
+    if (initialized) {
+        deflateEnd(&stream);
+    }
+}
+
+bool Deflater::write(const char* data, size_t size, bool finish, const CompressOutput& output) {
+    if (!initialized) {
+        return false;
+    }
+
+    // 数据不可压缩时改为存储块，压缩流格式不变
+    if (!storedMode && bytesIn >= SAMPLE_SIZE &&
+        static_cast<double>(bytesOut) > static_cast<double>(bytesIn) * (1.0 - MIN_SAVING)) {
+        storedMode = true;
+        stream.next_in = nullptr;
+        stream.avail_in = 0;
+        while (true) {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+            stream.avail_out = static_cast<uInt>(buffer.size());
+            int ret = deflateParams(&stream, Z_NO_COMPRESSION, Z_DEFAULT_STRATEGY);
+            size_t have = buffer.size() - stream.avail_out;
+            if (have > 0) {
+                bytesOut += have;
+                if (!output(buffer.data(), have)) {
+                    return false;
+                }
+            }
+            if (ret != Z_BUF_ERROR || have == 0) {
+                break;
+            }
+        }
+    }
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+    bytesIn += size;
+    return drain(finish ? Z_FINISH : Z_NO_FLUSH, output);
+}
+
+bool Deflater::drain(int flush, const CompressOutput& output) {
+    while (true) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+        stream.avail_out = static_cast<uInt>(buffer.size());
+        int ret = deflate(&stream, flush);
+        if (ret == Z_STREAM_ERROR) {
+            return false;
+        }
+
+        size_t have = buffer.size() - stream.avail_out;
+        if (have > 0) {
+            bytesOut += have;
+            if (!output(buffer.data(), have)) {
+                return false;
+            }
+        }
+
+        if (flush == Z_FINISH) {
+            if (ret == Z_STREAM_END) {
+                return true;
+            }
+            if (ret == Z_BUF_ERROR && have == 0) {
+                return false;
+            }
+        } else if (stream.avail_out != 0) {
+            return true;    // 输入已全部消耗
+        }
+    }
+}
+
+Inflater::Inflater() :
+    initialized(false),
+    streamEnd(false),
+    buffer(ZLIB_BUFFER_SIZE) {
+
+    std::memset(&stream, 0, sizeof(stream));
+    initialized = inflateInit(&stream) == Z_OK;
+}
+
+Inflater::~Inflater() {
+    if (initialized) {
+        inflateEnd(&stream);
+    }
+}
+
+bool Inflater::write(const char* data, size_t size, const CompressOutput& output) {
+    if (!initialized) {
+        lastError = "Failed to initialize decompression";
+        return false;
+    }
+    if (streamEnd) {
+        return true;
+    }
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+
+    while (true) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+        stream.avail_out = static_cast<uInt>(buffer.size());
+        int ret = inflate(&stream, Z_NO_FLUSH);
+        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+            lastError = std::string("Invalid compressed data: ") + (stream.msg ? stream.msg : "unknown error");
+            return false;
+        }
+
+        size_t have = buffer.size() - stream.avail_out;
+        if (have > 0 && !output(buffer.data(), have)) {
+            return false;
+        }
+
+        if (ret == Z_STREAM_END) {
+            streamEnd = true;
+            return true;
+        }
+        // 输出缓冲区未写满说明输入已全部消耗
+        if (ret == Z_BUF_ERROR || stream.avail_out != 0) {
+            return true;
+        }
+    }
+}
+
+bool isCompressible(const char* data, size_t size) {
+    size = std::min(size, PROBE_SIZE);
+    if (size < 512) {
+        return true;    // 数据太少无从判断，压缩的额外开销也可以忽略
+    }
+
+    uLongf outSize = compressBound(static_cast<uLong>(size));
+    std::vector<Bytef> out(outSize);
+    if (compress2(out.data(), &outSize, reinterpret_cast<const Bytef*>(data),
+                  static_cast<uLong>(size), 1) != Z_OK) {
+        return false;
+    }
+    return static_cast<double>(outSize) <= static_cast<double>(size) * (1.0 - Deflater::MIN_SAVING);
+}
+
+bool hasCompressedExtension(const std::string& path) {
+    static const char* const EXTENSIONS[] = {
+        "gz", "tgz", "bz2", "xz", "zst", "lz4", "zip", "7z", "rar", "jar", "apk",
+        "docx", "xlsx", "pptx", "jpg", "jpeg", "png", "gif", "webp", "heic",
+        "mp3", "aac", "ogg", "flac", "mp4", "mkv", "avi", "mov", "webm"
+    };
+
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return false;
+    }
+
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return std::find(std::begin(EXTENSIONS), std::end(EXTENSIONS), ext) != std::end(EXTENSIONS);
+}
+
+} // namespace ftp
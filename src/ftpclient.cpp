@@ -4,833 +4,3330 @@
  */
 
 #include "ftpclient.h"
+#include "localfile.h"
+#include "tlscontext.h"
+#include "compression.h"
+#include "checksum.h"
+#include "capabilitycache.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <climits>
 #include <system_error>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <map>
+#include <filesystem>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+    #include <sys/utime.h>
+#else
+    #include <utime.h>
+    #include <poll.h>
+    #include <netinet/tcp.h>
+    #include <fcntl.h>
+    #include <cerrno>
+#endif
+
+#ifdef __linux__
+    #include <sys/sendfile.h>
+    #include <fcntl.h>
+    #include <cerrno>
+#endif
 
 namespace ftp {
 
-bool FTPClient::networkInit = false;
+namespace {
 
-FTPClient::FTPClient() : 
-    controlSocket(INVALID_SOCKET),
-    transferMode(TransferMode::PASSIVE),
-    transferType(TransferType::BINARY) {
-    
-    if (!networkInit) {
-        networkInit = initNetwork();
+/**
+ * @brief 分段下载中的一个字节区间 [start, end)
+ */
+struct Segment {
+    int64_t start;
+    int64_t end;
+    int64_t done;       ///< 已从 start 开始连续写入的字节数
+};
+
+const int64_t MIN_SEGMENT_SIZE = 1024 * 1024;               ///< 单个分段的最小长度
+const int64_t SEGMENT_SAVE_INTERVAL = 4 * 1024 * 1024;      ///< 每下载多少字节保存一次分段表
+const size_t PIPELINE_WINDOW = 32;                          ///< 流水线中同时等待响应的最大命令数
+const int PIPELINE_PROBE_TIMEOUT_MS = 3000;                 ///< 流水线探测等待每条响应的超时时间
+
+/**
+ * @brief ABOR 之后等待服务器可能发出的第二条响应的时间（毫秒）
+ */
+const int ABORT_REPLY_TIMEOUT_MS = 1000;
+
+/**
+ * @brief 关闭 socket 的收发方向，唤醒阻塞在其上的 recv/send（不释放描述符）
+ */
+void shutdownSocket(SOCKET socket) {
+#ifdef _WIN32
+    shutdown(socket, SD_BOTH);
+#else
+    shutdown(socket, SHUT_RDWR);
+#endif
+}
+
+/**
+ * @brief Happy Eyeballs 中前一个连接尝试未完成时，发起下一个尝试前等待的时间（RFC 8305 建议 250 毫秒）
+ */
+const int CONNECT_ATTEMPT_DELAY_MS = 250;
+
+bool setNonBlocking(SOCKET socket, bool enabled) {
+#ifdef _WIN32
+    u_long mode = enabled ? 1 : 0;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags < 0) {
+        return false;
     }
-    
-    // 初始化OpenSSL
-    SSL_library_init();
-    SSL_load_error_strings();
-    OpenSSL_add_all_algorithms();
+    flags = enabled ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(socket, F_SETFL, flags) == 0;
+#endif
 }
 
-FTPClient::~FTPClient() {
-    disconnect();
+int pollSockets(pollfd* fds, size_t count, int timeoutMs) {
+#ifdef _WIN32
+    return WSAPoll(fds, static_cast<ULONG>(count), timeoutMs);
+#else
+    return poll(fds, static_cast<nfds_t>(count), timeoutMs);
+#endif
 }
 
-bool FTPClient::initNetwork() {
+/**
+ * @brief 不等待地检查是否还能立即读到数据（包括 OpenSSL 内部尚未处理的字节与对端关闭）
+ */
+bool dataAvailable(SOCKET socket, SSL* tls) {
+    if (tls && SSL_has_pending(tls)) {
+        return true;
+    }
+    pollfd fd = {};
+    fd.fd = socket;
+    fd.events = POLLIN;
+    return pollSockets(&fd, 1, 0) > 0;
+}
+
+/**
+ * @brief 非阻塞 connect 是否仍在进行中
+ */
+bool connectInProgress() {
 #ifdef _WIN32
-    WSADATA wsaData;
-    return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS;
+#endif
+}
+
+/**
+ * @brief 非阻塞 socket 的读写是否因数据未就绪而返回
+ */
+bool socketWouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+bool socketInterrupted() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEINTR;
+#else
+    return errno == EINTR;
+#endif
+}
+
+std::string socketErrorString() {
+#ifdef _WIN32
+    return "socket error " + std::to_string(WSAGetLastError());
+#else
+    return std::strerror(errno);
+#endif
+}
+
+std::string sslErrorString() {
+    char errBuf[256];
+    ERR_error_string_n(ERR_get_error(), errBuf, sizeof(errBuf));
+    return errBuf;
+}
+
+/**
+ * @brief 距 deadline 的剩余毫秒数（向上取整），deadline 为 max 时返回 -1（不限）
+ */
+int remainingMs(std::chrono::steady_clock::time_point deadline) {
+    if (deadline == std::chrono::steady_clock::time_point::max()) {
+        return -1;
+    }
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    return static_cast<int>(std::min<int64_t>(std::max<int64_t>(remaining, 0), INT_MAX));
+}
+
+std::chrono::steady_clock::time_point deadlineAfter(int timeoutMs) {
+    if (timeoutMs <= 0) {
+        return std::chrono::steady_clock::time_point::max();
+    }
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+}
+
+/**
+ * @brief 按 SocketOptions 设置 socket 选项
+ *
+ * 在 connect/listen 之前调用：接收缓冲区大小决定 TCP 握手时协商的窗口缩放因子。
+ * 各选项尽力设置，失败（例如内核未加载指定的拥塞控制算法）时保持系统默认。
+ * @param control 为 true 时只设置控制连接相关的选项
+ */
+void applySocketOptions(SOCKET socket, const FTPClient::SocketOptions& options, bool control) {
+    const int on = 1;
+    if (options.keepAlive) {
+        setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE, reinterpret_cast<const char*>(&on), sizeof(on));
+#ifdef TCP_KEEPIDLE
+        if (options.keepAliveIdle > 0) {
+            setsockopt(socket, IPPROTO_TCP, TCP_KEEPIDLE,
+                       reinterpret_cast<const char*>(&options.keepAliveIdle), sizeof(int));
+        }
+#endif
+#ifdef TCP_KEEPINTVL
+        if (options.keepAliveInterval > 0) {
+            setsockopt(socket, IPPROTO_TCP, TCP_KEEPINTVL,
+                       reinterpret_cast<const char*>(&options.keepAliveInterval), sizeof(int));
+        }
+#endif
+    }
+
+    if (control) {
+        if (options.controlNoDelay) {
+            setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&on), sizeof(on));
+        }
+        return;
+    }
+
+    // 显式设置缓冲区大小会关闭系统的自动调整，只在高带宽时延积链路上按需设置
+    if (options.sendBuffer > 0) {
+        setsockopt(socket, SOL_SOCKET, SO_SNDBUF,
+                   reinterpret_cast<const char*>(&options.sendBuffer), sizeof(int));
+    }
+    if (options.receiveBuffer > 0) {
+        setsockopt(socket, SOL_SOCKET, SO_RCVBUF,
+                   reinterpret_cast<const char*>(&options.receiveBuffer), sizeof(int));
+    }
+#ifdef TCP_CONGESTION
+    if (!options.congestion.empty()) {
+        setsockopt(socket, IPPROTO_TCP, TCP_CONGESTION, options.congestion.c_str(),
+                   static_cast<socklen_t>(options.congestion.size()));
+    }
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+    // 限制发送缓冲区中尚未发出的数据量，减少大缓冲区带来的排队延迟
+    if (options.notSentLowat > 0) {
+        setsockopt(socket, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+                   reinterpret_cast<const char*>(&options.notSentLowat), sizeof(int));
+    }
+#endif
+}
+
+/**
+ * @brief 以 Happy Eyeballs（RFC 8305）方式连接服务器
+ *
+ * 解析出的地址按 IPv6/IPv4 交替排列（以 getaddrinfo 排在最前的地址族开始），
+ * 前一个尝试在 CONNECT_ATTEMPT_DELAY_MS 内未完成时并行发起下一个，失败时立即发起下一个，
+ * 取最先建立的连接，其余尝试关闭。不可达的首个地址不会耗费完整的 TCP 超时。
+ * @param timeoutMs 全部尝试的总时长，0 表示不限
+ * @param options 控制连接的 socket 选项
+ * @return 已连接的非阻塞 socket，失败返回 INVALID_SOCKET 并设置 error
+ */
+SOCKET connectHappyEyeballs(const std::string& host, uint16_t port, int timeoutMs,
+                            const FTPClient::SocketOptions& options, std::string& error) {
+    struct addrinfo hints = {}, *result = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result) {
+        error = "Failed to resolve host address";
+        return INVALID_SOCKET;
+    }
+
+    // 两个地址族交替排列
+    std::vector<const addrinfo*> primary, secondary;
+    for (const addrinfo* ai = result; ai; ai = ai->ai_next) {
+        (ai->ai_family == result->ai_family ? primary : secondary).push_back(ai);
+    }
+    std::vector<const addrinfo*> candidates;
+    for (size_t i = 0; i < std::max(primary.size(), secondary.size()); ++i) {
+        if (i < primary.size()) {
+            candidates.push_back(primary[i]);
+        }
+        if (i < secondary.size()) {
+            candidates.push_back(secondary[i]);
+        }
+    }
+
+    std::vector<SOCKET> pending;
+    SOCKET connected = INVALID_SOCKET;
+    size_t next = 0;
+    bool timedOut = false;
+    auto nextAttempt = std::chrono::steady_clock::now();
+    auto deadline = deadlineAfter(timeoutMs);
+
+    while (connected == INVALID_SOCKET) {
+        if (remainingMs(deadline) == 0) {
+            timedOut = true;
+            break;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (next < candidates.size() && now >= nextAttempt) {
+            const addrinfo* ai = candidates[next++];
+            SOCKET attempt = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (attempt == INVALID_SOCKET) {
+                continue;
+            }
+            if (!setNonBlocking(attempt, true)) {
+                closesocket(attempt);
+                continue;
+            }
+            applySocketOptions(attempt, options, true);
+            if (::connect(attempt, ai->ai_addr, static_cast<int>(ai->ai_addrlen)) == 0) {
+                connected = attempt;
+                break;
+            }
+            if (!connectInProgress()) {
+                closesocket(attempt);
+                continue;   // 立即失败，马上尝试下一个地址
+            }
+            pending.push_back(attempt);
+            nextAttempt = now + std::chrono::milliseconds(CONNECT_ATTEMPT_DELAY_MS);
+            continue;
+        }
+
+        if (pending.empty()) {
+            if (next < candidates.size()) {
+                continue;
+            }
+            break;  // 全部地址均失败
+        }
+
+        // 等待任一尝试完成，到达下一个尝试的发起时间或总超时时返回
+        int timeout = remainingMs(deadline);
+        if (next < candidates.size()) {
+            int untilNext = remainingMs(nextAttempt);
+            timeout = timeout < 0 ? untilNext : std::min(timeout, untilNext);
+        }
+        std::vector<pollfd> fds;
+        for (SOCKET s : pending) {
+            pollfd fd = {};
+            fd.fd = s;
+            fd.events = POLLOUT;
+            fds.push_back(fd);
+        }
+        int ready = pollSockets(fds.data(), fds.size(), timeout);
+        if (ready < 0) {
+#ifndef _WIN32
+            if (errno == EINTR) {
+                continue;
+            }
 #endif
+            break;
+        }
+
+        for (size_t i = fds.size(); i-- > 0;) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            int socketError = 0;
+            socklen_t length = sizeof(socketError);
+            getsockopt(pending[i], SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&socketError), &length);
+            if (socketError == 0 && connected == INVALID_SOCKET) {
+                connected = pending[i];
+            } else {
+                closesocket(pending[i]);
+                nextAttempt = std::chrono::steady_clock::now();     // 失败的尝试不再占用等待时间
+            }
+            pending.erase(pending.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+
+    for (SOCKET s : pending) {
+        closesocket(s);
+    }
+    freeaddrinfo(result);
+
+    if (connected == INVALID_SOCKET) {
+        error = timedOut ? "Connection timed out" : "Failed to connect to server";
+    }
+    return connected;
+}
+
+/**
+ * @brief 以非阻塞方式连接单个地址（被动模式的数据连接）
+ * @param timeoutMs 超时时间，0 表示不限
+ * @param options 数据连接的 socket 选项
+ * @return 已连接的非阻塞 socket，失败返回 INVALID_SOCKET 并设置 error
+ */
+SOCKET connectAddress(const sockaddr_storage& address, socklen_t length, int timeoutMs,
+                      const FTPClient::SocketOptions& options, std::string& error) {
+    SOCKET result = socket(address.ss_family, SOCK_STREAM, IPPROTO_TCP);
+    if (result == INVALID_SOCKET) {
+        error = "Failed to create data socket";
+        return INVALID_SOCKET;
+    }
+    if (!setNonBlocking(result, true)) {
+        error = "Failed to create data socket";
+        closesocket(result);
+        return INVALID_SOCKET;
+    }
+    applySocketOptions(result, options, false);
+
+    if (::connect(result, reinterpret_cast<const sockaddr*>(&address), length) != 0) {
+        if (!connectInProgress()) {
+            error = "Failed to connect to data port";
+            closesocket(result);
+            return INVALID_SOCKET;
+        }
+
+        pollfd fd = {};
+        fd.fd = result;
+        fd.events = POLLOUT;
+        auto deadline = deadlineAfter(timeoutMs);
+        int ready;
+        while ((ready = pollSockets(&fd, 1, remainingMs(deadline))) < 0 && socketInterrupted()) {
+        }
+
+        int socketError = 0;
+        socklen_t errorLength = sizeof(socketError);
+        if (ready > 0) {
+            getsockopt(result, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&socketError), &errorLength);
+        }
+        if (ready <= 0 || socketError != 0) {
+            error = ready == 0 ? "Timed out connecting to data port" : "Failed to connect to data port";
+            closesocket(result);
+            return INVALID_SOCKET;
+        }
+    }
+    return result;
+}
+
+void setSocketPort(sockaddr_storage& address, uint16_t port) {
+    if (address.ss_family == AF_INET6) {
+        reinterpret_cast<sockaddr_in6&>(address).sin6_port = htons(port);
+    } else {
+        reinterpret_cast<sockaddr_in&>(address).sin_port = htons(port);
+    }
+}
+
+uint16_t socketPort(const sockaddr_storage& address) {
+    if (address.ss_family == AF_INET6) {
+        return ntohs(reinterpret_cast<const sockaddr_in6&>(address).sin6_port);
+    }
+    return ntohs(reinterpret_cast<const sockaddr_in&>(address).sin_port);
+}
+
+/**
+ * @brief 解析 EPSV 的 229 响应，例如 "Entering Extended Passive Mode (|||6446|)"
+ */
+bool parseEpsvReply(const std::string& msg, uint16_t& port) {
+    size_t open = msg.find('(');
+    size_t close = msg.find(')', open);
+    if (open == std::string::npos || close == std::string::npos || close - open < 6) {
+        return false;
+    }
+
+    // 括号内为 <d><d><d><端口><d>，d 为同一个分隔符
+    std::string body = msg.substr(open + 1, close - open - 1);
+    char delimiter = body[0];
+    if (body[1] != delimiter || body[2] != delimiter || body.back() != delimiter) {
+        return false;
+    }
+    std::string digits = body.substr(3, body.size() - 4);
+    if (digits.empty() || digits.size() > 5 ||
+        !std::all_of(digits.begin(), digits.end(), [](unsigned char c) { return std::isdigit(c) != 0; })) {
+        return false;
+    }
+    int value = std::stoi(digits);
+    if (value <= 0 || value > 65535) {
+        return false;
+    }
+    port = static_cast<uint16_t>(value);
     return true;
 }
 
-std::string FTPClient::getSSLInfo() const {
-    std::string info;
-    if (ssl.ssl && ssl.initialized) {
-        info += "Protocol: ";
-        info += SSL_get_version(ssl.ssl);
-        info += "\nCipher: ";
-        info += SSL_get_cipher(ssl.ssl);
+/**
+ * @brief 解析 SIZE 命令的 213 响应或 MLST 的 250 响应（size 事实），失败返回 -1
+ */
+int64_t parseSizeReply(const FTPResponse& response) {
+    if (response.code == 250) {
+        // 事实行形如 " type=file;size=1024;modify=20240101000000; /path"
+        std::string text = response.msg;
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        size_t pos = text.find("size=");
+        while (pos != std::string::npos && pos > 0 && text[pos - 1] != ';' && text[pos - 1] != ' ') {
+            pos = text.find("size=", pos + 1);
+        }
+        if (pos == std::string::npos || !std::isdigit(static_cast<unsigned char>(text[pos + 5]))) {
+            return -1;
+        }
+        return std::strtoll(text.c_str() + pos + 5, nullptr, 10);
+    }
+    if (response.code != 213) {
+        return -1;
+    }
+    try {
+        return std::stoll(response.msg);
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+/**
+ * @brief 各校验算法对应的扩展命令（XCRC 等），参数为路径，可选附加起止位置
+ */
+const char* checksumCommand(HashAlgorithm algorithm) {
+    switch (algorithm) {
+        case HashAlgorithm::CRC32:  return "XCRC";
+        case HashAlgorithm::MD5:    return "XMD5";
+        case HashAlgorithm::SHA1:   return "XSHA1";
+        case HashAlgorithm::SHA256: return "XSHA256";
+    }
+    return "";
+}
+
+/**
+ * @brief 解析 FEAT 中的 HASH 特性行，例如 "HASH SHA-256*;SHA-1;MD5;CRC32"
+ * @param selected 带 * 标记的算法（服务器当前选用的算法），没有或不支持时不修改
+ */
+std::vector<HashAlgorithm> parseHashFeature(const std::string& feature, std::string& selected) {
+    std::vector<HashAlgorithm> offered;
+    std::istringstream iss(feature.size() > 5 ? feature.substr(5) : std::string());
+    std::string name;
+    while (std::getline(iss, name, ';')) {
+        bool current = !name.empty() && name.back() == '*';
+        if (current) {
+            name.pop_back();
+        }
+        HashAlgorithm algorithm;
+        if (parseHashAlgorithm(name, algorithm)) {
+            offered.push_back(algorithm);
+            if (current) {
+                selected = hashAlgorithmName(algorithm);
+            }
+        }
+    }
+    return offered;
+}
+
+/**
+ * @brief 从校验命令的响应中取出校验值，转为小写；CRC32 不足 8 位时补零
+ *
+ * HASH 的响应为 "<算法> <起止> <校验值> <路径>"，XCRC 等只有校验值，取第一个长度相符的十六进制串。
+ */
+bool parseChecksumReply(const std::string& msg, HashAlgorithm algorithm, std::string& digest) {
+    size_t expected = 0;
+    switch (algorithm) {
+        case HashAlgorithm::CRC32:  expected = 8; break;
+        case HashAlgorithm::MD5:    expected = 32; break;
+        case HashAlgorithm::SHA1:   expected = 40; break;
+        case HashAlgorithm::SHA256: expected = 64; break;
+    }
+
+    std::istringstream iss(msg);
+    std::string token;
+    while (iss >> token) {
+        bool hex = std::all_of(token.begin(), token.end(), [](unsigned char c) {
+            return std::isxdigit(c) != 0;
+        });
+        bool fits = token.size() == expected ||
+                    (algorithm == HashAlgorithm::CRC32 && !token.empty() && token.size() < expected);
+        if (hex && fits) {
+            std::transform(token.begin(), token.end(), token.begin(), [](unsigned char c) {
+                return static_cast<char>(std::tolower(c));
+            });
+            digest = std::string(expected - token.size(), '0') + token;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 读取分段表，文件格式：首行 "FTPSEG 1 <文件大小>"，其后每行 "<start> <end> <done>"
+ */
+bool loadSegmentMap(const std::string& path, int64_t fileSize, std::vector<Segment>& segments) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    std::string magic;
+    int version = 0;
+    int64_t size = -1;
+    if (!(in >> magic >> version >> size) || magic != "FTPSEG" || version != 1 || size != fileSize) {
+        return false;
+    }
+
+    std::vector<Segment> loaded;
+    Segment seg;
+    while (in >> seg.start >> seg.end >> seg.done) {
+        if (seg.start < 0 || seg.end > fileSize || seg.start > seg.end ||
+            seg.done < 0 || seg.done > seg.end - seg.start) {
+            return false;
+        }
+        loaded.push_back(seg);
+    }
+
+    if (loaded.empty()) {
+        return false;
+    }
+    segments.swap(loaded);
+    return true;
+}
+
+/**
+ * @brief 保存分段表（先写临时文件再替换，避免中断时留下不完整的表）
+ */
+bool saveSegmentMap(const std::string& path, int64_t fileSize, const std::vector<Segment>& segments) {
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out << "FTPSEG 1 " << fileSize << "\n";
+        for (const auto& seg : segments) {
+            out << seg.start << " " << seg.end << " " << seg.done << "\n";
+        }
+        if (!out) {
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+/**
+ * @brief 目录同步中一侧目录树的节点
+ */
+struct MirrorNode {
+    bool isDir;
+    int64_t size;
+    int64_t mtime;      ///< Unix 时间戳，未知时为 -1
+};
+
+using MirrorTree = std::map<std::string, MirrorNode>;     ///< 相对路径 -> 节点，父目录排在子项之前
+
+std::string joinPath(const std::string& base, const std::string& rel) {
+    if (rel.empty()) {
+        return base;
+    }
+    if (base.empty()) {
+        return rel;
+    }
+    return base.back() == '/' ? base + rel : base + "/" + rel;
+}
+
+int64_t localModificationTime(const std::string& path) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path.c_str(), &st) != 0) {
+        return -1;
+    }
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return -1;
+    }
+#endif
+    return static_cast<int64_t>(st.st_mtime);
+}
+
+bool setLocalModificationTime(const std::string& path, int64_t mtime) {
+#ifdef _WIN32
+    struct __utimbuf64 times;
+    times.actime = times.modtime = mtime;
+    return _utime64(path.c_str(), &times) == 0;
+#else
+    struct utimbuf times;
+    times.actime = times.modtime = static_cast<time_t>(mtime);
+    return utime(path.c_str(), &times) == 0;
+#endif
+}
+
+/**
+ * @brief 遍历本地目录树，目录不存在时返回 false
+ */
+bool scanLocalTree(const std::string& root, MirrorTree& tree) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (!fs::is_directory(root, ec)) {
+        return false;
+    }
+
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        const fs::directory_entry& entry = *it;
+        std::string rel = entry.path().lexically_relative(root).generic_string();
+
+        if (entry.is_directory(ec)) {
+            tree[rel] = {true, -1, -1};
+        } else if (entry.is_regular_file(ec)) {
+            std::string path = entry.path().string();
+            int64_t size = static_cast<int64_t>(entry.file_size(ec));
+            tree[rel] = {false, ec ? -1 : size, localModificationTime(path)};
+        }
+    }
+    return !ec;
+}
+
+} // namespace
+
+void TransferControl::attach(SOCKET socket) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sockets.push_back(socket);
+    if (stopRequested()) {
+        shutdownSocket(socket);
+    }
+}
+
+void TransferControl::detach(SOCKET socket) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sockets.erase(std::remove(sockets.begin(), sockets.end(), socket), sockets.end());
+}
+
+void TransferControl::stop(Request type) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // 取消优先于暂停
+    if (type == Request::CANCEL || !stopRequested()) {
+        request = static_cast<int>(type);
+    }
+    // 描述符在注销前不会被关闭，持锁期间对其 shutdown 是安全的
+    for (SOCKET socket : sockets) {
+        shutdownSocket(socket);
+    }
+}
+
+bool FTPClient::networkInit = false;
+
+FTPClient::FTPClient() : 
+    controlSocket(INVALID_SOCKET),
+    transferMode(TransferMode::PASSIVE),
+    transferType(TransferType::BINARY),
+    serverPort(0),
+    featuresLoaded(false),
+    epsvRejected(false),
+    transferDeadline(std::chrono::steady_clock::time_point::max()),
+    transferTimedOut(false),
+    compression(false),
+    compressionLevel(DEFAULT_COMPRESSION_LEVEL),
+    modeZ(false),
+    integrityCheck(false) {
+    
+    if (!networkInit) {
+        networkInit = initNetwork();
+    }
+    
+    // 初始化OpenSSL
+    SSL_library_init();
+    SSL_load_error_strings();
+    OpenSSL_add_all_algorithms();
+}
+
+FTPClient::~FTPClient() {
+    disconnect();
+}
+
+bool FTPClient::initNetwork() {
+#ifdef _WIN32
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+#endif
+    return true;
+}
+
+std::string FTPClient::getSSLInfo() const {
+    std::string info;
+    if (ssl.ssl && ssl.initialized) {
+        info += "Protocol: ";
+        info += SSL_get_version(ssl.ssl);
+        info += "\nCipher: ";
+        info += SSL_get_cipher(ssl.ssl);
+        info += "\nSession reused: ";
+        info += SSL_session_reused(ssl.ssl) ? "yes" : "no";
+    }
+    return info;
+}
+
+bool FTPClient::initSSL() {
+    // 相同配置的连接共享 SSL_CTX，避免每次连接重复解析证书文件
+    ssl.ctx = TLSContextCache::instance().acquire(tlsConfig, lastError);
+    return ssl.ctx != nullptr;
+}
+
+bool FTPClient::upgradeToTLS() {
+    if (!sendCommand("AUTH TLS")) {
+        return false;
+    }
+
+    FTPResponse response = getResponse();
+    if (response.code != 234) {
+        lastError = "Server doesn't support TLS: " + response.msg;
+        return false;
+    }
+
+    ssl.ssl = SSL_new(ssl.ctx.get());
+    if (!ssl.ssl) {
+        lastError = "Failed to create SSL object";
+        return false;
+    }
+
+    SSL_set_fd(ssl.ssl, static_cast<int>(controlSocket));
+
+    // SNI 只能携带主机名，IP 地址不发送
+    unsigned char addrBuf[sizeof(struct in6_addr)];
+    if (inet_pton(AF_INET, serverHost.c_str(), addrBuf) != 1 &&
+        inet_pton(AF_INET6, serverHost.c_str(), addrBuf) != 1) {
+        SSL_set_tlsext_host_name(ssl.ssl, serverHost.c_str());
+    }
+
+    // 尝试恢复之前与同一服务器建立的会话，新会话由 new_session 回调存入缓存
+    tlsSessionKey = serverHost + ":" + std::to_string(serverPort) + "\n" +
+                    TLSContextCache::makeKey(tlsConfig);
+    SSL_set_ex_data(ssl.ssl, TLSSessionCache::keyIndex(), &tlsSessionKey);
+    SSL_SESSION* cached = TLSSessionCache::instance().get(tlsSessionKey);
+    if (cached) {
+        SSL_set_session(ssl.ssl, cached);
+        SSL_SESSION_free(cached);
+    }
+
+    if (!tlsHandshake(ssl.ssl, controlSocket)) {
+        if (cached) {
+            TLSSessionCache::instance().remove(tlsSessionKey);
+        }
+        lastError = "SSL handshake failed: " + lastError;
+        return false;
+    }
+
+    ssl.initialized = true;
+
+    // 设置保护缓冲区大小为0
+    if (!sendCommand("PBSZ 0")) {
+        return false;
+    }
+    response = getResponse();
+    if (response.code != 200) {
+        lastError = "Failed to set protection buffer size: " + response.msg;
+        return false;
+    }
+
+    // 设置数据通道保护级别为私密
+    if (!sendCommand("PROT P")) {
+        return false;
+    }
+    response = getResponse();
+    if (response.code != 200) {
+        lastError = "Failed to set protection level: " + response.msg;
+        return false;
+    }
+
+    ssl.protected_mode = true;
+    return true;
+}
+
+bool FTPClient::connect(const std::string& host, uint16_t port) {
+    replyBuffer.clear();
+
+    // 同时尝试 IPv6 与 IPv4 地址；控制连接保持非阻塞，读写均以 poll 等待
+    controlSocket = connectHappyEyeballs(host, port, timeouts.connectMs, socketOptions, lastError);
+    if (controlSocket == INVALID_SOCKET) {
+        return false;
+    }
+
+    FTPResponse response = getResponse();
+    if (response.code != 220) {
+        lastError = "Server rejected connection: " + response.msg;
+        disconnect();
+        return false;
+    }
+
+    serverHost = host;
+    serverPort = port;
+    featuresLoaded = false;
+    capabilities = ServerCapabilities();
+    capabilityKey.clear();
+    epsvRejected = false;
+    modeZ = false;
+    hashSelection.clear();
+    return true;
+}
+
+bool FTPClient::sendCommand(const std::string& command) {
+    return sendRaw(command + "\r\n");
+}
+
+bool FTPClient::sendRaw(const std::string& data) {
+    const char* ptr = data.data();
+    size_t remaining = data.length();
+
+    while (remaining > 0) {
+        int sent = sendSome(controlSocket, ssl.initialized ? ssl.ssl : nullptr, ptr, remaining);
+        if (sent < 0) {
+            lastError = (ssl.initialized ? "Failed to send command over SSL: " : "Failed to send command: ") +
+                        lastError;
+            return false;
+        }
+        ptr += sent;
+        remaining -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool FTPClient::readControlData(std::string& error) {
+    // 直接读入响应缓冲区，不经过临时缓冲
+    size_t available;
+    char* buffer = replyBuffer.prepare(available);
+    if (!buffer) {
+        error = "Server reply too long";
+        return false;
+    }
+
+    // 错误只通过 error 返回，不改变 lastError
+    std::string saved = std::move(lastError);
+    int received = receiveSome(controlSocket, ssl.initialized ? ssl.ssl : nullptr, buffer, available);
+    if (received < 0) {
+        error = std::move(lastError);
+    }
+    lastError = std::move(saved);
+    if (received == 0) {
+        error = "Connection closed by server";
+    }
+    if (received <= 0) {
+        // 超时或出错后无法确定迟到的响应属于哪条命令，关闭控制连接，连接池不再复用
+        closeControlConnection();
+        return false;
+    }
+
+    replyBuffer.commit(static_cast<size_t>(received));
+    return true;
+}
+
+bool FTPClient::waitForResponse(int timeoutMs) {
+    auto deadline = deadlineAfter(timeoutMs);
+
+    while (!replyBuffer.hasReply()) {
+        // TLS 记录可能已在 OpenSSL 内部缓冲，此时套接字不一定可读
+        bool pending = ssl.initialized && SSL_pending(ssl.ssl) > 0;
+        if (!pending) {
+            pollfd fd = {};
+            fd.fd = controlSocket;
+            fd.events = POLLIN;
+            int ready;
+            while ((ready = pollSockets(&fd, 1, remainingMs(deadline))) < 0 && socketInterrupted()) {
+            }
+            if (ready <= 0) {
+                return false;
+            }
+        }
+
+        std::string error;
+        if (!readControlData(error)) {
+            lastError = error;
+            return false;
+        }
+    }
+    return true;
+}
+
+FTPResponse FTPClient::getResponse() {
+    FTPResponse response;
+
+    // 一次读取可能包含多条响应（流水线命令），多余的数据留在 replyBuffer 中供下次使用
+    while (!replyBuffer.hasReply()) {
+        if (!readControlData(response.msg)) {
+            response.code = 0;
+            return response;
+        }
+    }
+
+    std::string_view text;
+    replyBuffer.next(response.code, text);
+    if (response.code == 0) {
+        response.msg = "Malformed server reply: ";
+        response.msg.append(text.data(), text.size());
+    } else {
+        response.msg.assign(text.data(), text.size());
+    }
+    return response;
+}
+
+bool FTPClient::pipelineCommands(const std::vector<std::string>& commands,
+                                 std::vector<FTPResponse>& replies,
+                                 size_t window) {
+    replies.clear();
+    replies.reserve(commands.size());
+    window = std::max<size_t>(1, window);
+
+    // 最多 window 条命令等待响应，响应按发送顺序与命令一一对应
+    size_t sent = 0;
+    while (replies.size() < commands.size()) {
+        std::string batch;
+        while (sent < commands.size() && sent - replies.size() < window) {
+            batch += commands[sent++];
+            batch += "\r\n";
+        }
+        if (!batch.empty() && !sendRaw(batch)) {
+            return false;
+        }
+
+        FTPResponse response = getResponse();
+        if (response.code == 0) {
+            lastError = response.msg;
+            return false;
+        }
+        replies.push_back(response);
+    }
+
+    return true;
+}
+
+bool FTPClient::sendCommands(const std::vector<std::string>& commands,
+                             std::vector<FTPResponse>& replies) {
+    // 单条命令无需流水线，也就不必探测；探测中断开了连接时保留其错误信息
+    bool pipelined = commands.size() > 1 && supportsPipelining();
+    if (commands.size() > 1 && !isConnected()) {
+        return false;
+    }
+    return pipelineCommands(commands, replies, pipelined ? PIPELINE_WINDOW : 1);
+}
+
+bool FTPClient::supportsPipelining() {
+    if (capabilities.pipelineSupport >= 0) {
+        return capabilities.pipelineSupport == 1;
+    }
+
+    // 一次写入两条 NOOP：逐条读取命令的服务器也会按顺序回复两次，
+    // 丢弃缓冲区剩余命令的服务器只回复一次，等待超时后判定为不支持
+    if (!sendRaw("NOOP\r\nNOOP\r\n")) {
+        return false;
+    }
+
+    int replies = 0;
+    while (replies < 2 && waitForResponse(PIPELINE_PROBE_TIMEOUT_MS)) {
+        if (getResponse().code != 200) {
+            break;
+        }
+        ++replies;
+    }
+    if (replies == 2) {
+        capabilities.pipelineSupport = 1;
+        saveCapabilities();
+        return true;
+    }
+    if (!isConnected()) {
+        return false;
+    }
+
+    // 未收到的响应可能被丢弃，也可能只是来得晚
+    if (!resyncReplies(2 - replies)) {
+        lastError = "Lost track of pipelined replies";
+        return false;
+    }
+
+    capabilities.pipelineSupport = 0;
+    saveCapabilities();
+    return false;
+}
+
+bool FTPClient::resyncReplies(int maxStale) {
+    // 标记命令的响应之前只可能是迟到的响应
+    FTPResponse response;
+    if (sendCommand("PWD")) {
+        for (int i = 0; i <= maxStale; ++i) {
+            response = getResponse();
+            if (response.code == 257 || response.code == 0) {
+                break;
+            }
+        }
+    }
+    if (response.code != 257) {
+        // 无法确定哪条响应对应哪条命令
+        disconnect();
+        lastError = "Lost track of server replies";
+        return false;
+    }
+    return true;
+}
+
+bool FTPClient::login(const std::string& username, const std::string& password) {
+    if (!sendCommand("USER " + username)) {
+        return false;
+    }
+
+    FTPResponse response = getResponse();
+    if (response.code != 331 && response.code != 230) {
+        lastError = "Login failed: " + response.msg;
+        return false;
+    }
+
+    if (response.code == 331) {
+        if (!sendCommand("PASS " + password)) {
+            return false;
+        }
+
+        response = getResponse();
+        if (response.code != 230) {
+            lastError = "Login failed: " + response.msg;
+            return false;
+        }
+    }
+
+    loginUser = username;
+    loginPassword = password;
+
+    // 登录后服务器声明的特性可能与登录前不同，重新获取
+    capabilityKey = CapabilityCache::makeKey(serverHost, serverPort, username, ssl.protected_mode);
+    loadFeatures();
+    return true;
+}
+
+void FTPClient::disconnect() {
+    if (controlSocket != INVALID_SOCKET) {
+        sendCommand("QUIT");
+        if (ssl.initialized && ssl.ssl) {
+            SSL_shutdown(ssl.ssl);
+        }
+    }
+    closeControlConnection();
+}
+
+void FTPClient::closeControlConnection() {
+    if (controlSocket != INVALID_SOCKET) {
+        if (ssl.initialized) {
+            if (ssl.ssl) {
+                SSL_free(ssl.ssl);
+                ssl.ssl = nullptr;
+            }
+            ssl.ctx.reset();
+            ssl.initialized = false;
+            ssl.protected_mode = false;
+        }
+        closesocket(controlSocket);
+        controlSocket = INVALID_SOCKET;
+    }
+    replyBuffer.clear();
+}
+
+bool FTPClient::noop() {
+    if (!isConnected() || !sendCommand("NOOP")) {
+        return false;
+    }
+
+    FTPResponse response = getResponse();
+    if (response.code != 200) {
+        lastError = "NOOP failed: " + response.msg;
+        return false;
+    }
+
+    return true;
+}
+
+SOCKET FTPClient::createDataConnection(const std::vector<std::string>& setup,
+                                       std::vector<FTPResponse>* setupReplies,
+                                       bool compress) {
+    SOCKET dataSocket = INVALID_SOCKET;
+    std::vector<std::string> commands(setup);
+    std::vector<FTPResponse> replies;
+
+    // 需要切换 MODE Z/S 时，切换命令同样与 PASV/PORT 一起发送
+    if (compress != modeZ) {
+        if (compress) {
+            commands.push_back("OPTS MODE Z LEVEL " + std::to_string(compressionLevel));
+        }
+        commands.push_back(compress ? "MODE Z" : "MODE S");
+    }
+    size_t modeCommands = commands.size() - setup.size();
+
+    if (transferMode == TransferMode::PASSIVE) {
+        // 数据连接连向控制连接的对端地址；IPv6 下只能使用 EPSV
+        sockaddr_storage peerAddr = {};
+        socklen_t peerLen = sizeof(peerAddr);
+        if (getpeername(controlSocket, reinterpret_cast<sockaddr*>(&peerAddr), &peerLen) != 0) {
+            lastError = "Failed to get server address from control socket";
+            return INVALID_SOCKET;
+        }
+        bool ipv6 = peerAddr.ss_family == AF_INET6;
+        bool extended = ipv6 || (!epsvRejected && !featureMissing("EPSV"));
+
+        // 准备命令与 EPSV/PASV 一起发送
+        commands.push_back(extended ? "EPSV" : "PASV");
+        if (!sendCommands(commands, replies)) {
+            return INVALID_SOCKET;
+        }
+
+        FTPResponse response = replies.back();
+        replies.pop_back();
+        if (!applyModeReplies(replies, modeCommands, compress)) {
+            return INVALID_SOCKET;
+        }
+        if (setupReplies) {
+            setupReplies->swap(replies);
+        }
+
+        // IPv4 下服务器不支持 EPSV 时改用 PASV，本会话之后不再尝试 EPSV
+        if (extended && !ipv6 && response.code != 229) {
+            epsvRejected = true;
+            extended = false;
+            if (!sendCommand("PASV")) {
+                return INVALID_SOCKET;
+            }
+            response = getResponse();
+        }
+
+        uint16_t port;
+        sockaddr_storage dataAddr = peerAddr;
+        socklen_t dataLen = peerLen;
+        if (extended) {
+            // EPSV 只返回端口，地址沿用控制连接的对端，不受 NAT 改写的影响
+            if (response.code != 229 || !parseEpsvReply(response.msg, port)) {
+                lastError = "Failed to enter extended passive mode: " + response.msg;
+                return INVALID_SOCKET;
+            }
+            setSocketPort(dataAddr, port);
+        } else {
+            if (response.code != 227) {
+                lastError = "Failed to enter passive mode: " + response.msg;
+                return INVALID_SOCKET;
+            }
+
+            std::string ip;
+            if (!parsePasvResponse(response.msg, ip, port)) {
+                return INVALID_SOCKET;
+            }
+
+            sockaddr_in& addr = reinterpret_cast<sockaddr_in&>(dataAddr);
+            dataAddr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+                lastError = "Invalid PASV response format";
+                return INVALID_SOCKET;
+            }
+            dataLen = sizeof(addr);
+        }
+
+        dataSocket = connectAddress(dataAddr, dataLen, timeouts.connectMs, socketOptions, lastError);
+        if (dataSocket == INVALID_SOCKET) {
+            return INVALID_SOCKET;
+        }
+    } else {
+        // Active mode implementation...
+        // ----------------------
+        //   主动模式实现示例
+        // ----------------------
+
+        // 1) 从控制连接 socket 上获取本机地址，监听 socket 使用相同的地址族
+        //    （对于 NAT 或多网卡场景，需要更灵活的机制）
+        sockaddr_storage ctrlAddr = {};
+        socklen_t ctrlLen = sizeof(ctrlAddr);
+        if (getsockname(controlSocket, reinterpret_cast<sockaddr*>(&ctrlAddr), &ctrlLen) != 0) {
+            lastError = "Failed to get local IP from control socket";
+            return INVALID_SOCKET;
+        }
+
+        // 2) 创建一个监听 socket
+        SOCKET dataListenSocket = socket(ctrlAddr.ss_family, SOCK_STREAM, IPPROTO_TCP);
+        if (dataListenSocket == INVALID_SOCKET) {
+            lastError = "Failed to create data listen socket";
+            return INVALID_SOCKET;
+        }
+
+        // 设置套接字可重用、绑定到控制连接所用的本机地址和随机端口
+        int opt = 1;
+        setsockopt(dataListenSocket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
+        applySocketOptions(dataListenSocket, socketOptions, false);
+
+        sockaddr_storage listenAddr = ctrlAddr;
+        setSocketPort(listenAddr, 0); // 0 表示让系统自动分配一个空闲端口
+
+        if (bind(dataListenSocket, reinterpret_cast<sockaddr*>(&listenAddr), ctrlLen) == SOCKET_ERROR) {
+            lastError = "Failed to bind for active mode";
+            closesocket(dataListenSocket);
+            return INVALID_SOCKET;
+        }
+
+        // 开始监听
+        if (listen(dataListenSocket, 1) == SOCKET_ERROR) {
+            lastError = "Failed to listen for active mode";
+            closesocket(dataListenSocket);
+            return INVALID_SOCKET;
+        }
+
+        // 3) 通过 getsockname 获取实际绑定的端口
+        sockaddr_storage localAddr = {};
+        socklen_t addrLen = sizeof(localAddr);
+        if (getsockname(dataListenSocket, reinterpret_cast<sockaddr*>(&localAddr), &addrLen) != 0) {
+            lastError = "getsockname failed";
+            closesocket(dataListenSocket);
+            return INVALID_SOCKET;
+        }
+        unsigned short localPort = socketPort(localAddr);
+
+        // 4) 发送 PORT/EPRT 命令给服务器（与准备命令一起发送）
+        std::ostringstream portCmd;
+        if (ctrlAddr.ss_family == AF_INET6) {
+            // 格式：EPRT |2|地址|端口|
+            char host[INET6_ADDRSTRLEN] = {};
+            inet_ntop(AF_INET6, &reinterpret_cast<sockaddr_in6&>(ctrlAddr).sin6_addr, host, sizeof(host));
+            portCmd << "EPRT |2|" << host << "|" << localPort << "|";
+        } else {
+            unsigned long ip = ntohl(reinterpret_cast<sockaddr_in&>(ctrlAddr).sin_addr.s_addr);
+            // 分别取 h1,h2,h3,h4
+            unsigned char h1 = (ip >> 24) & 0xFF;
+            unsigned char h2 = (ip >> 16) & 0xFF;
+            unsigned char h3 = (ip >>  8) & 0xFF;
+            unsigned char h4 =  ip        & 0xFF;
+
+            // 分别取 p1,p2
+            unsigned char p1 = (localPort >> 8) & 0xFF;
+            unsigned char p2 =  localPort       & 0xFF;
+
+            // 格式：PORT h1,h2,h3,h4,p1,p2
+            portCmd << "PORT "
+                    << (int)h1 << "," << (int)h2 << ","
+                    << (int)h3 << "," << (int)h4 << ","
+                    << (int)p1 << "," << (int)p2;
+        }
+
+        commands.push_back(portCmd.str());
+        if (!sendCommands(commands, replies)) {
+            closesocket(dataListenSocket);
+            return INVALID_SOCKET;
+        }
+
+        FTPResponse resp = replies.back();
+        replies.pop_back();
+        if (!applyModeReplies(replies, modeCommands, compress)) {
+            closesocket(dataListenSocket);
+            return INVALID_SOCKET;
+        }
+        if (setupReplies) {
+            setupReplies->swap(replies);
+        }
+
+        if (resp.code != 200) {
+            lastError = "Failed to set active mode: " + resp.msg;
+            closesocket(dataListenSocket);
+            return INVALID_SOCKET;
+        }
+
+        // 5) 服务器收到传输命令后才会连接，accept 在 startTransfer 中进行
+        dataSocket = dataListenSocket;
+    }
+
+    return dataSocket;
+}
+
+bool FTPClient::applyModeReplies(std::vector<FTPResponse>& replies, size_t count, bool compress) {
+    if (count == 0) {
+        return true;
+    }
+
+    // OPTS MODE Z LEVEL 的结果不影响传输，只看 MODE 的响应
+    FTPResponse mode = replies.back();
+    replies.erase(replies.end() - static_cast<std::ptrdiff_t>(count), replies.end());
+    if (mode.code == 200) {
+        modeZ = compress;
+        return true;
+    }
+    if (compress) {
+        return true;    // 服务器拒绝压缩，按未压缩传输
+    }
+
+    lastError = "Failed to restore stream mode: " + mode.msg;
+    return false;
+}
+
+bool FTPClient::useCompression(const std::string& path, LocalFile* sample) {
+    if (!compression || hasCompressedExtension(path) || !hasFeature("MODE Z")) {
+        return false;
+    }
+    if (!sample) {
+        return true;
+    }
+
+    // 用文件开头的一段数据试压缩
+    const size_t SAMPLE_SIZE = 64 * 1024;
+    if (!transferBuffer.reserve(SAMPLE_SIZE)) {
+        return false;
+    }
+    int64_t n = sample->readAt(0, transferBuffer.data(), SAMPLE_SIZE);
+    return n > 0 && isCompressible(transferBuffer.data(), static_cast<size_t>(n));
+}
+
+void FTPClient::setCompression(bool enabled, int level) {
+    compression = enabled;
+    compressionLevel = std::min(std::max(level, 1), 9);
+}
+
+void FTPClient::throttle(size_t bytes) {
+    if (limiter) {
+        limiter->consume(bytes, [this]() {
+            return transferStopped();
+        });
+    }
+}
+
+bool FTPClient::sendAll(SOCKET dataSocket, const char* data, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        int sent = sendSome(dataSocket, ssl.dataSSL, data + offset, size - offset);
+        if (sent < 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool FTPClient::waitSocket(SOCKET socket, bool writable, bool connecting) {
+    auto deadline = deadlineAfter(connecting ? timeouts.connectMs : timeouts.readMs);
+    bool transferLimit = !connecting && transferDeadline < deadline;
+    if (transferLimit) {
+        deadline = transferDeadline;
+    }
+
+    pollfd fd = {};
+    fd.fd = socket;
+    fd.events = writable ? POLLOUT : POLLIN;
+    while (true) {
+        int ready = pollSockets(&fd, 1, remainingMs(deadline));
+        if (ready > 0) {
+            return true;    // 包括出错与对端关闭，由随后的读写返回具体结果
+        }
+        if (ready == 0) {
+            lastError = connecting ? "Connection timed out" :
+                        transferLimit ? "Transfer timed out" : "Timed out waiting for server";
+            transferTimedOut = true;
+            return false;
+        }
+        if (!socketInterrupted()) {
+            lastError = "Failed to wait for socket: " + socketErrorString();
+            return false;
+        }
+    }
+}
+
+int FTPClient::receiveSome(SOCKET socket, SSL* tls, char* buffer, size_t length) {
+    int size = static_cast<int>(std::min<size_t>(length, INT_MAX));
+    while (true) {
+        if (tls) {
+            ERR_clear_error();
+            int received = SSL_read(tls, buffer, size);
+            if (received > 0) {
+                return received;
+            }
+            int error = SSL_get_error(tls, received);
+            if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+                if (!waitSocket(socket, error == SSL_ERROR_WANT_WRITE)) {
+                    return -1;
+                }
+                continue;
+            }
+            if (received == 0) {
+                return 0;
+            }
+            lastError = "SSL read error: " + sslErrorString();
+            return -1;
+        }
+
+        int received = recv(socket, buffer, size, 0);
+        if (received >= 0) {
+            return received;
+        }
+        if (socketWouldBlock()) {
+            if (!waitSocket(socket, false)) {
+                return -1;
+            }
+        } else if (!socketInterrupted()) {
+            lastError = socketErrorString();
+            return -1;
+        }
+    }
+}
+
+int FTPClient::sendSome(SOCKET socket, SSL* tls, const char* data, size_t length) {
+    int size = static_cast<int>(std::min<size_t>(length, INT_MAX));
+    while (true) {
+        if (tls) {
+            ERR_clear_error();
+            int sent = SSL_write(tls, data, size);
+            if (sent > 0) {
+                return sent;
+            }
+            int error = SSL_get_error(tls, sent);
+            if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+                if (!waitSocket(socket, error == SSL_ERROR_WANT_WRITE)) {
+                    return -1;
+                }
+                continue;
+            }
+            lastError = sslErrorString();
+            return -1;
+        }
+
+        int sent = send(socket, data, size, 0);
+        if (sent > 0) {
+            return sent;
+        }
+        if (sent < 0 && socketWouldBlock()) {
+            if (!waitSocket(socket, true)) {
+                return -1;
+            }
+        } else if (sent == 0 || !socketInterrupted()) {
+            lastError = sent == 0 ? "Connection closed" : socketErrorString();
+            return -1;
+        }
+    }
+}
+
+bool FTPClient::tlsHandshake(SSL* tls, SOCKET socket) {
+    while (true) {
+        ERR_clear_error();
+        int result = SSL_connect(tls);
+        if (result == 1) {
+            return true;
+        }
+        int error = SSL_get_error(tls, result);
+        if (error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE) {
+            lastError = sslErrorString();
+            return false;
+        }
+        if (!waitSocket(socket, error == SSL_ERROR_WANT_WRITE, true)) {
+            return false;
+        }
+    }
+}
+
+bool FTPClient::startTransfer(const std::string& command, int64_t restPos, SOCKET& dataSocket) {
+    if (transferControl) {
+        transferControl->attach(dataSocket);
+    }
+
+    // 传输总时长从发送传输命令开始计算，closeDataConnection 时清除
+    transferDeadline = deadlineAfter(timeouts.transferMs);
+    transferTimedOut = false;
+
+    // REST 与传输命令一起发送
+    std::vector<std::string> commands;
+    if (restPos > 0) {
+        commands.push_back("REST " + std::to_string(restPos));
+    }
+    commands.push_back(command);
+
+    std::vector<FTPResponse> replies;
+    if (!sendCommands(commands, replies)) {
+        closeDataConnection(dataSocket);
+        dataSocket = INVALID_SOCKET;
+        return false;
+    }
+
+    const FTPResponse& response = replies.back();
+    if (response.code != 150 && response.code != 125) {
+        lastError = "Failed to initiate file transfer: " + response.msg;
+        closeDataConnection(dataSocket);
+        dataSocket = INVALID_SOCKET;
+        return false;
+    }
+
+    bool ok = true;
+    if (restPos > 0 && replies.front().code != 350) {
+        // REST 被拒绝时服务器会从头开始传输，放弃本次传输
+        lastError = "Failed to set file position: " + replies.front().msg;
+        ok = false;
+    }
+
+    if (ok && transferMode == TransferMode::ACTIVE) {
+        // 6) 等待服务器连进来
+        SOCKET listenSocket = dataSocket;
+        dataSocket = INVALID_SOCKET;
+        if (waitSocket(listenSocket, false, true)) {
+            dataSocket = accept(listenSocket, nullptr, nullptr);
+            if (dataSocket == INVALID_SOCKET) {
+                lastError = "Failed to accept data connection from server";
+            } else if (!setNonBlocking(dataSocket, true)) {
+                closesocket(dataSocket);
+                dataSocket = INVALID_SOCKET;
+                lastError = "Failed to accept data connection from server";
+            } else {
+                // 缓冲区大小已由监听 socket 继承，其余选项不一定继承，再设置一次
+                applySocketOptions(dataSocket, socketOptions, false);
+            }
+        } else {
+            lastError = "Failed to accept data connection from server: " + lastError;
+        }
+        if (transferControl) {
+            transferControl->detach(listenSocket);
+            if (dataSocket != INVALID_SOCKET) {
+                transferControl->attach(dataSocket);
+            }
+        }
+        closesocket(listenSocket);
+        if (dataSocket == INVALID_SOCKET) {
+            ok = false;
+        }
+    }
+
+    // 服务器在发出 1xx 响应之后才开始数据连接的 TLS 握手
+    if (ok && ssl.protected_mode) {
+        ok = secureDataConnection(dataSocket);
+    }
+
+    if (!ok) {
+        if (dataSocket != INVALID_SOCKET) {
+            closeDataConnection(dataSocket);
+            dataSocket = INVALID_SOCKET;
+        }
+        // 读取被中止传输的最终响应，保持控制连接同步
+        getResponse();
+        return false;
+    }
+    return true;
+}
+
+bool FTPClient::secureDataConnection(SOCKET dataSocket) {
+    ssl.dataSSL = SSL_new(ssl.ctx.get());
+    if (!ssl.dataSSL) {
+        lastError = "Failed to create SSL object for data connection";
+        return false;
+    }
+
+    // 添加会话恢复
+    SSL_set_fd(ssl.dataSSL, static_cast<int>(dataSocket));
+    SSL_set_session(ssl.dataSSL, SSL_get_session(ssl.ssl));
+
+    if (!tlsHandshake(ssl.dataSSL, dataSocket)) {
+        lastError = "SSL handshake failed for data connection: " + lastError;
+        SSL_free(ssl.dataSSL);
+        ssl.dataSSL = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void FTPClient::closeDataConnection(SOCKET dataSocket, bool drain) {
+    if (transferControl) {
+        transferControl->detach(dataSocket);
+    }
+    transferDeadline = std::chrono::steady_clock::time_point::max();
+
+    if (ssl.dataSSL) {
+        SSL_shutdown(ssl.dataSSL);
+        SSL_free(ssl.dataSSL);
+        ssl.dataSSL = nullptr;
+    }
+
+    if (drain) {
+        // 半关闭后读尽对端数据再关闭：接收缓冲区中若有未读数据（如 TLS 1.3 会话票据），
+        // close 会触发 RST，服务器可能因此丢弃尚未读取的上传数据
+#ifdef _WIN32
+        shutdown(dataSocket, SD_SEND);
+#else
+        shutdown(dataSocket, SHUT_WR);
+#endif
+        char discard[4096];
+        for (int i = 0; i < 50; ++i) {
+            pollfd fd = {};
+            fd.fd = dataSocket;
+            fd.events = POLLIN;
+            if (pollSockets(&fd, 1, 100) <= 0 ||
+                recv(dataSocket, discard, sizeof(discard), 0) <= 0) {
+                break;
+            }
+        }
+    }
+
+    closesocket(dataSocket);
+}
+
+void FTPClient::abortTransfer(SOCKET dataSocket) {
+    bool paused = transferControl && transferControl->pending() == TransferControl::Request::PAUSE;
+
+    // 先关闭数据连接，服务器的读写随即失败，不依赖其对 ABOR 的带外处理
+    closeDataConnection(dataSocket);
+
+    // 服务器先结束被中止的传输（426，或已完成时的 226），再回复 ABOR 本身（225/226）；
+    // 部分服务器只回复一条（即使是 426），第二条响应只短暂等待，
+    // 未等到时它可能只是来得晚，以 PWD 标记重新对齐
+    if (sendCommand("ABOR")) {
+        FTPResponse response = getResponse();
+        if (response.code != 0) {
+            if (waitForResponse(ABORT_REPLY_TIMEOUT_MS)) {
+                getResponse();
+            } else if (isConnected()) {
+                resyncReplies(1);
+            }
+        }
+    }
+
+    lastError = paused ? "Transfer paused" : "Transfer cancelled";
+}
+
+bool FTPClient::uploadFile(const std::string& localPath, 
+                         const std::string& remotePath,
+                         bool resume,
+                         const ProgressCallback& progress) {
+    // 打开本地文件
+    LocalFile file;
+    if (!file.open(localPath, LocalFile::Mode::READ)) {
+        lastError = "Cannot open local file: " + localPath;
+        return false;
+    }
+
+    // 获取文件大小
+    int64_t fileSize = file.size();
+    bool compress = useCompression(localPath, &file);
+    limiter = std::make_shared<RateLimiter>(rateLimits);
+
+    lastIntegrity = IntegrityResult();
+    std::unique_ptr<Hasher> hasher;
+    HashAlgorithm algorithm;
+    if (integrityCheck && checksumAlgorithm(algorithm)) {
+        hasher.reset(new Hasher(algorithm));
+    }
+
+    // 创建数据连接，续传时查询远程大小的 SIZE 与 PASV 一起发送
+    std::vector<std::string> setup;
+    if (resume) {
+        setup.push_back(sizeCommand(remotePath));
+    }
+    std::vector<FTPResponse> setupReplies;
+    SOCKET dataSocket = createDataConnection(setup, &setupReplies, compress);
+    if (dataSocket == INVALID_SOCKET) {
+        return false;
+    }
+    compress = compress && modeZ;
+
+    // 处理断点续传（远程文件不存在时从头上传）
+    int64_t startPos = 0;
+    if (resume) {
+        startPos = std::max<int64_t>(parseSizeReply(setupReplies[0]), 0);
+    }
+
+    // 远程文件的全部内容即为已上传部分，与本地不一致时从头上传
+    if (hasher && startPos > 0) {
+        // 服务器读完文件才回复校验值，期间不保留空闲的数据连接，校验后重新建立
+        closeDataConnection(dataSocket);
+        if (startPos > fileSize || !verifyPrefix(remotePath, file, startPos, true, *hasher)) {
+            hasher->reset();
+            startPos = 0;
+            lastIntegrity.restarted = true;
+        }
+        dataSocket = createDataConnection({}, nullptr, compress);
+        if (dataSocket == INVALID_SOCKET) {
+            return false;
+        }
+    }
+
+    // 发送STOR命令；服务器不支持 REST 时以 APPE 追加续传
+    bool append = startPos > 0 && !supportsRestart();
+    if (!startTransfer((append ? "APPE " : "STOR ") + remotePath, append ? 0 : startPos, dataSocket)) {
+        return false;
+    }
+
+    // 传输文件数据
+    int64_t transferred = startPos;
+    ProgressReporter reporter(progress, progressOptions, fileSize, startPos);
+    bool success = compress ? sendCompressedData(dataSocket, file, transferred, fileSize, reporter,
+                                                 hasher.get())
+                            : sendFileData(dataSocket, file, transferred, fileSize, reporter, hasher.get());
+
+    file.close();
+    if (transferStopped()) {
+        abortTransfer(dataSocket);
+        return false;
+    }
+
+    // 关闭连接
+    closeDataConnection(dataSocket, true);
+
+    // 获取传输完成响应；数据传输超时或未收到响应时保留传输本身的错误
+    FTPResponse response = getResponse();
+    if (response.code != 226 && response.code != 250) {
+        if (success || (response.code != 0 && !transferTimedOut)) {
+            lastError = "File transfer failed: " + response.msg;
+        }
+        return false;
+    }
+
+    if (success && hasher && !verifyTransfer(remotePath, *hasher)) {
+        return false;
+    }
+    if (success) {
+        reporter.finish(transferred);
+    }
+    return success;
+}
+
+bool FTPClient::sendFileData(SOCKET dataSocket, LocalFile& file, int64_t& transferred,
+                             int64_t fileSize, ProgressReporter& reporter, Hasher* hasher) {
+    // 每次零拷贝调用的最大长度，兼顾系统调用次数与进度回调频率
+    const size_t ZERO_COPY_CHUNK = 1024 * 1024;
+
+#ifdef __linux__
+    if (!ssl.dataSSL && !hasher) {
+        // 明文数据连接：sendfile 直接从页缓存发送到 socket
+        bool fallback = false;
+        while (transferred < fileSize && !transferStopped()) {
+            off_t offset = static_cast<off_t>(transferred);
+            size_t chunk = static_cast<size_t>(std::min<int64_t>(transferChunk(ZERO_COPY_CHUNK),
+                                                                 fileSize - transferred));
+            ssize_t sent = sendfile(dataSocket, file.nativeHandle(), &offset, chunk);
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent < 0 && socketWouldBlock()) {
+                // 发送缓冲区已满
+                if (!waitSocket(dataSocket, true)) {
+                    lastError = "Failed to send file data: " + lastError;
+                    return false;
+                }
+                continue;
+            }
+            if (sent < 0 && (errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)) {
+                // 文件系统不支持 sendfile，改用 splice
+                fallback = true;
+                break;
+            }
+            if (sent <= 0) {
+                lastError = "Failed to send file data";
+                return false;
+            }
+            transferred += sent;
+            reporter.update(transferred);
+            throttle(static_cast<size_t>(sent));
+        }
+        if (!fallback) {
+            return true;
+        }
+
+        // splice：文件 -> 管道 -> socket，数据同样不经过用户空间
+        int pipeFds[2];
+        if (pipe2(pipeFds, O_CLOEXEC) == 0) {
+            bool spliceOk = true;
+            while (transferred < fileSize && spliceOk && !transferStopped()) {
+                loff_t offset = static_cast<loff_t>(transferred);
+                size_t chunk = static_cast<size_t>(std::min<int64_t>(transferChunk(ZERO_COPY_CHUNK),
+                                                                     fileSize - transferred));
+                ssize_t inPipe = splice(file.nativeHandle(), &offset, pipeFds[1], nullptr,
+                                        chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+                if (inPipe < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (inPipe <= 0) {
+                    spliceOk = false;
+                    break;
+                }
+                size_t spliced = static_cast<size_t>(inPipe);
+
+                while (inPipe > 0) {
+                    ssize_t sent = splice(pipeFds[0], nullptr, dataSocket, nullptr,
+                                          static_cast<size_t>(inPipe), SPLICE_F_MOVE | SPLICE_F_MORE);
+                    if (sent < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (sent < 0 && socketWouldBlock()) {
+                        if (waitSocket(dataSocket, true)) {
+                            continue;
+                        }
+                        close(pipeFds[0]);
+                        close(pipeFds[1]);
+                        lastError = "Failed to send file data: " + lastError;
+                        return false;
+                    }
+                    if (sent <= 0) {
+                        // 管道中已有数据，无法再退回到普通发送
+                        close(pipeFds[0]);
+                        close(pipeFds[1]);
+                        lastError = "Failed to send file data";
+                        return false;
+                    }
+                    inPipe -= sent;
+                    transferred += sent;
+                }
+                reporter.update(transferred);
+                throttle(spliced);
+            }
+            close(pipeFds[0]);
+            close(pipeFds[1]);
+            if (spliceOk) {
+                return true;
+            }
+        }
+    }
+#endif
+
+#if defined(__linux__) && OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(OPENSSL_NO_KTLS)
+    if (ssl.dataSSL && !hasher && BIO_get_ktls_send(SSL_get_wbio(ssl.dataSSL))) {
+        // 内核TLS：由内核完成加密，文件内容同样不经过用户空间
+        while (transferred < fileSize && !transferStopped()) {
+            size_t chunk = static_cast<size_t>(std::min<int64_t>(transferChunk(ZERO_COPY_CHUNK),
+                                                                 fileSize - transferred));
+            ERR_clear_error();
+            ossl_ssize_t sent = SSL_sendfile(ssl.dataSSL, file.nativeHandle(),
+                                             static_cast<off_t>(transferred), chunk, 0);
+            if (sent <= 0 && SSL_get_error(ssl.dataSSL, static_cast<int>(sent)) == SSL_ERROR_WANT_WRITE) {
+                if (!waitSocket(dataSocket, true)) {
+                    lastError = "Failed to send file data over kernel TLS: " + lastError;
+                    return false;
+                }
+                continue;
+            }
+            if (sent <= 0) {
+                lastError = "Failed to send file data over kernel TLS";
+                return false;
+            }
+            transferred += sent;
+            reporter.update(transferred);
+            throttle(static_cast<size_t>(sent));
+        }
+        return true;
+    }
+#endif
+
+    // 通用路径：读入缓冲区后发送，大块读写减少 TLS 记录与系统调用的次数
+    const size_t SEND_BUFFER_SIZE = 256 * 1024;
+    if (!transferBuffer.reserve(SEND_BUFFER_SIZE)) {
+        lastError = "Failed to allocate transfer buffer";
+        return false;
+    }
+
+    while (transferred < fileSize && !transferStopped()) {
+        size_t want = static_cast<size_t>(std::min<int64_t>(transferChunk(SEND_BUFFER_SIZE),
+                                                            fileSize - transferred));
+        int64_t readCount = file.readAt(transferred, transferBuffer.data(), want);
+        if (readCount < 0) {
+            lastError = "Failed to read local file";
+            return false;
+        }
+        if (readCount == 0) {
+            break;  // 文件在传输过程中被截断
+        }
+
+        if (!sendAll(dataSocket, transferBuffer.data(), static_cast<size_t>(readCount))) {
+            lastError = "Failed to send file data: " + lastError;
+            return false;
+        }
+        if (hasher) {
+            hasher->update(transferBuffer.data(), static_cast<size_t>(readCount));
+        }
+
+        transferred += readCount;
+        reporter.update(transferred);
+        throttle(static_cast<size_t>(readCount));
+    }
+
+    return true;
+}
+
+bool FTPClient::sendCompressedData(SOCKET dataSocket, LocalFile& file, int64_t& transferred,
+                                   int64_t fileSize, ProgressReporter& reporter, Hasher* hasher) {
+    const size_t SEND_BUFFER_SIZE = 256 * 1024;
+    if (!transferBuffer.reserve(SEND_BUFFER_SIZE)) {
+        lastError = "Failed to allocate transfer buffer";
+        return false;
+    }
+
+    Deflater deflater(compressionLevel);
+    if (!deflater.valid()) {
+        lastError = "Failed to initialize compression";
+        return false;
+    }
+
+    // 限速按压缩后实际发送的字节数计算
+    auto output = [&](const char* data, size_t size) {
+        if (!sendAll(dataSocket, data, size)) {
+            lastError = "Failed to send file data: " + lastError;
+            return false;
+        }
+        throttle(size);
+        return true;
+    };
+
+    while (transferred < fileSize && !transferStopped()) {
+        size_t want = static_cast<size_t>(std::min<int64_t>(SEND_BUFFER_SIZE, fileSize - transferred));
+        int64_t readCount = file.readAt(transferred, transferBuffer.data(), want);
+        if (readCount < 0) {
+            lastError = "Failed to read local file";
+            return false;
+        }
+        if (readCount == 0) {
+            break;  // 文件在传输过程中被截断
+        }
+
+        if (!deflater.write(transferBuffer.data(), static_cast<size_t>(readCount), false, output)) {
+            if (lastError.empty()) {
+                lastError = "Failed to compress file data";
+            }
+            return false;
+        }
+        if (hasher) {
+            hasher->update(transferBuffer.data(), static_cast<size_t>(readCount));
+        }
+        transferred += readCount;
+        reporter.update(transferred);
+    }
+
+    if (transferStopped()) {
+        return false;
+    }
+
+    // 结束压缩流，服务器据此确认数据完整
+    if (!deflater.write(nullptr, 0, true, output)) {
+        if (lastError.empty()) {
+            lastError = "Failed to compress file data";
+        }
+        return false;
+    }
+    return true;
+}
+
+bool FTPClient::downloadFile(const std::string& remotePath,
+                           const std::string& localPath,
+                           bool resume,
+                           const ProgressCallback& progress) {
+    bool compress = useCompression(remotePath, nullptr);
+    limiter = std::make_shared<RateLimiter>(rateLimits);
+
+    lastIntegrity = IntegrityResult();
+    std::unique_ptr<Hasher> hasher;
+    HashAlgorithm algorithm;
+    if (integrityCheck && checksumAlgorithm(algorithm)) {
+        hasher.reset(new Hasher(algorithm));
+    }
+
+    // 创建数据连接，获取远程文件大小的 SIZE 与 PASV 一起发送
+    std::vector<FTPResponse> setupReplies;
+    SOCKET dataSocket = createDataConnection({sizeCommand(remotePath)}, &setupReplies, compress);
+    if (dataSocket == INVALID_SOCKET) {
+        return false;
+    }
+    compress = compress && modeZ;
+
+    int64_t fileSize = parseSizeReply(setupReplies[0]);
+    if (fileSize < 0) {
+        lastError = "Failed to get file size: " + setupReplies[0].msg;
+        closeDataConnection(dataSocket);
+        return false;
+    }
+
+    // 打开本地文件，续传时保留已有内容
+    LocalFile file;
+    if (!file.open(localPath, resume ? LocalFile::Mode::READ_WRITE : LocalFile::Mode::WRITE)) {
+        lastError = "Cannot open local file: " + localPath;
+        closeDataConnection(dataSocket);
+        return false;
+    }
+
+    // 处理断点续传
+    int64_t startPos = 0;
+    if (resume) {
+        startPos = std::max<int64_t>(file.size(), 0);
+
+        // 服务器不支持 REST 时无法从中间继续，从头下载
+        bool restartable = startPos >= fileSize || supportsRestart();
+
+        // 校验时先比较本地已有部分，不一致则从头下载
+        bool checkPrefix = hasher && startPos > 0 && startPos < fileSize && restartable;
+        bool checkWhole = hasher && startPos >= fileSize;
+        if (checkPrefix || checkWhole) {
+            // 服务器读完文件才回复校验值，期间不保留空闲的数据连接，校验后重新建立
+            closeDataConnection(dataSocket);
+            dataSocket = INVALID_SOCKET;
+        }
+
+        bool consistent = true;
+        if (checkPrefix) {
+            consistent = verifyPrefix(remotePath, file, startPos, false, *hasher);
+        } else if (checkWhole) {
+            consistent = startPos == fileSize && hashLocalFile(file, fileSize, *hasher) &&
+                         verifyTransfer(remotePath, *hasher);
+        }
+        if (!consistent || !restartable) {
+            if (hasher) {
+                hasher->reset();
+            }
+            startPos = 0;
+            lastIntegrity = IntegrityResult();
+            lastIntegrity.restarted = !consistent;
+            if (!file.resize(0)) {
+                lastError = "Failed to truncate local file: " + localPath;
+                if (dataSocket != INVALID_SOCKET) {
+                    closeDataConnection(dataSocket);
+                }
+                return false;
+            }
+        }
+
+        if (startPos >= fileSize) {
+            if (dataSocket != INVALID_SOCKET) {
+                closeDataConnection(dataSocket);
+            }
+            ProgressReporter(progress, progressOptions, fileSize, fileSize).finish(fileSize);
+            return true; // 文件已完全下载
+        }
+    }
+
+    if (dataSocket == INVALID_SOCKET) {
+        dataSocket = createDataConnection({}, nullptr, compress);
+        if (dataSocket == INVALID_SOCKET) {
+            return false;
+        }
+    }
+
+    // 按 SIZE 结果预留磁盘空间，失败时不影响下载
+    file.preallocate(fileSize);
+
+    // 发送RETR命令（续传时与 REST 一起发送）
+    if (!startTransfer("RETR " + remotePath, startPos, dataSocket)) {
+        return false;
+    }
+
+    // 接收文件数据
+    int64_t transferred = startPos;
+    ProgressReporter reporter(progress, progressOptions, fileSize, startPos);
+    auto onData = [&](int64_t) {
+        reporter.update(transferred);
+    };
+    bool success = compress ? receiveCompressedData(dataSocket, file, transferred, onData, hasher.get())
+                            : receiveFileData(dataSocket, file, transferred, fileSize, onData,
+                                              hasher.get());
+
+    file.close();
+    if (transferStopped()) {
+        abortTransfer(dataSocket);
+        return false;
+    }
+
+    // 关闭连接
+    closeDataConnection(dataSocket);
+
+    // 获取传输完成响应；数据传输超时或未收到响应时保留传输本身的错误
+    FTPResponse response = getResponse();
+    if (response.code != 226 && response.code != 250) {
+        if (success || (response.code != 0 && !transferTimedOut)) {
+            lastError = "File transfer failed: " + response.msg;
+        }
+        return false;
+    }
+
+    if (success && hasher && !verifyTransfer(remotePath, *hasher)) {
+        return false;
+    }
+    if (success) {
+        reporter.finish(transferred);
+    }
+    return success;
+}
+
+bool FTPClient::receiveFileData(SOCKET dataSocket, LocalFile& file, int64_t& offset, int64_t end,
+                                const std::function<void(int64_t)>& onData, Hasher* hasher) {
+    // 大块接收缓冲区，在同一客户端的多次传输间复用
+    const size_t RECEIVE_BUFFER_SIZE = 1024 * 1024;
+
+#ifdef __linux__
+    if (!ssl.dataSSL && !hasher) {
+        // 明文数据连接：socket -> 管道 -> 文件，数据不经过用户空间
+        int pipeFds[2];
+        if (pipe2(pipeFds, O_CLOEXEC) == 0) {
+            bool fallback = false;
+            bool failed = false;
+
+            while (offset < end && !fallback && !failed && !transferStopped()) {
+                size_t chunk = static_cast<size_t>(std::min<int64_t>(transferChunk(RECEIVE_BUFFER_SIZE),
+                                                                     end - offset));
+                ssize_t inPipe = splice(dataSocket, nullptr, pipeFds[1], nullptr,
+                                        chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+                if (inPipe < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (inPipe < 0 && socketWouldBlock()) {
+                    // 数据尚未到达
+                    if (!waitSocket(dataSocket, false)) {
+                        lastError = "Failed to receive file data: " + lastError;
+                        failed = true;
+                        break;
+                    }
+                    continue;
+                }
+                if (inPipe == 0) {
+                    break;  // 连接关闭
+                }
+                if (inPipe < 0) {
+                    if (errno == EINVAL || errno == ENOSYS) {
+                        fallback = true;
+                    } else {
+                        lastError = "Failed to receive file data";
+                        failed = true;
+                    }
+                    break;
+                }
+
+                int64_t received = inPipe;
+                while (inPipe > 0) {
+                    loff_t fileOffset = static_cast<loff_t>(offset + (received - inPipe));
+                    ssize_t written = splice(pipeFds[0], nullptr, file.nativeHandle(), &fileOffset,
+                                             static_cast<size_t>(inPipe), SPLICE_F_MOVE | SPLICE_F_MORE);
+                    if (written < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (written > 0) {
+                        inPipe -= written;
+                        continue;
+                    }
+
+                    // 目标文件系统不支持 splice：取出管道中剩余的数据后改用普通写入
+                    if (written < 0 && (errno == EINVAL || errno == ENOSYS) &&
+                        transferBuffer.reserve(RECEIVE_BUFFER_SIZE)) {
+                        int64_t pos = offset + (received - inPipe);
+                        while (inPipe > 0) {
+                            ssize_t n = read(pipeFds[0], transferBuffer.data(),
+                                             std::min<size_t>(transferBuffer.size(), static_cast<size_t>(inPipe)));
+                            if (n <= 0 || !file.writeAt(pos, transferBuffer.data(), static_cast<size_t>(n))) {
+                                break;
+                            }
+                            pos += n;
+                            inPipe -= n;
+                        }
+                        fallback = inPipe == 0;
+                    }
+                    if (!fallback) {
+                        lastError = "Failed to write local file";
+                        failed = true;
+                    }
+                    break;
+                }
+
+                if (inPipe == 0) {
+                    offset += received;
+                    onData(received);
+                    throttle(static_cast<size_t>(received));
+                }
+            }
+
+            close(pipeFds[0]);
+            close(pipeFds[1]);
+            if (!fallback) {
+                return !failed;
+            }
+        }
+    }
+#endif
+
+    if (!transferBuffer.reserve(RECEIVE_BUFFER_SIZE)) {
+        lastError = "Failed to allocate transfer buffer";
+        return false;
+    }
+
+    while (offset < end && !transferStopped()) {
+        // 尽量填满缓冲区再写入：单次读取最多返回一个 TLS 记录（16 KiB）或当前已到达的数据，
+        // 只要还能立即读到数据就继续读，没有数据时才写入已收到的部分
+        int want = static_cast<int>(std::min<int64_t>(transferChunk(transferBuffer.size()), end - offset));
+        int filled = 0;
+        bool closed = false;
+
+        while (filled < want) {
+            int received = receiveSome(dataSocket, ssl.dataSSL, transferBuffer.data() + filled, static_cast<size_t>(want - filled));
+
+            if (received > 0) {
+                filled += received;
+                if (!dataAvailable(dataSocket, ssl.dataSSL)) {
+                    break;
+                }
+            } else if (received == 0) {
+                closed = true;  // 连接关闭
+                break;
+            } else {
+                lastError = "Failed to receive file data: " + lastError;
+                return false;
+            }
+        }
+
+        if (filled > 0) {
+            if (!file.writeAt(offset, transferBuffer.data(), static_cast<size_t>(filled))) {
+                lastError = "Failed to write local file";
+                return false;
+            }
+            if (hasher) {
+                hasher->update(transferBuffer.data(), static_cast<size_t>(filled));
+            }
+            offset += filled;
+            onData(filled);
+            throttle(static_cast<size_t>(filled));
+        }
+        if (closed) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool FTPClient::receiveCompressedData(SOCKET dataSocket, LocalFile& file, int64_t& offset,
+                                      const std::function<void(int64_t)>& onData, Hasher* hasher) {
+    const size_t RECEIVE_BUFFER_SIZE = 1024 * 1024;
+    if (!transferBuffer.reserve(RECEIVE_BUFFER_SIZE)) {
+        lastError = "Failed to allocate transfer buffer";
+        return false;
+    }
+
+    Inflater inflater;
+    bool writeFailed = false;
+    auto output = [&](const char* data, size_t size) {
+        if (!file.writeAt(offset, data, size)) {
+            writeFailed = true;
+            return false;
+        }
+        if (hasher) {
+            hasher->update(data, size);
+        }
+        offset += static_cast<int64_t>(size);
+        onData(static_cast<int64_t>(size));
+        return true;
+    };
+
+    while (!inflater.finished() && !transferStopped()) {
+        int want = static_cast<int>(transferChunk(transferBuffer.size()));
+        int received = receiveSome(dataSocket, ssl.dataSSL, transferBuffer.data(), static_cast<size_t>(want));
+
+        if (received == 0) {
+            break;  // 连接关闭
+        }
+        if (received < 0) {
+            lastError = "Failed to receive file data: " + lastError;
+            return false;
+        }
+        // 限速按压缩后实际接收的字节数计算
+        throttle(static_cast<size_t>(received));
+        if (!inflater.write(transferBuffer.data(), static_cast<size_t>(received), output)) {
+            lastError = writeFailed ? "Failed to write local file" : inflater.error();
+            return false;
+        }
+    }
+
+    if (!inflater.finished() && !transferStopped()) {
+        lastError = "Compressed data stream truncated";
+        return false;
+    }
+    return true;
+}
+
+bool FTPClient::downloadStream(const std::string& remotePath,
+                               int64_t offset,
+                               const std::function<void(int64_t size)>& onStart,
+                               const DataSink& sink,
+                               const ProgressCallback& progress) {
+    // 大块接收缓冲区，与文件下载共用
+    const size_t RECEIVE_BUFFER_SIZE = 1024 * 1024;
+
+    std::vector<FTPResponse> setupReplies;
+    SOCKET dataSocket = createDataConnection({sizeCommand(remotePath)}, &setupReplies);
+    if (dataSocket == INVALID_SOCKET) {
+        return false;
+    }
+
+    // 不支持 SIZE 的服务器仍可传输，只是无法预知总长度
+    int64_t fileSize = parseSizeReply(setupReplies[0]);
+    offset = std::max<int64_t>(offset, 0);
+    if (onStart) {
+        onStart(fileSize);
+    }
+    if (fileSize >= 0 && offset >= fileSize) {
+        closeDataConnection(dataSocket);
+        ProgressReporter(progress, progressOptions, fileSize, fileSize).finish(fileSize);
+        return true;
+    }
+
+    if (!transferBuffer.reserve(RECEIVE_BUFFER_SIZE)) {
+        lastError = "Failed to allocate transfer buffer";
+        closeDataConnection(dataSocket);
+        return false;
+    }
+
+    limiter = std::make_shared<RateLimiter>(rateLimits);
+    if (!startTransfer("RETR " + remotePath, offset, dataSocket)) {
+        return false;
+    }
+
+    int64_t transferred = offset;
+    ProgressReporter reporter(progress, progressOptions, fileSize, offset);
+    bool success = true;
+    bool aborted = false;
+
+    while (success && !transferStopped()) {
+        int want = static_cast<int>(transferChunk(transferBuffer.size()));
+        int received = receiveSome(dataSocket, ssl.dataSSL, transferBuffer.data(), static_cast<size_t>(want));
+
+        if (received == 0) {
+            break;  // 连接关闭
+        }
+        if (received < 0) {
+            lastError = "Failed to receive file data: " + lastError;
+            success = false;
+            break;
+        }
+        if (!sink(transferBuffer.data(), static_cast<size_t>(received))) {
+            lastError = "Transfer aborted by receiver";
+            success = false;
+            aborted = true;
+            break;
+        }
+        transferred += received;
+        reporter.update(transferred);
+        throttle(static_cast<size_t>(received));
+    }
+
+    if (transferStopped()) {
+        abortTransfer(dataSocket);
+        return false;
+    }
+
+    // 中止时提前关闭数据连接，服务器随后以 426 等响应结束传输
+    closeDataConnection(dataSocket);
+
+    FTPResponse response = getResponse();
+    if (!aborted && response.code != 226 && response.code != 250) {
+        lastError = "File transfer failed: " + response.msg;
+        return false;
+    }
+
+    if (success) {
+        reporter.finish(transferred);
+    }
+    return success;
+}
+
+bool FTPClient::uploadStream(const std::string& remotePath,
+                             int64_t offset,
+                             int64_t totalSize,
+                             const DataSource& source,
+                             const ProgressCallback& progress) {
+    const size_t SEND_BUFFER_SIZE = 256 * 1024;
+
+    if (!transferBuffer.reserve(SEND_BUFFER_SIZE)) {
+        lastError = "Failed to allocate transfer buffer";
+        return false;
+    }
+
+    SOCKET dataSocket = createDataConnection();
+    if (dataSocket == INVALID_SOCKET) {
+        return false;
+    }
+
+    // 服务器不支持 REST 时以 APPE 追加续传
+    offset = std::max<int64_t>(offset, 0);
+    limiter = std::make_shared<RateLimiter>(rateLimits);
+    bool append = offset > 0 && !supportsRestart();
+    if (!startTransfer((append ? "APPE " : "STOR ") + remotePath, append ? 0 : offset, dataSocket)) {
+        return false;
+    }
+
+    int64_t transferred = offset;
+    ProgressReporter reporter(progress, progressOptions, totalSize, offset);
+    bool success = true;
+
+    while (success && !transferStopped()) {
+        size_t size = 0;
+        if (!source(transferBuffer.data(), transferChunk(std::min(transferBuffer.size(), SEND_BUFFER_SIZE)), size)) {
+            lastError = "Upload stream aborted";
+            success = false;
+            break;
+        }
+        if (size == 0) {
+            break;  // 数据结束
+        }
+
+        size_t sentTotal = 0;
+        while (sentTotal < size) {
+            int sent = sendSome(dataSocket, ssl.dataSSL, transferBuffer.data() + sentTotal, size - sentTotal);
+            if (sent < 0) {
+                lastError = "Failed to send file data: " + lastError;
+                success = false;
+                break;
+            }
+            sentTotal += static_cast<size_t>(sent);
+        }
+
+        transferred += static_cast<int64_t>(sentTotal);
+        reporter.update(transferred);
+        throttle(sentTotal);
+    }
+
+    if (transferStopped()) {
+        abortTransfer(dataSocket);
+        return false;
+    }
+
+    // 数据来源中止时服务器仍会保存已收到的部分，可稍后以 offset 续传
+    closeDataConnection(dataSocket, true);
+
+    FTPResponse response = getResponse();
+    if (success && response.code != 226 && response.code != 250) {
+        lastError = "File transfer failed: " + response.msg;
+        return false;
+    }
+
+    if (success) {
+        reporter.finish(transferred);
     }
-    return info;
+    return success;
 }
 
-bool FTPClient::initSSL() {
-    const SSL_METHOD* method = TLS_client_method();
-    if (!method) {
-        lastError = "Failed to create SSL method";
+bool FTPClient::downloadFileSegmented(const std::string& remotePath,
+                                      const std::string& localPath,
+                                      int segments,
+                                      bool resume,
+                                      const ProgressCallback& progress) {
+    // ASCII模式下服务器端偏移与本地字节数不对应，服务器不支持 REST 时无法按区间下载，只能单连接下载
+    if (segments <= 1 || transferType == TransferType::ASCII || !supportsRestart()) {
+        return downloadFile(remotePath, localPath, resume, progress);
+    }
+
+    int64_t fileSize = getFileSize(remotePath);
+    if (fileSize < 0) {
         return false;
     }
 
-    ssl.ctx = SSL_CTX_new(method);
-    if (!ssl.ctx) {
-        lastError = "Failed to create SSL context";
+    // 分段过小时并行收益抵不上额外连接的开销
+    int64_t maxSegments = std::max<int64_t>(1, fileSize / MIN_SEGMENT_SIZE);
+    if (segments > maxSegments) {
+        segments = static_cast<int>(maxSegments);
+    }
+    if (segments <= 1) {
+        return downloadFile(remotePath, localPath, resume, progress);
+    }
+
+    // 加载或重新规划分段表
+    std::string mapPath = localPath + ".segments";
+    std::vector<Segment> plan;
+    std::error_code ec;
+    bool hasMap = std::filesystem::exists(mapPath, ec);
+    bool fresh = !(resume && hasMap && loadSegmentMap(mapPath, fileSize, plan));
+    if (fresh && hasMap) {
+        // 分段表过期或损坏：本地文件已按完整大小预分配，其内容无法判断哪些已下载，只能从头开始
+        std::remove(mapPath.c_str());
+    }
+
+    LocalFile file;
+    if (!file.open(localPath, LocalFile::Mode::READ_WRITE)) {
+        lastError = "Cannot open local file: " + localPath;
         return false;
     }
 
-    // 配置证书验证
-    if (tlsConfig.verify_peer) {
-        SSL_CTX_set_verify(ssl.ctx, SSL_VERIFY_PEER, nullptr);
-        
-        // 加载CA证书
-        if (!tlsConfig.ca_file.empty() || !tlsConfig.ca_path.empty()) {
-            if (!SSL_CTX_load_verify_locations(ssl.ctx, 
-                tlsConfig.ca_file.empty() ? nullptr : tlsConfig.ca_file.c_str(),
-                tlsConfig.ca_path.empty() ? nullptr : tlsConfig.ca_path.c_str())) {
-                lastError = "Failed to load CA certificates";
-                return false;
-            }
-        } else {
-            SSL_CTX_set_default_verify_paths(ssl.ctx);
+    if (fresh) {
+        // 没有分段表时，已存在的本地文件前缀视为已完成（与 downloadFile 的续传语义一致）
+        int64_t existing = resume && !hasMap ? std::min(file.size(), fileSize) : 0;
+        if (existing < 0) {
+            existing = 0;
         }
-    }
 
-    // 加载客户端证书
-    if (!tlsConfig.cert_file.empty()) {
-        if (SSL_CTX_use_certificate_file(ssl.ctx, tlsConfig.cert_file.c_str(), SSL_FILETYPE_PEM) <= 0) {
-            lastError = "Failed to load client certificate";
-            return false;
+        plan.clear();
+        if (existing > 0) {
+            plan.push_back({0, existing, existing});
+        }
+        int64_t remaining = fileSize - existing;
+        int64_t segSize = (remaining + segments - 1) / segments;
+        for (int64_t pos = existing; pos < fileSize; pos += segSize) {
+            plan.push_back({pos, std::min(pos + segSize, fileSize), 0});
         }
-    }
 
-    // 加载客户端私钥
-    if (!tlsConfig.key_file.empty()) {
-        if (SSL_CTX_use_PrivateKey_file(ssl.ctx, tlsConfig.key_file.c_str(), SSL_FILETYPE_PEM) <= 0) {
-            lastError = "Failed to load client private key";
+        if (!file.resize(fileSize)) {
+            lastError = "Failed to preallocate local file: " + localPath;
             return false;
         }
-
-        // 验证私钥
-        if (!SSL_CTX_check_private_key(ssl.ctx)) {
-            lastError = "Client private key does not match the certificate public key";
+        if (!saveSegmentMap(mapPath, fileSize, plan)) {
+            lastError = "Failed to write segment map: " + mapPath;
             return false;
         }
     }
+    file.close();
 
-    return true;
-}
-
-bool FTPClient::upgradeToTLS() {
-    if (!sendCommand("AUTH TLS")) {
-        return false;
+    // 相对路径需要在并行会话中切换到相同的工作目录
+    std::string workDir;
+    if (remotePath.empty() || remotePath[0] != '/') {
+        workDir = getCurrentDir();
     }
 
-    FTPResponse response = getResponse();
-    if (response.code != 234) {
-        lastError = "Server doesn't support TLS: " + response.msg;
-        return false;
-    }
+    // 各分段共用一个限速器，单个传输的限速作用于整个文件
+    limiter = std::make_shared<RateLimiter>(rateLimits);
 
-    ssl.ssl = SSL_new(ssl.ctx);
-    if (!ssl.ssl) {
-        lastError = "Failed to create SSL object";
-        return false;
+    std::mutex planMutex;
+    std::atomic<int64_t> transferred(0);
+    for (const auto& seg : plan) {
+        transferred += seg.done;
     }
+    ProgressReporter reporter(progress, progressOptions, fileSize, transferred);
+    std::string firstError;
 
-    SSL_set_fd(ssl.ssl, static_cast<int>(controlSocket));
+    auto runSegment = [&](size_t index) {
+        std::string error;
+        int64_t start, end;
+        {
+            std::lock_guard<std::mutex> lock(planMutex);
+            start = plan[index].start + plan[index].done;
+            end = plan[index].end;
+        }
 
-    if (SSL_connect(ssl.ssl) != 1) {
-        lastError = "SSL handshake failed";
-        unsigned long err = ERR_get_error();
-        char err_buf[256];
-        ERR_error_string_n(err, err_buf, sizeof(err_buf));
-        lastError += ": " + std::string(err_buf);
-        return false;
-    }
+        LocalFile segFile;
+        std::unique_ptr<FTPClient> sibling;
+        if (!segFile.open(localPath, LocalFile::Mode::READ_WRITE)) {
+            error = "Cannot open local file: " + localPath;
+        } else {
+            sibling = openSiblingSession(workDir, error);
+        }
 
-    ssl.initialized = true;
+        if (sibling) {
+            sibling->limiter = limiter;
+            int64_t unsaved = 0;
+            auto onData = [&](int64_t bytes) {
+                int64_t total = transferred += bytes;
+                unsaved += bytes;
+
+                std::lock_guard<std::mutex> lock(planMutex);
+                plan[index].done += bytes;
+                if (unsaved >= SEGMENT_SAVE_INTERVAL) {
+                    saveSegmentMap(mapPath, fileSize, plan);
+                    unsaved = 0;
+                }
+                reporter.update(total);
+            };
 
-    // 设置保护缓冲区大小为0
-    if (!sendCommand("PBSZ 0")) {
-        return false;
+            if (!sibling->downloadRange(remotePath, segFile, start, end, onData)) {
+                error = sibling->getLastError();
+            }
+            sibling->disconnect();
+        }
+
+        if (!error.empty()) {
+            std::lock_guard<std::mutex> lock(planMutex);
+            if (firstError.empty()) {
+                firstError = error;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < plan.size(); ++i) {
+        if (plan[i].done < plan[i].end - plan[i].start) {
+            workers.emplace_back(runSegment, i);
+        }
     }
-    response = getResponse();
-    if (response.code != 200) {
-        lastError = "Failed to set protection buffer size: " + response.msg;
-        return false;
+    for (auto& worker : workers) {
+        worker.join();
     }
 
-    // 设置数据通道保护级别为私密
-    if (!sendCommand("PROT P")) {
+    bool complete = std::all_of(plan.begin(), plan.end(), [](const Segment& seg) {
+        return seg.done == seg.end - seg.start;
+    });
+
+    if (!complete) {
+        saveSegmentMap(mapPath, fileSize, plan);
+        lastError = firstError.empty() ? "Segmented download incomplete" : firstError;
         return false;
     }
-    response = getResponse();
-    if (response.code != 200) {
-        lastError = "Failed to set protection level: " + response.msg;
-        return false;
+
+    std::remove(mapPath.c_str());
+
+    // 分段乱序到达，完成后读取整个文件计算校验值
+    HashAlgorithm algorithm;
+    lastIntegrity = IntegrityResult();
+    if (integrityCheck && checksumAlgorithm(algorithm)) {
+        Hasher hasher(algorithm);
+        if (!file.open(localPath, LocalFile::Mode::READ)) {
+            lastError = "Cannot open local file: " + localPath;
+            return false;
+        }
+        if (!hashLocalFile(file, fileSize, hasher) || !verifyTransfer(remotePath, hasher)) {
+            return false;
+        }
+        file.close();
     }
 
-    ssl.protected_mode = true;
+    reporter.finish(fileSize);
     return true;
 }
 
-bool FTPClient::connect(const std::string& host, uint16_t port) {
-    controlSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (controlSocket == INVALID_SOCKET) {
-        lastError = "Failed to create control socket";
+std::unique_ptr<FTPClient> FTPClient::openSiblingSession(const std::string& workDir,
+                                                         std::string& error) const {
+    std::unique_ptr<FTPClient> sibling(new FTPClient());
+    sibling->tlsConfig = tlsConfig;
+    sibling->transferMode = transferMode;
+    sibling->transferControl = transferControl;
+    sibling->rateLimits = rateLimits;
+    sibling->compression = compression;
+    sibling->compressionLevel = compressionLevel;
+    sibling->integrityCheck = integrityCheck;
+    sibling->timeouts = timeouts;
+    sibling->socketOptions = socketOptions;
+
+    bool ok = sibling->connect(serverHost, serverPort);
+    if (ok && ssl.protected_mode) {
+        ok = sibling->initSSL() && sibling->upgradeToTLS();
+    }
+    ok = ok && sibling->login(loginUser, loginPassword);
+    ok = ok && sibling->setTransferType(TransferType::BINARY);
+    if (ok && !workDir.empty()) {
+        ok = sibling->changeDir(workDir);
+    }
+
+    if (!ok) {
+        error = sibling->getLastError();
+        return nullptr;
+    }
+    return sibling;
+}
+
+bool FTPClient::downloadRange(const std::string& remotePath, LocalFile& file,
+                              int64_t start, int64_t end,
+                              const std::function<void(int64_t)>& onData) {
+    SOCKET dataSocket = createDataConnection();
+    if (dataSocket == INVALID_SOCKET) {
         return false;
     }
 
-    struct addrinfo hints = {}, *result = nullptr;
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-    
-    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) {
-        lastError = "Failed to resolve host address";
-        closesocket(controlSocket);
-        controlSocket = INVALID_SOCKET;
+    if (!startTransfer("RETR " + remotePath, start, dataSocket)) {
         return false;
     }
 
-    if (::connect(controlSocket, result->ai_addr, (int)result->ai_addrlen) == SOCKET_ERROR) {
-        lastError = "Failed to connect to server";
-        freeaddrinfo(result);
-        closesocket(controlSocket);
-        controlSocket = INVALID_SOCKET;
+    // 只接收本分段的字节，到达区间末尾后主动关闭数据连接
+    int64_t offset = start;
+    bool success = receiveFileData(dataSocket, file, offset, end, onData, nullptr);
+
+    bool complete = success && offset >= end;
+    if (!complete && transferStopped()) {
+        abortTransfer(dataSocket);
         return false;
     }
 
-    freeaddrinfo(result);
+    closeDataConnection(dataSocket);
 
+    // 提前关闭数据连接时服务器通常回复 426/451，这对分段下载是正常结果
     FTPResponse response = getResponse();
-    if (response.code != 220) {
-        lastError = "Server rejected connection: " + response.msg;
-        disconnect();
-        return false;
+    if (complete) {
+        return response.code == 226 || response.code == 250 ||
+               response.code == 426 || response.code == 450 || response.code == 451;
     }
 
-    return true;
-}
-
-bool FTPClient::sendCommand(const std::string& command) {
-    std::string cmd = command + "\r\n";
-    
-    if (ssl.initialized) {
-        int sent = SSL_write(ssl.ssl, cmd.c_str(), static_cast<int>(cmd.length()));
-        if (sent <= 0) {
-            int err = SSL_get_error(ssl.ssl, sent);
-            char err_buf[256];
-            ERR_error_string_n(ERR_get_error(), err_buf, sizeof(err_buf));
-            lastError = "Failed to send command over SSL: " + std::string(err_buf);
-            return false;
-        }
-    } else {
-        if (send(controlSocket, cmd.c_str(), cmd.length(), 0) != cmd.length()) {
-            lastError = "Failed to send command";
-            return false;
+    if (success) {
+        lastError = "Data connection closed before segment end";
+        if (response.code != 226 && response.code != 250) {
+            lastError = "File transfer failed: " + response.msg;
         }
     }
-    return true;
+    return false;
 }
 
-FTPResponse FTPClient::getResponse() {
-    FTPResponse response;
-    char buffer[1024];
-    std::string responseStr;
-
-    while (true) {
-        int received;
-        if (ssl.initialized) {
-            received = SSL_read(ssl.ssl, buffer, sizeof(buffer) - 1);
-            if (received <= 0) {
-                int err = SSL_get_error(ssl.ssl, received);
-                char err_buf[256];
-                ERR_error_string_n(ERR_get_error(), err_buf, sizeof(err_buf));
-                response.code = 0;
-                response.msg = "SSL read error: " + std::string(err_buf);
-                return response;
+bool FTPClient::mirror(const std::string& localDir,
+                       const std::string& remoteDir,
+                       const MirrorOptions& options,
+                       MirrorSummary& summary,
+                       const ProgressCallback& progress) {
+    summary = MirrorSummary();
+    bool download = options.direction == MirrorOptions::Direction::DOWNLOAD;
+
+    // ---- 遍历远程目录树 ----
+    MirrorTree remoteTree;
+    bool remoteExists = true;
+    std::vector<std::string> pendingDirs(1, std::string());
+    while (!pendingDirs.empty()) {
+        std::string rel = pendingDirs.back();
+        pendingDirs.pop_back();
+
+        bool listed = listDirectory(joinPath(remoteDir, rel), [&](const FileEntry& entry) {
+            std::string childRel = joinPath(rel, entry.name);
+            if (entry.type == FileEntry::Type::DIRECTORY) {
+                remoteTree[childRel] = {true, -1, -1};
+                pendingDirs.push_back(childRel);
+            } else if (entry.type == FileEntry::Type::FILE) {
+                remoteTree[childRel] = {false, entry.size, entry.mtime};
             }
-        } else {
-            received = recv(controlSocket, buffer, sizeof(buffer) - 1, 0);
-            if (received <= 0) {
-                response.code = 0;
-                response.msg = "Connection closed by server";
-                return response;
-            }
-        }
-
-        buffer[received] = '\0';
-        responseStr += buffer;
-
-        // 检查是否收到完整响应
-        size_t pos = responseStr.find_last_of('\n');
-        if (pos != std::string::npos) {
-            std::string lastLine = responseStr.substr(responseStr.find_last_of('\n', pos - 1) + 1);
-            // 检查FTP响应格式(3个数字 + 空格)
-            if (lastLine.length() >= 4 && 
-                std::isdigit(lastLine[0]) && 
-                std::isdigit(lastLine[1]) && 
-                std::isdigit(lastLine[2]) && 
-                lastLine[3] == ' ') {
+        });
+
+        if (!listed) {
+            // 上传时远程根目录可以不存在
+            if (rel.empty() && !download) {
+                remoteExists = false;
                 break;
             }
+            return false;
         }
     }
 
-    // 解析响应码和消息
-    if (responseStr.length() >= 3) {
-        response.code = std::stoi(responseStr.substr(0, 3));
-        size_t msgStart = responseStr.find_first_of(' ');
-        if (msgStart != std::string::npos) {
-            response.msg = responseStr.substr(msgStart + 1);
-            // 移除尾部的\r\n
-            while (!response.msg.empty() && 
-                   (response.msg.back() == '\n' || response.msg.back() == '\r')) {
-                response.msg.pop_back();
-            }
-        }
+    // ---- 遍历本地目录树 ----
+    MirrorTree localTree;
+    bool localExists = scanLocalTree(localDir, localTree);
+    if (!localExists && !download) {
+        lastError = "Local directory not found: " + localDir;
+        return false;
     }
 
-    return response;
-}
+    const MirrorTree& source = download ? remoteTree : localTree;
+    const MirrorTree& target = download ? localTree : remoteTree;
 
-bool FTPClient::login(const std::string& username, const std::string& password) {
-    if (!sendCommand("USER " + username)) {
-        return false;
-    }
+    // LIST 的修改时间只精确到分钟且使用服务器本地时区，大小相同时改用 MDTM 比较
+    bool preciseRemoteTime = supportsMLSD();
 
-    FTPResponse response = getResponse();
-    if (response.code != 331 && response.code != 230) {
-        lastError = "Login failed: " + response.msg;
-        return false;
+    // ---- 比较两侧，生成同步计划 ----
+    if (download ? !localExists : !remoteExists) {
+        summary.dirs.push_back("");
     }
 
-    if (response.code == 331) {
-        if (!sendCommand("PASS " + password)) {
-            return false;
-        }
+    std::vector<std::string> files;
+    int64_t totalBytes = 0;
+    for (const auto& pair : source) {
+        const std::string& rel = pair.first;
+        const MirrorNode& node = pair.second;
+        auto it = target.find(rel);
 
-        response = getResponse();
-        if (response.code != 230) {
-            lastError = "Login failed: " + response.msg;
-            return false;
+        if (node.isDir) {
+            if (it == target.end()) {
+                summary.dirs.push_back(rel);
+            }
+            continue;
         }
-    }
-
-    return true;
-}
 
-void FTPClient::disconnect() {
-    if (controlSocket != INVALID_SOCKET) {
-        if (ssl.initialized) {
-            sendCommand("QUIT");
-            if (ssl.ssl) {
-                SSL_shutdown(ssl.ssl);
-                SSL_free(ssl.ssl);
-                ssl.ssl = nullptr;
+        bool changed = it == target.end() || it->second.isDir || it->second.size != node.size;
+        if (!changed) {
+            int64_t remoteTime = download ? node.mtime : it->second.mtime;
+            if (!preciseRemoteTime) {
+                remoteTime = getModificationTime(joinPath(remoteDir, rel));
             }
-            if (ssl.ctx) {
-                SSL_CTX_free(ssl.ctx);
-                ssl.ctx = nullptr;
+            int64_t localTime = download ? it->second.mtime : node.mtime;
+
+            // 源端更新时才传输；任一侧时间未知时只比较大小
+            if (remoteTime >= 0 && localTime >= 0) {
+                changed = download ? remoteTime > localTime : localTime > remoteTime;
             }
-            ssl.initialized = false;
-            ssl.protected_mode = false;
+        }
+
+        if (changed) {
+            files.push_back(rel);
+            totalBytes += std::max<int64_t>(0, node.size);
         } else {
-            sendCommand("QUIT");
+            ++summary.filesSkipped;
         }
-        closesocket(controlSocket);
-        controlSocket = INVALID_SOCKET;
     }
-}
+    summary.files = files;
 
-SOCKET FTPClient::createDataConnection() {
-    SOCKET dataSocket = INVALID_SOCKET;
+    if (options.dryRun) {
+        return true;
+    }
 
-    if (transferMode == TransferMode::PASSIVE) {
-        if (!sendCommand("PASV")) {
-            return INVALID_SOCKET;
+    // ---- 创建缺失的目录（父目录总是先于子目录）----
+    for (const auto& rel : summary.dirs) {
+        bool created;
+        if (download) {
+            std::error_code ec;
+            std::filesystem::create_directories(std::filesystem::path(joinPath(localDir, rel)), ec);
+            created = !ec;
+            if (!created) {
+                lastError = ec.message();
+            }
+        } else {
+            created = makeDir(joinPath(remoteDir, rel));
         }
 
-        FTPResponse response = getResponse();
-        if (response.code != 227) {
-            lastError = "Failed to enter passive mode: " + response.msg;
-            return INVALID_SOCKET;
+        if (created) {
+            ++summary.dirsCreated;
+        } else {
+            summary.errors.push_back((rel.empty() ? "." : rel) + ": " + lastError);
+            lastError = "Failed to create directory: " + (rel.empty() ? (download ? localDir : remoteDir) : rel);
+            return false;
         }
+    }
 
-        std::string ip;
-        uint16_t port;
-        if (!parsePasvResponse(response.msg, ip, port)) {
-            return INVALID_SOCKET;
+    // ---- 并行传输文件 ----
+    std::string workDir;
+    if (remoteDir.empty() || remoteDir[0] != '/') {
+        workDir = getCurrentDir();
+    }
+
+    std::mutex summaryMutex;
+    std::atomic<size_t> nextFile(0);
+    std::atomic<int64_t> transferred(0);
+    ProgressReporter reporter(progress, progressOptions, totalBytes, 0);
+    std::string sessionError;
+
+    auto transferFile = [&](FTPClient& session, const std::string& rel) {
+        std::string localPath = joinPath(localDir, rel);
+        std::string remotePath = joinPath(remoteDir, rel);
+        const MirrorNode& node = source.at(rel);
+
+        // 各文件的进度汇总为整体进度
+        int64_t fileBytes = 0;
+        auto onProgress = [&](const TransferProgress& p) {
+            int64_t total = transferred += p.current - fileBytes;
+            fileBytes = p.current;
+
+            std::lock_guard<std::mutex> lock(summaryMutex);
+            reporter.update(total);
+        };
+
+        bool ok = download ? session.downloadFile(remotePath, localPath, false, onProgress)
+                           : session.uploadFile(localPath, remotePath, false, onProgress);
+        if (ok && download) {
+            // 本地文件使用远程修改时间，下次同步时两侧时间一致
+            int64_t mtime = preciseRemoteTime ? node.mtime : session.getModificationTime(remotePath);
+            if (mtime >= 0) {
+                setLocalModificationTime(localPath, mtime);
+            }
         }
 
-        dataSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-        if (dataSocket == INVALID_SOCKET) {
-            lastError = "Failed to create data socket";
-            return INVALID_SOCKET;
+        std::lock_guard<std::mutex> lock(summaryMutex);
+        if (ok) {
+            ++summary.filesTransferred;
+            summary.bytesTransferred += std::max<int64_t>(0, node.size);
+        } else {
+            ++summary.filesFailed;
+            summary.errors.push_back(rel + ": " + session.getLastError());
         }
+    };
 
-        struct sockaddr_in addr = {};
-        addr.sin_family = AF_INET;
-        addr.sin_port = htons(port);
-        addr.sin_addr.s_addr = inet_addr(ip.c_str());
-
-        if (::connect(dataSocket, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
-            lastError = "Failed to connect to data port";
-            closesocket(dataSocket);
-            return INVALID_SOCKET;
+    auto runWorker = [&](FTPClient* session) {
+        size_t index;
+        while (!transferStopped() && (index = nextFile++) < files.size()) {
+            transferFile(*session, files[index]);
         }
+    };
 
-        // 如果是TLS模式，为数据连接建立SSL
-        if (ssl.protected_mode) {
-            ssl.dataSSL = SSL_new(ssl.ctx);
-            if (!ssl.dataSSL) {
-                lastError = "Failed to create SSL object for data connection";
-                closesocket(dataSocket);
-                return INVALID_SOCKET;
-            }
-
-            // 添加会话恢复
-            SSL_set_fd(ssl.dataSSL, static_cast<int>(dataSocket));
-            SSL_set_session(ssl.dataSSL, SSL_get_session(ssl.ssl));
-
-            if (SSL_connect(ssl.dataSSL) != 1) {
-                lastError = "SSL handshake failed for data connection";
-                SSL_free(ssl.dataSSL);
-                ssl.dataSSL = nullptr;
-                closesocket(dataSocket);
-                return INVALID_SOCKET;
-            }
-        }
+    int workerCount = static_cast<int>(std::min<size_t>(std::max(1, options.parallel), files.size()));
+    if (workerCount <= 1) {
+        runWorker(this);
     } else {
-        // Active mode implementation...
-        // ----------------------
-        //   主动模式实现示例
-        // ----------------------
-
-        // 1) 创建一个监听 socket
-        SOCKET dataListenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-        if (dataListenSocket == INVALID_SOCKET) {
-            lastError = "Failed to create data listen socket";
-            return INVALID_SOCKET;
+        std::vector<std::thread> workers;
+        for (int i = 0; i < workerCount; ++i) {
+            workers.emplace_back([&]() {
+                std::string error;
+                std::unique_ptr<FTPClient> sibling = openSiblingSession(workDir, error);
+                if (!sibling) {
+                    std::lock_guard<std::mutex> lock(summaryMutex);
+                    sessionError = error;
+                    return;
+                }
+                runWorker(sibling.get());
+                sibling->disconnect();
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
         }
 
-        // 设置套接字可重用、绑定到任意地址和随机端口
-        int opt = 1;
-        setsockopt(dataListenSocket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
+        // 所有并行会话都无法建立时，剩余文件记为失败
+        size_t started = transferStopped() ? files.size() : std::min(nextFile.load(), files.size());
+        for (size_t i = started; i < files.size(); ++i) {
+            ++summary.filesFailed;
+            summary.errors.push_back(files[i] + ": " + sessionError);
+        }
+    }
 
-        sockaddr_in listenAddr;
-        memset(&listenAddr, 0, sizeof(listenAddr));
-        listenAddr.sin_family = AF_INET;
-        // INADDR_ANY 表示绑定到本机所有网卡地址，可根据需要改为具体IP
-        listenAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-        listenAddr.sin_port = 0; // 0 表示让系统自动分配一个空闲端口
+    if (transferStopped()) {
+        // 中止时未开始的文件不计为失败，重新同步时会再次比较
+        lastError = transferControl->pending() == TransferControl::Request::PAUSE
+                        ? "Transfer paused" : "Transfer cancelled";
+        return false;
+    }
 
-        if (bind(dataListenSocket, (sockaddr*)&listenAddr, sizeof(listenAddr)) == SOCKET_ERROR) {
-            lastError = "Failed to bind for active mode";
-            closesocket(dataListenSocket);
-            return INVALID_SOCKET;
-        }
+    reporter.finish(transferred);
 
-        // 开始监听
-        if (listen(dataListenSocket, 1) == SOCKET_ERROR) {
-            lastError = "Failed to listen for active mode";
-            closesocket(dataListenSocket);
-            return INVALID_SOCKET;
-        }
+    if (summary.filesFailed > 0) {
+        lastError = "Failed to transfer " + std::to_string(summary.filesFailed) + " file(s): " + summary.errors.front();
+        return false;
+    }
+    return true;
+}
 
-        // 2) 通过 getsockname 获取实际绑定的端口
-        sockaddr_in localAddr;
-        socklen_t addrLen = sizeof(localAddr);
-        if (getsockname(dataListenSocket, (sockaddr*)&localAddr, &addrLen) != 0) {
-            lastError = "getsockname failed";
-            closesocket(dataListenSocket);
-            return INVALID_SOCKET;
-        }
-        unsigned short localPort = ntohs(localAddr.sin_port);
+int64_t FTPClient::getModificationTime(const std::string& path) {
+    if (featureMissing("MDTM")) {
+        lastError = "Server does not support MDTM";
+        return -1;
+    }
+    if (!sendCommand("MDTM " + path)) {
+        return -1;
+    }
 
-        // 3) 获取本机 IP 地址
-        // 简单做法：从控制连接 socket 上获取本机IP
-        // （对于 NAT 或多网卡场景，需要更灵活的机制）
-        sockaddr_in ctrlAddr;
-        socklen_t ctrlLen = sizeof(ctrlAddr);
-        if (getsockname(controlSocket, (sockaddr*)&ctrlAddr, &ctrlLen) != 0) {
-            lastError = "Failed to get local IP from control socket";
-            closesocket(dataListenSocket);
-            return INVALID_SOCKET;
-        }
-        unsigned long ip = ntohl(ctrlAddr.sin_addr.s_addr); 
-        // 分别取 h1,h2,h3,h4
-        unsigned char h1 = (ip >> 24) & 0xFF;
-        unsigned char h2 = (ip >> 16) & 0xFF;
-        unsigned char h3 = (ip >>  8) & 0xFF;
-        unsigned char h4 =  ip        & 0xFF;
+    FTPResponse response = getResponse();
+    if (response.code != 213) {
+        lastError = "Failed to get modification time: " + response.msg;
+        return -1;
+    }
 
-        // 分别取 p1,p2
-        unsigned char p1 = (localPort >> 8) & 0xFF;
-        unsigned char p2 =  localPort       & 0xFF;
+    return parseFTPTimestamp(response.msg);
+}
 
-        // 4) 发送 PORT 命令给服务器
-        //    格式：PORT h1,h2,h3,h4,p1,p2
-        std::ostringstream portCmd;
-        portCmd << "PORT " 
-                << (int)h1 << "," << (int)h2 << "," 
-                << (int)h3 << "," << (int)h4 << "," 
-                << (int)p1 << "," << (int)p2;
+bool FTPClient::setTransferType(TransferType type) {
+    const char* typeStr = (type == TransferType::ASCII) ? "A" : "I";
+    if (!sendCommand("TYPE " + std::string(typeStr))) {
+        return false;
+    }
 
-        if (!sendCommand(portCmd.str())) {
-            closesocket(dataListenSocket);
-            return INVALID_SOCKET;
-        }
+    FTPResponse response = getResponse();
+    if (response.code != 200) {
+        lastError = "Failed to set transfer type: " + response.msg;
+        return false;
+    }
 
-        FTPResponse resp = getResponse();
-        if (resp.code != 200) {
-            lastError = "Failed to set active mode: " + resp.msg;
-            closesocket(dataListenSocket);
-            return INVALID_SOCKET;
-        }
+    transferType = type;
+    return true;
+}
 
-        // 5) 等待服务器连进来 (accept)
-        sockaddr_in clientAddr;
-        socklen_t clientLen = sizeof(clientAddr);
-        dataSocket = accept(dataListenSocket, (sockaddr*)&clientAddr, &clientLen);
-        // 无论是否 accept 成功，都可以关闭监听 socket
-        closesocket(dataListenSocket);
+std::vector<std::string> FTPClient::listFiles() {
+    std::vector<std::string> fileList;
 
-        if (dataSocket == INVALID_SOCKET) {
-            lastError = "Failed to accept data connection from server";
-            return INVALID_SOCKET;
+    readListing("LIST", [&fileList](std::string_view line) {
+        if (!line.empty()) {
+            fileList.emplace_back(line);
         }
+    });
+
+    return fileList;
+}
 
-        // 6) 如果是 TLS 模式，则为数据连接执行 SSL 握手
-        if (ssl.protected_mode) {
-            ssl.dataSSL = SSL_new(ssl.ctx);
-            if (!ssl.dataSSL) {
-                lastError = "Failed to create SSL object for data connection";
-                closesocket(dataSocket);
-                return INVALID_SOCKET;
-            }
+bool FTPClient::listDirectory(std::vector<FileEntry>& entries, const std::string& path) {
+    entries.clear();
+    return listDirectory(path, [&entries](const FileEntry& entry) {
+        entries.push_back(entry);
+    });
+}
 
-            SSL_set_fd(ssl.dataSSL, static_cast<int>(dataSocket));
-            SSL_set_session(ssl.dataSSL, SSL_get_session(ssl.ssl));
+bool FTPClient::listDirectory(const std::string& path, const ListCallback& onEntry) {
+    bool useMLSD = supportsMLSD();
+    std::string command = useMLSD ? "MLSD" : "LIST";
+    if (!path.empty()) {
+        command += " " + path;
+    }
 
-            if (SSL_connect(ssl.dataSSL) != 1) {
-                lastError = "SSL handshake failed for data connection";
-                SSL_free(ssl.dataSSL);
-                ssl.dataSSL = nullptr;
-                closesocket(dataSocket);
-                return INVALID_SOCKET;
-            }
+    // 每收到一行即解析并回调，不保留整个列表
+    ListingParser parser(useMLSD ? ListingParser::Format::MLSD : ListingParser::Format::LIST);
+    FileEntry entry;
+    return readListing(command, [&](std::string_view line) {
+        if (parser.parseLine(line, entry)) {
+            onEntry(entry);
         }
-    }
+    });
+}
 
-    return dataSocket;
+bool FTPClient::supportsMLSD() {
+    return hasFeature("MLST") || hasFeature("MLSD");
 }
-bool FTPClient::uploadFile(const std::string& localPath, 
-                         const std::string& remotePath,
-                         bool resume,
-                         const ProgressCallback& progress) {
-    // 打开本地文件
-    std::ifstream file(localPath, std::ios::binary);
-    if (!file) {
-        lastError = "Cannot open local file: " + localPath;
-        return false;
+
+const std::string* FTPClient::findFeature(const std::string& name) {
+    if (!featuresLoaded) {
+        loadFeatures();
     }
+    return capabilities.find(name);
+}
 
-    // 获取文件大小
-    file.seekg(0, std::ios::end);
-    int64_t fileSize = file.tellg();
-    file.seekg(0, std::ios::beg);
+bool FTPClient::featureMissing(const std::string& name) {
+    return findFeature(name) == nullptr && capabilities.featSupported;
+}
 
-    // 处理断点续传
-    int64_t startPos = 0;
-    if (resume) {
-        startPos = getFileSize(remotePath);
-        if (startPos > 0) {
-            if (!setFilePosition(startPos)) {
-                file.close();
-                return false;
-            }
-            file.seekg(startPos);
-        }
+std::vector<std::string> FTPClient::getFeatures() {
+    if (!featuresLoaded) {
+        loadFeatures();
     }
+    return capabilities.features;
+}
 
-    // 创建数据连接
-    SOCKET dataSocket = createDataConnection();
-    if (dataSocket == INVALID_SOCKET) {
-        file.close();
-        return false;
+void FTPClient::loadFeatures() {
+    featuresLoaded = true;
+    if (!capabilityKey.empty() && CapabilityCache::instance().get(capabilityKey, capabilities)) {
+        return;
     }
 
-    // 发送STOR命令
-    if (!sendCommand("STOR " + remotePath)) {
-        if (ssl.dataSSL) {
-            SSL_free(ssl.dataSSL);
-            ssl.dataSSL = nullptr;
-        }
-        closesocket(dataSocket);
-        file.close();
-        return false;
+    capabilities.featSupported = false;
+    capabilities.features.clear();
+    if (!sendCommand("FEAT")) {
+        return;
     }
 
     FTPResponse response = getResponse();
-    if (response.code != 150 && response.code != 125) {
-        lastError = "Failed to initiate file transfer: " + response.msg;
-        if (ssl.dataSSL) {
-            SSL_free(ssl.dataSSL);
-            ssl.dataSSL = nullptr;
-        }
-        closesocket(dataSocket);
-        file.close();
-        return false;
-    }
-
-    // 传输文件数据
-    char buffer[8192];
-    int64_t transferred = startPos;
-    bool success = true;
-
-    while (!file.eof() && success) {
-        file.read(buffer, sizeof(buffer));
-        int readCount = static_cast<int>(file.gcount());
-        
-        if (readCount > 0) {
-            int sent;
-            if (ssl.dataSSL) {
-                sent = SSL_write(ssl.dataSSL, buffer, readCount);
-            } else {
-                sent = send(dataSocket, buffer, readCount, 0);
+    if (response.code == 0) {
+        return;     // 连接出错，不缓存
+    }
+    if (response.code == 211) {
+        // 多行响应，特性行以空格开头，例如 " MLST type*;size*;modify*;"；首行与末行是说明文字
+        capabilities.featSupported = true;
+        std::istringstream iss(response.msg);
+        std::string line;
+        while (std::getline(iss, line)) {
+            if (line.empty() || line[0] != ' ') {
+                continue;
             }
-
-            if (sent <= 0) {
-                lastError = "Failed to send file data";
-                success = false;
-            } else {
-                transferred += sent;
-                if (progress) {
-                    progress(transferred, fileSize);
-                }
+            size_t start = line.find_first_not_of(' ');
+            size_t end = line.find_last_not_of(" \r");
+            if (start != std::string::npos && end != std::string::npos && end >= start) {
+                capabilities.features.push_back(line.substr(start, end - start + 1));
             }
         }
     }
+    saveCapabilities();
+}
 
-    // 关闭连接
-    file.close();
-    if (ssl.dataSSL) {
-        SSL_shutdown(ssl.dataSSL);
-        SSL_free(ssl.dataSSL);
-        ssl.dataSSL = nullptr;
-    }
-    closesocket(dataSocket);
-
-    // 获取传输完成响应
-    response = getResponse();
-    if (response.code != 226 && response.code != 250) {
-        lastError = "File transfer failed: " + response.msg;
-        return false;
+void FTPClient::saveCapabilities() {
+    if (!capabilityKey.empty()) {
+        CapabilityCache::instance().put(capabilityKey, capabilities);
     }
-
-    return success;
 }
 
-bool FTPClient::downloadFile(const std::string& remotePath,
-                           const std::string& localPath,
-                           bool resume,
-                           const ProgressCallback& progress) {
-    // 获取远程文件大小
-    int64_t fileSize = getFileSize(remotePath);
-    if (fileSize < 0) {
-        return false;
+std::string FTPClient::sizeCommand(const std::string& path) {
+    if (featureMissing("SIZE")) {
+        const std::string* mlst = findFeature("MLST");
+        if (mlst) {
+            std::string facts = *mlst;
+            std::transform(facts.begin(), facts.end(), facts.begin(), [](unsigned char c) {
+                return static_cast<char>(std::tolower(c));
+            });
+            if (facts.find("size") != std::string::npos) {
+                return "MLST " + path;
+            }
+        }
     }
+    return "SIZE " + path;
+}
 
-    // 处理断点续传
-    std::ios::openmode mode = std::ios::binary;
-    int64_t startPos = 0;
-
-    if (resume) {
-        std::ifstream existingFile(localPath, std::ios::binary | std::ios::ate);
-        if (existingFile) {
-            startPos = existingFile.tellg();
-            existingFile.close();
-            if (startPos >= fileSize) {
-                return true; // 文件已完全下载
+bool FTPClient::checksumAlgorithm(HashAlgorithm& algorithm) {
+    static const HashAlgorithm PREFERENCE[] = {
+        HashAlgorithm::SHA256, HashAlgorithm::SHA1, HashAlgorithm::MD5, HashAlgorithm::CRC32
+    };
+
+    // 优先使用 HASH，其次是各自独立的扩展命令
+    if (const std::string* feature = findFeature("HASH")) {
+        std::string selected;
+        std::vector<HashAlgorithm> offered = parseHashFeature(*feature, selected);
+        if (hashSelection.empty()) {
+            hashSelection = selected;
+        }
+        for (HashAlgorithm candidate : PREFERENCE) {
+            if (std::find(offered.begin(), offered.end(), candidate) != offered.end()) {
+                algorithm = candidate;
+                return true;
             }
-            mode |= std::ios::app;
         }
     }
 
-    // 打开本地文件
-    std::ofstream file(localPath, mode);
-    if (!file) {
-        lastError = "Cannot open local file: " + localPath;
-        return false;
+    for (HashAlgorithm candidate : PREFERENCE) {
+        if (hasFeature(checksumCommand(candidate))) {
+            algorithm = candidate;
+            return true;
+        }
     }
+    return false;
+}
 
-    // 设置断点续传位置
-    if (startPos > 0) {
-        if (!setFilePosition(startPos)) {
-            file.close();
+bool FTPClient::remoteChecksum(const std::string& path, HashAlgorithm algorithm,
+                               int64_t length, std::string& digest) {
+    std::string name = hashAlgorithmName(algorithm);
+    std::vector<std::string> commands;
+    bool useHash = false;
+    if (const std::string* feature = findFeature("HASH")) {
+        std::string selected;
+        std::vector<HashAlgorithm> offered = parseHashFeature(*feature, selected);
+        useHash = std::find(offered.begin(), offered.end(), algorithm) != offered.end();
+    }
+
+    size_t hashIndex = 0;
+    if (useHash) {
+        // HASH 按 OPTS HASH 选定的算法计算，区间由 RANG 指定（闭区间），用后以 "RANG 1 0" 清除
+        if (length >= 0 && !hasFeature("RANG")) {
             return false;
         }
+        if (hashSelection != name) {
+            commands.push_back("OPTS HASH " + name);
+        }
+        if (length >= 0) {
+            commands.push_back("RANG 0 " + std::to_string(length - 1));
+        }
+        hashIndex = commands.size();
+        commands.push_back("HASH " + path);
+        if (length >= 0) {
+            commands.push_back("RANG 1 0");
+        }
+    } else {
+        // 扩展命令在路径后附加起止位置 [0, length)
+        std::string command = std::string(checksumCommand(algorithm)) + " " + path;
+        if (length >= 0) {
+            command += " 0 " + std::to_string(length);
+        }
+        commands.push_back(command);
     }
 
-    // 创建数据连接
-    SOCKET dataSocket = createDataConnection();
-    if (dataSocket == INVALID_SOCKET) {
-        file.close();
-        return false;
+    // 服务器读完整个文件才回复，等待时间按 checksumMs 计算（两者之一为 0 时不限）
+    std::vector<FTPResponse> replies;
+    int readMs = timeouts.readMs;
+    if (readMs > 0) {
+        timeouts.readMs = timeouts.checksumMs > 0 ? std::max(readMs, timeouts.checksumMs) : 0;
     }
-
-    // 发送RETR命令
-    if (!sendCommand("RETR " + remotePath)) {
-        if (ssl.dataSSL) {
-            SSL_free(ssl.dataSSL);
-            ssl.dataSSL = nullptr;
-        }
-        closesocket(dataSocket);
-        file.close();
+    bool sent = sendCommands(commands, replies);
+    timeouts.readMs = readMs;
+    if (!sent) {
         return false;
     }
-
-    FTPResponse response = getResponse();
-    if (response.code != 150 && response.code != 125) {
-        lastError = "Failed to initiate file transfer: " + response.msg;
-        if (ssl.dataSSL) {
-            SSL_free(ssl.dataSSL);
-            ssl.dataSSL = nullptr;
+    if (useHash && hashSelection != name) {
+        if (replies[0].code != 200) {
+            return false;
         }
-        closesocket(dataSocket);
-        file.close();
+        hashSelection = name;
+    }
+    if (useHash && length >= 0 && replies[hashIndex - 1].code != 350) {
         return false;
     }
 
-    // 接收文件数据
-    char buffer[8192];
-    int64_t transferred = startPos;
-    bool success = true;
+    const FTPResponse& reply = replies[hashIndex];
+    return reply.code / 100 == 2 && parseChecksumReply(reply.msg, algorithm, digest);
+}
 
-    while (transferred < fileSize && success) {
-        int received;
-        if (ssl.dataSSL) {
-            received = SSL_read(ssl.dataSSL, buffer, sizeof(buffer));
-        } else {
-            received = recv(dataSocket, buffer, sizeof(buffer), 0);
-        }
+bool FTPClient::hashLocalFile(LocalFile& file, int64_t length, Hasher& hasher) {
+    const size_t HASH_BUFFER_SIZE = 1024 * 1024;
+    if (!transferBuffer.reserve(HASH_BUFFER_SIZE)) {
+        lastError = "Failed to allocate transfer buffer";
+        return false;
+    }
 
-        if (received > 0) {
-            file.write(buffer, received);
-            transferred += received;
-            if (progress) {
-                progress(transferred, fileSize);
-            }
-        } else if (received == 0) {
-            break; // 连接关闭
-        } else {
-            lastError = "Failed to receive file data";
-            success = false;
+    int64_t offset = 0;
+    while (offset < length) {
+        size_t want = static_cast<size_t>(std::min<int64_t>(HASH_BUFFER_SIZE, length - offset));
+        int64_t readCount = file.readAt(offset, transferBuffer.data(), want);
+        if (readCount <= 0) {
+            lastError = "Failed to read local file";
+            return false;
         }
+        hasher.update(transferBuffer.data(), static_cast<size_t>(readCount));
+        offset += readCount;
     }
+    return true;
+}
 
-    // 关闭连接
-    file.close();
-    if (ssl.dataSSL) {
-        SSL_shutdown(ssl.dataSSL);
-        SSL_free(ssl.dataSSL);
-        ssl.dataSSL = nullptr;
+bool FTPClient::verifyPrefix(const std::string& remotePath, LocalFile& file, int64_t length,
+                             bool wholeFile, Hasher& hasher) {
+    std::string remote;
+    if (!hashLocalFile(file, length, hasher)) {
+        hasher.reset();
+        return false;
     }
-    closesocket(dataSocket);
-
-    // 获取传输完成响应
-    response = getResponse();
-    if (response.code != 226 && response.code != 250) {
-        lastError = "File transfer failed: " + response.msg;
+    if (!remoteChecksum(remotePath, hasher.algorithm(), wholeFile ? -1 : length, remote)) {
+        return true;
+    }
+    if (remote != hasher.digest()) {
+        hasher.reset();
         return false;
     }
-
-    return success;
+    return true;
 }
 
-bool FTPClient::setTransferType(TransferType type) {
-    const char* typeStr = (type == TransferType::ASCII) ? "A" : "I";
-    if (!sendCommand("TYPE " + std::string(typeStr))) {
-        return false;
-    }
+bool FTPClient::verifyTransfer(const std::string& remotePath, const Hasher& hasher) {
+    lastIntegrity.algorithm = hashAlgorithmName(hasher.algorithm());
+    lastIntegrity.digest = hasher.digest();
 
-    FTPResponse response = getResponse();
-    if (response.code != 200) {
-        lastError = "Failed to set transfer type: " + response.msg;
+    std::string remote;
+    if (!remoteChecksum(remotePath, hasher.algorithm(), -1, remote)) {
+        return true;    // 服务器无法计算，只保留本地校验值
+    }
+    if (remote != lastIntegrity.digest) {
+        lastError = "Checksum mismatch (" + lastIntegrity.algorithm + "): local " +
+                    lastIntegrity.digest + ", remote " + remote;
         return false;
     }
-
-    transferType = type;
+    lastIntegrity.verified = true;
     return true;
 }
 
-std::vector<std::string> FTPClient::listFiles() {
-    std::vector<std::string> fileList;
+bool FTPClient::readListing(const std::string& command,
+                            const std::function<void(std::string_view)>& onLine) {
+    const size_t LISTING_BUFFER_SIZE = 64 * 1024;
+    if (!transferBuffer.reserve(LISTING_BUFFER_SIZE)) {
+        lastError = "Failed to allocate listing buffer";
+        return false;
+    }
 
     SOCKET dataSocket = createDataConnection();
     if (dataSocket == INVALID_SOCKET) {
-        return fileList;
+        return false;
     }
 
-    if (!sendCommand("LIST")) {
-        if (ssl.dataSSL) {
-            SSL_free(ssl.dataSSL);
-            ssl.dataSSL = nullptr;
-        }
-        closesocket(dataSocket);
-        return fileList;
+    if (!startTransfer(command, 0, dataSocket)) {
+        return false;
     }
 
-    FTPResponse response = getResponse();
-    if (response.code != 150 && response.code != 125) {
-        lastError = "Failed to list directory: " + response.msg;
-        if (ssl.dataSSL) {
-            SSL_free(ssl.dataSSL);
-            ssl.dataSSL = nullptr;
+    // 去掉行尾的 \r 后回调
+    auto emit = [&onLine](std::string_view line) {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
         }
-        closesocket(dataSocket);
-        return fileList;
-    }
+        onLine(line);
+    };
 
-    char buffer[4096];
-    std::string data;
+    std::string pending;    // 跨越两次接收的不完整行
+    char* buffer = transferBuffer.data();
+    int bufferSize = static_cast<int>(std::min(transferBuffer.size(), LISTING_BUFFER_SIZE));
 
     while (true) {
-        int received;
-        if (ssl.dataSSL) {
-            received = SSL_read(ssl.dataSSL, buffer, sizeof(buffer) - 1);
-        } else {
-            received = recv(dataSocket, buffer, sizeof(buffer) - 1, 0);
-        }
+        int received = receiveSome(dataSocket, ssl.dataSSL, buffer, static_cast<size_t>(bufferSize));
 
         if (received > 0) {
-            buffer[received] = '\0';
-            data += buffer;
+            std::string_view chunk(buffer, static_cast<size_t>(received));
+            size_t eol;
+
+            if (!pending.empty()) {
+                eol = chunk.find('\n');
+                if (eol == std::string_view::npos) {
+                    pending.append(chunk.data(), chunk.size());
+                    continue;
+                }
+                pending.append(chunk.data(), eol);
+                emit(pending);
+                pending.clear();
+                chunk.remove_prefix(eol + 1);
+            }
+
+            // 完整的行直接在接收缓冲区上回调
+            while ((eol = chunk.find('\n')) != std::string_view::npos) {
+                emit(chunk.substr(0, eol));
+                chunk.remove_prefix(eol + 1);
+            }
+            pending.assign(chunk.data(), chunk.size());
         } else if (received == 0) {
             break;
         } else {
-            lastError = "Failed to receive directory listing";
-            if (ssl.dataSSL) {
-                SSL_free(ssl.dataSSL);
-                ssl.dataSSL = nullptr;
-            }
-            closesocket(dataSocket);
-            return fileList;
+            lastError = "Failed to receive directory listing: " + lastError;
+            closeDataConnection(dataSocket);
+            return false;
         }
     }
 
-    if (ssl.dataSSL) {
-        SSL_shutdown(ssl.dataSSL);
-        SSL_free(ssl.dataSSL);
-        ssl.dataSSL = nullptr;
+    if (!pending.empty()) {
+        emit(pending);
     }
-    closesocket(dataSocket);
 
-    response = getResponse();
+    closeDataConnection(dataSocket);
+
+    FTPResponse response = getResponse();
     if (response.code != 226 && response.code != 250) {
         lastError = "Directory listing failed: " + response.msg;
-        return fileList;
-    }
-
-    std::istringstream iss(data);
-    std::string line;
-    while (std::getline(iss, line)) {
-        if (!line.empty()) {
-            fileList.push_back(line);
-        }
+        return false;
     }
 
-    return fileList;
+    return true;
 }
 
 std::string FTPClient::getCurrentDir() {
@@ -910,6 +3407,134 @@ bool FTPClient::deleteFile(const std::string& path) {
     return true;
 }
 
+bool FTPClient::deleteFiles(const std::vector<std::string>& paths, bool recursive,
+                            std::vector<FTPResponse>& results) {
+    std::vector<std::string> commands;
+    commands.reserve(paths.size());
+    for (const auto& path : paths) {
+        commands.push_back("DELE " + path);
+    }
+
+    if (!sendCommands(commands, results)) {
+        // 连接中断后尚未得到响应的路径记为未完成
+        results.resize(paths.size(), FTPResponse{0, lastError});
+        return false;
+    }
+
+    // DELE 失败的路径可能是目录，递归删除其内容后再删除目录本身
+    if (recursive) {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (results[i].code != 250) {
+                removeTree(paths[i], results[i]);
+            }
+        }
+    }
+
+    size_t failed = 0;
+    for (const auto& result : results) {
+        if (result.code != 250) {
+            ++failed;
+        }
+    }
+    if (failed > 0) {
+        lastError = "Failed to delete " + std::to_string(failed) + " of " +
+                    std::to_string(paths.size()) + " path(s)";
+        return false;
+    }
+    return true;
+}
+
+bool FTPClient::removeTree(const std::string& path, FTPResponse& result) {
+    // 不是目录时保留原来的 DELE 响应（LIST 文件路径同样会成功，不能据此判断）
+    if (!isDirectory(path)) {
+        return false;
+    }
+
+    // 广度优先遍历：目录按发现顺序排列，逆序删除即可保证子目录先于父目录
+    std::vector<std::string> dirs(1, path);
+    std::vector<std::string> commands;
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        const std::string dir = dirs[i];
+        bool listed = listDirectory(dir, [&](const FileEntry& entry) {
+            std::string child = joinPath(dir, entry.name);
+            if (entry.type == FileEntry::Type::DIRECTORY) {
+                dirs.push_back(child);
+            } else {
+                commands.push_back("DELE " + child);
+            }
+        });
+
+        if (!listed) {
+            result.code = 0;
+            result.msg = "Failed to list " + dir + ": " + lastError;
+            return true;
+        }
+    }
+
+    for (auto it = dirs.rbegin(); it != dirs.rend(); ++it) {
+        commands.push_back("RMD " + *it);
+    }
+
+    std::vector<FTPResponse> replies;
+    if (!sendCommands(commands, replies)) {
+        result.code = 0;
+        result.msg = lastError;
+        return true;
+    }
+
+    // 返回第一条失败的响应；全部成功时返回删除根目录的 RMD 响应
+    for (size_t i = 0; i < replies.size(); ++i) {
+        if (replies[i].code != 250) {
+            result.code = replies[i].code;
+            result.msg = commands[i] + ": " + replies[i].msg;
+            return true;
+        }
+    }
+    result = replies.back();
+    return true;
+}
+
+bool FTPClient::isDirectory(const std::string& path) {
+    if (hasFeature("MLST")) {
+        if (!sendCommand("MLST " + path)) {
+            return false;
+        }
+        FTPResponse response = getResponse();
+        if (response.code != 250) {
+            return false;
+        }
+
+        // 事实行形如 " type=dir;modify=20240101000000; /path"，目录本身也可能报告为 cdir
+        std::istringstream iss(response.msg);
+        std::string line;
+        while (std::getline(iss, line)) {
+            if (line.empty() || line[0] != ' ') {
+                continue;
+            }
+            std::transform(line.begin(), line.end(), line.begin(), [](unsigned char c) {
+                return static_cast<char>(std::tolower(c));
+            });
+            size_t pos = line.find("type=");
+            while (pos != std::string::npos && line[pos - 1] != ';' && line[pos - 1] != ' ') {
+                pos = line.find("type=", pos + 1);
+            }
+            if (pos == std::string::npos) {
+                return false;
+            }
+            std::string type = line.substr(pos + 5, line.find_first_of("; ", pos + 5) - pos - 5);
+            return type == "dir" || type == "cdir" || type == "pdir";
+        }
+        return false;
+    }
+
+    std::string current = getCurrentDir();
+    if (current.empty() || !changeDir(path)) {
+        return false;
+    }
+    changeDir(current);
+    return true;
+}
+
 bool FTPClient::parsePasvResponse(const std::string& response, std::string& ip, uint16_t& port) {
     size_t start = response.find_first_of("0123456789");
     if (start == std::string::npos) {
@@ -948,36 +3573,16 @@ bool FTPClient::parsePasvResponse(const std::string& response, std::string& ip,
 }
 
 int64_t FTPClient::getFileSize(const std::string& path) {
-    if (!sendCommand("SIZE " + path)) {
+    if (!sendCommand(sizeCommand(path))) {
         return -1;
     }
 
     FTPResponse response = getResponse();
-    if (response.code != 213) {
+    int64_t size = parseSizeReply(response);
+    if (size < 0) {
         lastError = "Failed to get file size: " + response.msg;
-        return -1;
-    }
-
-    try {
-        return std::stoll(response.msg);
-    } catch (const std::exception& e) {
-        lastError = "Invalid file size format: " + std::string(e.what());
-        return -1;
-    }
-}
-
-bool FTPClient::setFilePosition(int64_t pos) {
-    if (!sendCommand("REST " + std::to_string(pos))) {
-        return false;
-    }
-
-    FTPResponse response = getResponse();
-    if (response.code != 350) {
-        lastError = "Failed to set file position: " + response.msg;
-        return false;
     }
-
-    return true;
+    return size;
 }
 
 } // namespace ftp
\ No newline at end of file
@@ -0,0 +1,372 @@
+/**
+ * @file ftplistparser.cpp
+ * @brief 目录列表解析器的实现文件
+ */
+
+#include "ftplistparser.h"
+#include <ctime>
+
+namespace ftp {
+
+namespace {
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+char toLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (toLower(a[i]) != toLower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 解析非负十进制整数，s 必须全部是数字
+ */
+bool parseNumber(std::string_view s, int64_t& value) {
+    if (s.empty() || s.size() > 18) {
+        return false;
+    }
+    value = 0;
+    for (char c : s) {
+        if (!isDigit(c)) {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+/**
+ * @brief 解析固定位数的十进制数字
+ */
+int parseFixed(std::string_view s, size_t pos, size_t len) {
+    int value = 0;
+    for (size_t i = pos; i < pos + len; ++i) {
+        value = value * 10 + (s[i] - '0');
+    }
+    return value;
+}
+
+/**
+ * @brief 取下一个以空白分隔的字段，rest 前移到字段之后
+ */
+std::string_view nextToken(std::string_view& rest) {
+    size_t start = 0;
+    while (start < rest.size() && (rest[start] == ' ' || rest[start] == '\t')) {
+        ++start;
+    }
+    size_t end = start;
+    while (end < rest.size() && rest[end] != ' ' && rest[end] != '\t') {
+        ++end;
+    }
+    std::string_view token = rest.substr(start, end - start);
+    rest.remove_prefix(end);
+    return token;
+}
+
+/**
+ * @brief 英文月份缩写转为 1-12，无法识别返回 0
+ */
+int monthIndex(std::string_view s) {
+    static const char* const MONTHS[] = {
+        "jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec"
+    };
+    if (s.size() != 3) {
+        return 0;
+    }
+    for (int i = 0; i < 12; ++i) {
+        if (equalsIgnoreCase(s, MONTHS[i])) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 将 UTC 日期时间转换为 Unix 时间戳（不依赖平台的 timegm）
+ */
+int64_t makeTimestamp(int year, int month, int day, int hour, int minute, int second) {
+    // Howard Hinnant 的 days_from_civil 算法
+    year -= month <= 2 ? 1 : 0;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int64_t yoe = year - era * 400;
+    const int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    const int64_t days = era * 146097 + doe - 719468;
+    return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+bool isDotEntry(std::string_view name) {
+    return name == "." || name == "..";
+}
+
+} // namespace
+
+int64_t parseFTPTimestamp(std::string_view value) {
+    int64_t check;
+    if (value.size() < 14 || !parseNumber(value.substr(0, 14), check)) {
+        return -1;
+    }
+    return makeTimestamp(parseFixed(value, 0, 4), parseFixed(value, 4, 2),
+                         parseFixed(value, 6, 2), parseFixed(value, 8, 2),
+                         parseFixed(value, 10, 2), parseFixed(value, 12, 2));
+}
+
+ListingParser::ListingParser(Format format) : listFormat(format) {
+    std::time_t now = std::time(nullptr);
+    std::tm tm = {};
+#ifdef _WIN32
+    gmtime_s(&tm, &now);
+#else
+    gmtime_r(&now, &tm);
+#endif
+    currentYear = tm.tm_year + 1900;
+    currentMonth = tm.tm_mon + 1;
+}
+
+bool ListingParser::parseLine(std::string_view line, FileEntry& entry) const {
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) {
+        line.remove_suffix(1);
+    }
+    if (line.empty()) {
+        return false;
+    }
+
+    if (listFormat == Format::MLSD) {
+        return parseMLSD(line, entry);
+    }
+    // Windows/IIS 格式以日期开头，Unix 格式以权限字符串开头
+    return isDigit(line[0]) ? parseDOS(line, entry) : parseUnix(line, entry);
+}
+
+bool ListingParser::parseMLSD(std::string_view line, FileEntry& entry) const {
+    // "type=file;size=1024;modify=20240131101500; name"
+    size_t space = line.find(' ');
+    if (space == std::string_view::npos || space + 1 >= line.size()) {
+        return false;
+    }
+    std::string_view facts = line.substr(0, space);
+    std::string_view name = line.substr(space + 1);
+
+    entry = FileEntry();
+    while (!facts.empty()) {
+        size_t semi = facts.find(';');
+        std::string_view fact = facts.substr(0, semi);
+        facts.remove_prefix(semi == std::string_view::npos ? facts.size() : semi + 1);
+
+        size_t eq = fact.find('=');
+        if (eq == std::string_view::npos) {
+            continue;
+        }
+        std::string_view key = fact.substr(0, eq);
+        std::string_view value = fact.substr(eq + 1);
+
+        if (equalsIgnoreCase(key, "type")) {
+            if (equalsIgnoreCase(value, "file")) {
+                entry.type = FileEntry::Type::FILE;
+            } else if (equalsIgnoreCase(value, "dir")) {
+                entry.type = FileEntry::Type::DIRECTORY;
+            } else if (equalsIgnoreCase(value, "cdir") || equalsIgnoreCase(value, "pdir")) {
+                // 当前目录与父目录不属于列表内容
+                return false;
+            } else if ((value.size() >= 13 && equalsIgnoreCase(value.substr(0, 13), "os.unix=slink")) ||
+                       (value.size() >= 15 && equalsIgnoreCase(value.substr(0, 15), "os.unix=symlink"))) {
+                entry.type = FileEntry::Type::LINK;
+            } else {
+                entry.type = FileEntry::Type::OTHER;
+            }
+        } else if (equalsIgnoreCase(key, "size")) {
+            parseNumber(value, entry.size);
+        } else if (equalsIgnoreCase(key, "modify")) {
+            entry.mtime = parseFTPTimestamp(value);
+        } else if (equalsIgnoreCase(key, "unix.mode")) {
+            int32_t mode = 0;
+            bool valid = !value.empty();
+            for (char c : value) {
+                if (c < '0' || c > '7') {
+                    valid = false;
+                    break;
+                }
+                mode = mode * 8 + (c - '0');
+            }
+            if (valid) {
+                entry.perms = mode & 07777;
+            }
+        }
+    }
+
+    if (isDotEntry(name)) {
+        return false;
+    }
+    entry.name.assign(name.data(), name.size());
+    return true;
+}
+
+bool ListingParser::parseUnix(std::string_view line, FileEntry& entry) const {
+    // "drwxr-xr-x 2 user group 4096 Jan 31 10:15 name"，部分服务器省略链接数或组
+    std::string_view rest = line;
+    std::string_view permStr = nextToken(rest);
+    if (permStr.size() < 10) {
+        return false;
+    }
+
+    FileEntry::Type type;
+    switch (permStr[0]) {
+        case '-': type = FileEntry::Type::FILE; break;
+        case 'd': type = FileEntry::Type::DIRECTORY; break;
+        case 'l': type = FileEntry::Type::LINK; break;
+        case 'b': case 'c': case 'p': case 's':
+            type = FileEntry::Type::OTHER;
+            break;
+        default:
+            return false;
+    }
+
+    int32_t perms = 0;
+    static const char RWX[] = "rwx";
+    for (int i = 0; i < 9; ++i) {
+        char c = permStr[1 + i];
+        int bit = 8 - i;
+        if (c == RWX[i % 3] || c == 's' || c == 't') {
+            perms |= 1 << bit;
+        } else if (c != '-' && c != 'S' && c != 'T') {
+            return false;
+        }
+    }
+    if (permStr[3] == 's' || permStr[3] == 'S') perms |= 04000;
+    if (permStr[6] == 's' || permStr[6] == 'S') perms |= 02000;
+    if (permStr[9] == 't' || permStr[9] == 'T') perms |= 01000;
+
+    // 定位 "<size> <月> <日> <时间或年份>"，文件名紧随其后
+    const size_t MAX_FIELDS = 8;
+    std::string_view fields[MAX_FIELDS];
+    size_t count = 0;
+    while (count < MAX_FIELDS) {
+        std::string_view token = nextToken(rest);
+        if (token.empty()) {
+            return false;
+        }
+        fields[count++] = token;
+
+        if (count < 4) {
+            continue;
+        }
+        std::string_view sizeStr = fields[count - 4];
+        int month = monthIndex(fields[count - 3]);
+        std::string_view dayStr = fields[count - 2];
+        std::string_view timeStr = fields[count - 1];
+
+        int64_t size, day;
+        if (month == 0 || !parseNumber(sizeStr, size) || !parseNumber(dayStr, day) || day < 1 || day > 31) {
+            continue;
+        }
+
+        int year, hour = 0, minute = 0;
+        int64_t value;
+        if (timeStr.size() == 5 && timeStr[2] == ':' &&
+            parseNumber(timeStr.substr(0, 2), value) && parseNumber(timeStr.substr(3), value)) {
+            hour = parseFixed(timeStr, 0, 2);
+            minute = parseFixed(timeStr, 3, 2);
+            // 近期文件只显示时间：晚于当前月份的日期属于去年
+            year = month > currentMonth ? currentYear - 1 : currentYear;
+        } else if (timeStr.size() == 4 && parseNumber(timeStr, value)) {
+            year = static_cast<int>(value);
+        } else {
+            continue;
+        }
+
+        // 字段与文件名之间只有一个空格，文件名本身可以以空格开头
+        if (rest.size() < 2) {
+            return false;
+        }
+        std::string_view name = rest.substr(1);
+        if (type == FileEntry::Type::LINK) {
+            size_t arrow = name.find(" -> ");
+            if (arrow != std::string_view::npos) {
+                name = name.substr(0, arrow);
+            }
+        }
+        if (isDotEntry(name)) {
+            return false;
+        }
+
+        entry.name.assign(name.data(), name.size());
+        entry.size = size;
+        entry.mtime = makeTimestamp(year, month, static_cast<int>(day), hour, minute, 0);
+        entry.perms = perms;
+        entry.type = type;
+        return true;
+    }
+
+    return false;
+}
+
+bool ListingParser::parseDOS(std::string_view line, FileEntry& entry) const {
+    // "01-31-24  10:15AM       <DIR>          name" 或 "01-31-2024  10:15PM  1024 name"
+    std::string_view rest = line;
+    std::string_view dateStr = nextToken(rest);
+    std::string_view timeStr = nextToken(rest);
+    std::string_view sizeStr = nextToken(rest);
+
+    if ((dateStr.size() != 8 && dateStr.size() != 10) || dateStr[2] != '-' || dateStr[5] != '-') {
+        return false;
+    }
+    int64_t month, day, year;
+    if (!parseNumber(dateStr.substr(0, 2), month) || !parseNumber(dateStr.substr(3, 2), day) ||
+        !parseNumber(dateStr.substr(6), year)) {
+        return false;
+    }
+    if (dateStr.size() == 8) {
+        year += year < 70 ? 2000 : 1900;
+    }
+
+    if (timeStr.size() != 7 || timeStr[2] != ':') {
+        return false;
+    }
+    int64_t hour, minute;
+    if (!parseNumber(timeStr.substr(0, 2), hour) || !parseNumber(timeStr.substr(3, 2), minute)) {
+        return false;
+    }
+    bool pm = toLower(timeStr[5]) == 'p';
+    hour %= 12;
+    if (pm) {
+        hour += 12;
+    }
+
+    entry = FileEntry();
+    if (sizeStr == "<DIR>") {
+        entry.type = FileEntry::Type::DIRECTORY;
+    } else if (parseNumber(sizeStr, entry.size)) {
+        entry.type = FileEntry::Type::FILE;
+    } else {
+        return false;
+    }
+
+    // 文件名前的对齐空格
+    size_t start = 0;
+    while (start < rest.size() && rest[start] == ' ') {
+        ++start;
+    }
+    std::string_view name = rest.substr(start);
+    if (name.empty() || isDotEntry(name)) {
+        return false;
+    }
+
+    entry.name.assign(name.data(), name.size());
+    entry.mtime = makeTimestamp(static_cast<int>(year), static_cast<int>(month), static_cast<int>(day),
+                                static_cast<int>(hour), static_cast<int>(minute), 0);
+    return true;
+}
+
+} // namespace ftp
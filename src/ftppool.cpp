@@ -0,0 +1,256 @@
+/**
+ * @file ftppool.cpp
+ * @brief FTP 控制连接池的实现文件
+ */
+
+#include "ftppool.h"
+#include "tlscontext.h"
+#include <vector>
+#include <cstdio>
+#include <openssl/evp.h>
+
+namespace ftp {
+
+FTPConnectionPool::FTPConnectionPool(const Options& options) : options(options) {}
+
+FTPConnectionPool::~FTPConnectionPool() {
+    clear();
+}
+
+std::string FTPConnectionPool::makeHostKey(const Target& target) {
+    return target.host + ":" + std::to_string(target.port);
+}
+
+std::string FTPConnectionPool::makePoolKey(const Target& target, const std::string& password) {
+    // 键中只保存密码摘要：密码不同的请求不能借到别人登录的连接
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLen = 0;
+    EVP_Digest(password.data(), password.size(), digest, &digestLen, EVP_sha256(), nullptr);
+
+    std::string key = makeHostKey(target);
+    key += '\n' + target.username;
+    key += '\n' + (target.useTLS ? TLSContextCache::makeKey(target.tlsConfig) : std::string("plain"));
+    key += '\n';
+    char hex[3];
+    for (unsigned int i = 0; i < digestLen; ++i) {
+        snprintf(hex, sizeof(hex), "%02x", digest[i]);
+        key += hex;
+    }
+    return key;
+}
+
+std::shared_ptr<FTPClient> FTPConnectionPool::lease(const Target& target, const std::string& password,
+                                                    std::string& error) {
+    std::string hostKey = makeHostKey(target);
+    std::string poolKey = makePoolKey(target, password);
+    Clock::time_point deadline = Clock::now() + options.leaseTimeout;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // 优先复用最近归还的空闲连接
+        auto it = idle.find(poolKey);
+        if (it != idle.end() && !it->second.empty()) {
+            IdleConnection conn = std::move(it->second.back());
+            it->second.pop_back();
+            lock.unlock();
+
+            conn.client->timeouts = target.timeouts;
+            conn.client->socketOptions = target.socketOptions;
+            bool healthy = conn.client->isConnected();
+            if (healthy && Clock::now() - conn.since >= options.healthCheckAfter) {
+                healthy = conn.client->noop();
+            }
+            if (healthy) {
+                lock.lock();
+                leased[conn.client.get()] = {poolKey, hostKey, conn.homeDir};
+                return conn.client;
+            }
+
+            conn.client->disconnect();
+            lock.lock();
+            dropHostSlot(hostKey);
+            continue;
+        }
+
+        // 未达上限时新建连接（连接与登录过程不持有锁）
+        size_t& count = hostCount[hostKey];
+        if (count < options.maxPerHost) {
+            ++count;
+            lock.unlock();
+
+            std::string homeDir;
+            std::shared_ptr<FTPClient> client = connectNew(target, password, homeDir, error);
+
+            lock.lock();
+            if (!client) {
+                dropHostSlot(hostKey);
+                return nullptr;
+            }
+            leased[client.get()] = {poolKey, hostKey, homeDir};
+            return client;
+        }
+
+        // 已达上限：关闭该主机上其他用户最早的空闲连接腾出名额
+        std::shared_ptr<FTPClient> victim;
+        for (auto& pair : idle) {
+            if (!pair.second.empty() && idleHost[pair.first] == hostKey) {
+                victim = pair.second.front().client;
+                pair.second.pop_front();
+                break;
+            }
+        }
+        if (victim) {
+            lock.unlock();
+            victim->disconnect();
+            lock.lock();
+            dropHostSlot(hostKey);
+            continue;
+        }
+
+        // 等待其他会话归还连接
+        if (cv.wait_until(lock, deadline) == std::cv_status::timeout && Clock::now() >= deadline) {
+            error = "Too many connections to " + hostKey;
+            return nullptr;
+        }
+    }
+}
+
+void FTPConnectionPool::release(const std::shared_ptr<FTPClient>& client, bool reusable) {
+    if (!client) {
+        return;
+    }
+
+    LeaseInfo info;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = leased.find(client.get());
+        if (it == leased.end()) {
+            return;
+        }
+        info = std::move(it->second);
+        leased.erase(it);
+    }
+
+    // 恢复到登录时的状态后才放回池中，状态无法恢复的连接直接关闭
+    if (reusable && client->isConnected() && resetState(*client, info.homeDir)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle[info.poolKey].push_back({client, info.homeDir, Clock::now()});
+        idleHost[info.poolKey] = info.hostKey;
+        cv.notify_all();
+        return;
+    }
+
+    client->disconnect();
+    std::lock_guard<std::mutex> lock(mutex);
+    dropHostSlot(info.hostKey);
+}
+
+void FTPConnectionPool::evictIdle() {
+    std::vector<std::shared_ptr<FTPClient>> expired;
+    Clock::time_point now = Clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = idle.begin(); it != idle.end();) {
+            auto& queue = it->second;
+            // 队首是最早进入空闲状态的连接
+            while (!queue.empty() && now - queue.front().since >= options.idleTimeout) {
+                expired.push_back(std::move(queue.front().client));
+                queue.pop_front();
+                dropHostSlot(idleHost[it->first]);
+            }
+            if (queue.empty()) {
+                idleHost.erase(it->first);
+                it = idle.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (auto& client : expired) {
+        client->disconnect();
+    }
+}
+
+void FTPConnectionPool::clear() {
+    std::vector<std::shared_ptr<FTPClient>> all;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& pair : idle) {
+            for (auto& conn : pair.second) {
+                all.push_back(std::move(conn.client));
+                dropHostSlot(idleHost[pair.first]);
+            }
+        }
+        idle.clear();
+        idleHost.clear();
+    }
+
+    for (auto& client : all) {
+        client->disconnect();
+    }
+}
+
+size_t FTPConnectionPool::idleCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& pair : idle) {
+        count += pair.second.size();
+    }
+    return count;
+}
+
+size_t FTPConnectionPool::leasedCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return leased.size();
+}
+
+std::shared_ptr<FTPClient> FTPConnectionPool::connectNew(const Target& target, const std::string& password,
+                                                         std::string& homeDir, std::string& error) {
+    std::shared_ptr<FTPClient> client = std::make_shared<FTPClient>();
+    client->tlsConfig = target.tlsConfig;
+    client->timeouts = target.timeouts;
+    client->socketOptions = target.socketOptions;
+
+    bool ok = client->connect(target.host, target.port);
+    if (ok && target.useTLS) {
+        ok = client->initSSL() && client->upgradeToTLS();
+    }
+    ok = ok && client->login(target.username, password);
+
+    if (!ok) {
+        error = client->getLastError();
+        client->disconnect();
+        return nullptr;
+    }
+
+    homeDir = client->getCurrentDir();
+    return client;
+}
+
+bool FTPConnectionPool::resetState(FTPClient& client, const std::string& homeDir) {
+    if (client.getTransferType() != TransferType::BINARY &&
+        !client.setTransferType(TransferType::BINARY)) {
+        return false;
+    }
+    client.setTransferMode(TransferMode::PASSIVE);
+    client.progressOptions = ProgressOptions();
+
+    return homeDir.empty() || client.changeDir(homeDir);
+}
+
+void FTPConnectionPool::dropHostSlot(const std::string& hostKey) {
+    auto it = hostCount.find(hostKey);
+    if (it != hostCount.end()) {
+        if (it->second <= 1) {
+            hostCount.erase(it);
+        } else {
+            --it->second;
+        }
+    }
+    cv.notify_all();
+}
+
+} // namespace ftp
@@ -1,12 +1,183 @@
 #include "ftpwebsocket.h"
 #include "ftpclient.h"
+#include "asyncftpclient.h"
 #include <iostream>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <chrono>
 
 namespace ftp {
 
-FTPWebSocketServer::FTPWebSocketServer(uint16_t port) : port(port) {
+namespace {
+
+// 连接池空闲连接的检查周期（毫秒）
+const long POOL_EVICT_INTERVAL_MS = 30000;
+
+// 流式下载时单个连接允许积压的发送数据上限（字节）
+const size_t STREAM_SEND_HIGH_WATERMARK = 4 * 1024 * 1024;
+
+// websocketpp 的发送缓冲超过上限时，在会话的 strand 中再次检查的间隔（毫秒）
+const int STREAM_DRAIN_RETRY_MS = 5;
+
+/**
+ * @brief 是否为在会话工作线程中直接执行的传输命令
+ */
+bool isTransferCommand(const json& command) {
+    std::string cmd = command.get("cmd", "").asString();
+    return (cmd == "upload" || cmd == "download" || cmd == "mirror") &&
+           !command.get("queue", false).asBool();
+}
+
+/**
+ * @brief 连接目标的主机键（host:port），用于按主机限制并发与带宽
+ */
+std::string hostKeyOf(const FTPConnectionPool::Target& target) {
+    return target.host + ":" + std::to_string(target.port);
+}
+
+/**
+ * @brief 按请求中的 timeouts 对象（connect/read/transfer/checksum，单位毫秒，0 表示不限）覆盖 timeouts 中对应的项
+ */
+FTPClient::Timeouts parseTimeouts(const json& value, FTPClient::Timeouts timeouts) {
+    if (value.isObject()) {
+        timeouts.connectMs = std::max(0, value.get("connect", timeouts.connectMs).asInt());
+        timeouts.readMs = std::max(0, value.get("read", timeouts.readMs).asInt());
+        timeouts.transferMs = std::max(0, value.get("transfer", timeouts.transferMs).asInt());
+        timeouts.checksumMs = std::max(0, value.get("checksum", timeouts.checksumMs).asInt());
+    }
+    return timeouts;
+}
+
+/**
+ * @brief 解析 connect 请求中的 socket 对象，未给出的项使用默认值
+ */
+FTPClient::SocketOptions parseSocketOptions(const json& value) {
+    FTPClient::SocketOptions options;
+    if (value.isObject()) {
+        options.sendBuffer = std::max(0, value.get("sendBuffer", 0).asInt());
+        options.receiveBuffer = std::max(0, value.get("receiveBuffer", 0).asInt());
+        options.controlNoDelay = value.get("noDelay", true).asBool();
+        options.congestion = value.get("congestion", "").asString();
+        options.notSentLowat = std::max(0, value.get("notSentLowat", 0).asInt());
+        options.keepAlive = value.get("keepAlive", false).asBool();
+        options.keepAliveIdle = std::max(0, value.get("keepAliveIdle", 0).asInt());
+        options.keepAliveInterval = std::max(0, value.get("keepAliveInterval", 0).asInt());
+    }
+    return options;
+}
+
+/**
+ * @brief 作用域内使用请求中指定的超时，离开时恢复会话的设置
+ */
+class TimeoutScope {
+public:
+    TimeoutScope(FTPClient& client, const json& command) : client(client), saved(client.timeouts) {
+        client.timeouts = parseTimeouts(command["timeouts"], saved);
+    }
+    ~TimeoutScope() {
+        client.timeouts = saved;
+    }
+
+    TimeoutScope(const TimeoutScope&) = delete;
+    TimeoutScope& operator=(const TimeoutScope&) = delete;
+
+private:
+    FTPClient& client;
+    FTPClient::Timeouts saved;
+};
+
+/**
+ * @brief 作用域内为客户端设置传输控制、限速、压缩与校验选项，离开时恢复（连接可能被归还到连接池）
+ */
+class TransferScope {
+public:
+    TransferScope(FTPClient& client, const std::shared_ptr<TransferControl>& control,
+                  const std::shared_ptr<const RateLimits>& limits, const json& command) : client(client) {
+        client.setTransferControl(control);
+        client.setRateLimits(limits);
+        client.setCompression(command.get("compress", false).asBool(),
+                              command.get("compressLevel", FTPClient::DEFAULT_COMPRESSION_LEVEL).asInt());
+        client.setIntegrityCheck(command.get("verify", false).asBool());
+    }
+    ~TransferScope() {
+        client.setTransferControl(nullptr);
+        client.setRateLimits(nullptr);
+        client.setCompression(false);
+        client.setIntegrityCheck(false);
+    }
+
+    TransferScope(const TransferScope&) = delete;
+    TransferScope& operator=(const TransferScope&) = delete;
+
+private:
+    FTPClient& client;
+};
+
+} // namespace
+
+FTPWebSocketServer::Session::Session(uint64_t id, FTPConnectionPool& pool,
+                                     websocketpp::lib::asio::io_context& io) :
+    id(id),
+    pool(pool),
+    strand(websocketpp::lib::asio::make_strand(io)),
+    client(std::make_shared<FTPClient>()),
+    leased(false),
+    pendingLease(false),
+    loggedIn(false),
+    closed(false),
+    transfer(std::make_shared<TransferControl>()),
+    pendingTransfers(0),
+    sessionLimit(std::make_shared<TokenBucket>()),
+    limits(std::make_shared<RateLimits>()),
+    streamPending(0) {
+
+    limits->setShared({sessionLimit});
+}
+
+FTPWebSocketServer::Session::~Session() {
+    if (leased) {
+        pool.release(client);
+    }
+}
+
+void FTPWebSocketServer::Session::releaseStream(size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        streamPending -= size;
+    }
+    streamDrained.notify_all();
+}
+
+void FTPWebSocketServer::Session::resetClient() {
+    ProgressOptions progressOptions = client->progressOptions;
+    if (leased) {
+        pool.release(client);
+    } else {
+        client->disconnect();
+    }
+    client = std::make_shared<FTPClient>();
+    client->progressOptions = progressOptions;
+    client->timeouts = target.timeouts;
+    client->socketOptions = target.socketOptions;
+    leased = false;
+    pendingLease = false;
+    loggedIn = false;
+}
+
+FTPWebSocketServer::FTPWebSocketServer(uint16_t port, size_t workerCount, size_t ioThreadCount,
+                                       const TransferScheduler::Options& schedulerOptions) :
+    port(port),
+    ioThreadCount(ioThreadCount),
+    evictStopped(false),
+    dispatcher(workerCount),
+    scheduler(schedulerOptions) {
+    if (this->ioThreadCount == 0) {
+        this->ioThreadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
     // 配置 WebSocket 服务器
     server.clear_access_channels(websocketpp::log::alevel::all);
     server.set_access_channels(websocketpp::log::alevel::connect);
@@ -31,10 +202,26 @@ void FTPWebSocketServer::run() {
         // 开始接受连接
         server.start_accept();
 
-        std::cout << "WebSocket server running on port " << port << std::endl;
+        scheduleIdleEviction();
 
-        // 运行服务器
+        std::cout << "WebSocket server running on port " << port
+                  << " (" << ioThreadCount << " I/O threads)" << std::endl;
+
+        // 多个线程共同运行 io_context；websocketpp 以连接为单位的 strand 保证同一连接的回调不会并发
+        std::vector<std::thread> ioThreads;
+        for (size_t i = 1; i < ioThreadCount; ++i) {
+            ioThreads.emplace_back([this]() {
+                try {
+                    server.run();
+                } catch (const std::exception& e) {
+                    std::cerr << "WebSocket I/O thread error: " << e.what() << std::endl;
+                }
+            });
+        }
         server.run();
+        for (auto& thread : ioThreads) {
+            thread.join();
+        }
     } catch (const std::exception& e) {
         std::cerr << "WebSocket server error: " << e.what() << std::endl;
     }
@@ -43,40 +230,105 @@ void FTPWebSocketServer::run() {
 void FTPWebSocketServer::stop() {
     server.stop_listening();
 
-    for (auto& pair : clientMap) {
-        if (pair.second) {
-            pair.second->disconnect();
+    websocketpp::lib::asio::post(server.get_io_service(), [this]() {
+        std::lock_guard<std::mutex> lock(timerMutex);
+        evictStopped = true;
+        if (evictTimer) {
+            evictTimer->cancel();
         }
+    });
+
+    // 唤醒等待上传数据或发送缓冲回落的命令，再等待正在执行的命令结束，丢弃尚未执行的命令
+    for (auto& session : sessions.snapshot()) {
+        session->closed = true;
+        session->releaseStream(0);
+        session->upload.abort();
+        session->transfer->cancel();
     }
-    clientMap.clear();
+    dispatcher.shutdown();
+    scheduler.shutdown();
+
+    for (auto& session : sessions.clear()) {
+        session->closed = true;
+        if (session->asyncClient) {
+            session->asyncClient->close();
+        }
+        session->client->disconnect();
+    }
+    pool.clear();
+}
+
+void FTPWebSocketServer::scheduleIdleEviction() {
+    // 定时器回调可能在任意 I/O 线程中执行
+    std::lock_guard<std::mutex> lock(timerMutex);
+    if (evictStopped) {
+        return;
+    }
+    evictTimer = server.set_timer(POOL_EVICT_INTERVAL_MS, [this](const websocketpp::lib::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        // 关闭空闲连接涉及网络 I/O，放到工作线程执行
+        dispatcher.post(&pool, [this]() {
+            pool.evictIdle();
+        });
+        scheduleIdleEviction();
+    });
 }
 
 void FTPWebSocketServer::onOpen(WebSocketConnectionPtr hdl) {
-    std::lock_guard<std::mutex> lock(mutex);
-    auto conn = server.get_con_from_hdl(hdl);
     auto raw_hdl = hdl.lock().get();
 
-    // 为新连接创建 FTP 客户端实例
-    clientMap[raw_hdl] = std::make_shared<FTPClient>();
+    // 为新连接创建会话，FTP 连接在 connect/login 时建立或从连接池借出
+    auto session = std::make_shared<Session>(sessions.newId(), pool, server.get_io_service());
+    session->upload.setResumeCallback([this, hdl]() {
+        websocketpp::lib::error_code ec;
+        auto con = server.get_con_from_hdl(hdl, ec);
+        if (!ec) {
+            con->resume_reading();
+        }
+    });
+    sessions.insert(raw_hdl, session);
 
-    std::cout << "Client connected" << std::endl;
+    std::cout << "Client connected (session " << session->id << ", "
+              << sessions.size() << " active)" << std::endl;
 }
 
 void FTPWebSocketServer::onClose(WebSocketConnectionPtr hdl) {
-    std::lock_guard<std::mutex> lock(mutex);
     auto raw_hdl = hdl.lock().get();
+    std::shared_ptr<Session> session = sessions.remove(raw_hdl);
 
-    // 清理连接相关资源
-    if (clientMap.find(raw_hdl) != clientMap.end()) {
-        clientMap[raw_hdl]->disconnect();
-        clientMap.erase(raw_hdl);
+    // 清理连接相关资源：归还/断开排在该会话已提交的命令之后执行，避免阻塞 io_context；
+    // 若队列已满，则由排队命令中最后一个持有者析构时归还
+    if (session) {
+        // 中止正在进行的传输，不再为已关闭的连接占用工作线程和带宽
+        session->closed = true;
+        session->releaseStream(0);
+        session->transfer->cancel();
+        session->upload.abort();
+        if (session->asyncClient) {
+            session->asyncClient->close();
+        }
+        dispatcher.post(raw_hdl, [session]() {
+            session->resetClient();
+        });
+        scheduler.removeOwner(session->id);
     }
+    dispatcher.removeSession(raw_hdl);
 
     std::cout << "Client disconnected" << std::endl;
 }
 
 void FTPWebSocketServer::onMessage(WebSocketConnectionPtr hdl, WebSocketServer::message_ptr msg) {
     try {
+        if (msg->get_opcode() == websocketpp::frame::opcode::binary) {
+            auto session = findSession(hdl);
+            if (session) {
+                onBinaryMessage(hdl, session, msg);
+            }
+            return;
+        }
+
         // 解析 JSON 消息
         Json::Reader reader;
         json command;
@@ -88,8 +340,75 @@ void FTPWebSocketServer::onMessage(WebSocketConnectionPtr hdl, WebSocketServer::
             return;
         }
 
-        // 处理 FTP 命令
-        handleFTPCommand(hdl, command);
+        auto session = findSession(hdl);
+        if (!session) {
+            return;
+        }
+
+        // async 会话的命令直接在 io_context 线程中发起，不占用工作线程
+        if (handleAsyncCommand(hdl, session, command)) {
+            return;
+        }
+
+        // 任务管理命令不排队，正在执行的传输不会阻塞取消或暂停
+        std::string cmd = command.get("cmd", "").asString();
+        if (cmd == "jobStatus" || cmd == "cancel" || cmd == "pause" || cmd == "resume") {
+            json response;
+            handleJobCommand(session, cmd, command, response);
+            sendResponse(hdl, response);
+            return;
+        }
+        if (cmd == "setRateLimit") {
+            json response;
+            handleRateLimitCommand(session, command, response);
+            sendResponse(hdl, response);
+            return;
+        }
+
+        // 流式上传的数据帧可能先于命令执行到达，命令入队前打开数据通道
+        bool streamUpload = cmd == "upload" && command.get("stream", false).asBool();
+        if (streamUpload && !session->upload.open()) {
+            json response;
+            response["status"] = "error";
+            response["error"] = "Upload stream already in progress";
+            sendResponse(hdl, response);
+            return;
+        }
+
+        // 停止请求作用于全部已提交的传输命令，最后一个结束后清除
+        bool transferCommand = isTransferCommand(command);
+        if (transferCommand) {
+            ++session->pendingTransfers;
+        }
+        auto finishTransfer = [session]() {
+            if (--session->pendingTransfers == 0) {
+                session->transfer->reset();
+            }
+        };
+
+        // 在会话工作线程中处理 FTP 命令，同一连接的命令保持顺序
+        bool queued = dispatcher.post(hdl.lock().get(),
+            [this, hdl, session, command, streamUpload, transferCommand, finishTransfer]() {
+                handleFTPCommand(hdl, session, command);
+                if (streamUpload) {
+                    session->upload.close();
+                }
+                if (transferCommand) {
+                    finishTransfer();
+                }
+            });
+        if (!queued) {
+            if (streamUpload) {
+                session->upload.close();
+            }
+            if (transferCommand) {
+                finishTransfer();
+            }
+            json response;
+            response["status"] = "error";
+            response["error"] = "Too many pending commands";
+            sendResponse(hdl, response);
+        }
     } catch (const std::exception& e) {
         json response;
         response["status"] = "error";
@@ -98,9 +417,82 @@ void FTPWebSocketServer::onMessage(WebSocketConnectionPtr hdl, WebSocketServer::
     }
 }
 
-void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const json& command) {
+void FTPWebSocketServer::onBinaryMessage(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                                         WebSocketServer::message_ptr msg) {
+    bool pause = false;
+    if (!session->upload.push(std::move(msg->get_raw_payload()), pause)) {
+        json response;
+        response["status"] = "error";
+        response["error"] = "Unexpected binary frame";
+        sendResponse(hdl, response);
+        return;
+    }
+
+    if (pause) {
+        // 上传数据积压，暂停读取该连接，直到工作线程消费到下限以下
+        websocketpp::lib::error_code ec;
+        auto con = server.get_con_from_hdl(hdl, ec);
+        if (!ec) {
+            con->pause_reading();
+        }
+    }
+}
+
+bool FTPWebSocketServer::sendBinary(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                                    const char* data, size_t size) {
+    // 积压的数据由 strand 在发送完毕后释放（见 drainStream），超过上限时等待其回落
+    {
+        std::unique_lock<std::mutex> lock(session->streamMutex);
+        session->streamDrained.wait(lock, [&session]() {
+            return session->closed || session->streamPending < STREAM_SEND_HIGH_WATERMARK;
+        });
+        if (session->closed) {
+            return false;
+        }
+        session->streamPending += size;
+    }
+
+    // 与文本消息一样经会话的 strand 发送，保证与进度消息、最终响应的先后顺序
+    websocketpp::lib::asio::post(session->strand, [this, hdl, session, payload = std::string(data, size)]() {
+        websocketpp::lib::error_code ec;
+        server.send(hdl, payload.data(), payload.size(), websocketpp::frame::opcode::binary, ec);
+        drainStream(hdl, session, payload.size());
+    });
+    return true;
+}
+
+void FTPWebSocketServer::drainStream(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                                     size_t size) {
+    websocketpp::lib::error_code ec;
+    auto con = server.get_con_from_hdl(hdl, ec);
+    if (!ec && !session->closed && con->get_buffered_amount() >= STREAM_SEND_HIGH_WATERMARK) {
+        auto timer = std::make_shared<websocketpp::lib::asio::steady_timer>(
+            session->strand, std::chrono::milliseconds(STREAM_DRAIN_RETRY_MS));
+        timer->async_wait([this, hdl, session, size, timer](const websocketpp::lib::asio::error_code&) {
+            drainStream(hdl, session, size);
+        });
+        return;
+    }
+    session->releaseStream(size);
+}
+
+std::shared_ptr<FTPWebSocketServer::Session> FTPWebSocketServer::findSession(WebSocketConnectionPtr hdl) {
     auto raw_hdl = hdl.lock().get();
-    auto client = clientMap[raw_hdl];
+    if (!raw_hdl) {
+        return nullptr;
+    }
+
+    return sessions.find(raw_hdl);
+}
+
+void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                                          const json& command) {
+    if (session->closed) {
+        // 连接已关闭
+        return;
+    }
+    // 引用会话当前的客户端：connect/login 可能替换为新建或借出的连接
+    std::shared_ptr<FTPClient>& client = session->client;
 
     if (!command.isMember("cmd")) {
         json response;
@@ -114,6 +506,17 @@ void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const json
     json response;
 
     try {
+        // 传输期间可由 cancel/pause 中止；connect/login 会替换 client，不在此列
+        std::unique_ptr<TransferScope> transferScope;
+        if (isTransferCommand(command)) {
+            transferScope.reset(new TransferScope(*client, session->transfer, session->limits, command));
+        }
+        // 单条命令的超时；connect 的 timeouts 作为会话的默认值，connect/login 会替换 client，不在此列
+        std::unique_ptr<TimeoutScope> timeoutScope;
+        if (command.isMember("timeouts") && cmd != "connect" && cmd != "login") {
+            timeoutScope.reset(new TimeoutScope(*client, command));
+        }
+
         if (cmd == "connect") {
             // ---- 从 JSON 中读取连接参数 ----
             std::string host = command["host"].asString();
@@ -121,6 +524,11 @@ void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const json
 
             // 是否使用 TLS/SSL，可选字段，默认 false
             bool useTLS = command.get("useTLS", false).asBool(); 
+
+            // 重新连接前归还或断开当前连接，新连接使用请求中的超时与 socket 选项
+            session->target.timeouts = parseTimeouts(command["timeouts"], FTPClient::Timeouts());
+            session->target.socketOptions = parseSocketOptions(command["socket"]);
+            session->resetClient();
             
             // 如果需要TLS，则可选地从前端设置各项 TLS 配置
             if (useTLS) {
@@ -144,6 +552,22 @@ void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const json
                 }
             }
 
+            // 记录连接目标，后台传输任务据此从连接池借出连接
+            session->target.host = host;
+            session->target.port = port;
+            session->target.useTLS = useTLS;
+            session->target.tlsConfig = client->tlsConfig;
+            session->limits->setShared({session->sessionLimit, hostLimit(hostKeyOf(session->target))});
+
+            // ---- 连接池模式（需显式开启）：只记录目标，login 时借出已登录的连接 ----
+            if (command.get("pooled", false).asBool()) {
+                session->pendingLease = true;
+
+                response["status"] = "success";
+                sendResponse(hdl, response);
+                return;
+            }
+
             // ---- 先进行普通的连接 ----
             if (!client->connect(host, port)) {
                 response["status"] = "error";
@@ -180,19 +604,152 @@ void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const json
             std::string username = command["username"].asString();
             std::string password = command["password"].asString();
 
-            if (client->login(username, password)) {
+            // 以其他用户重新登录时先归还当前借出的连接
+            if (session->leased) {
+                session->resetClient();
+                session->pendingLease = true;
+            }
+
+            session->target.username = username;
+            session->password = password;
+
+            if (session->pendingLease) {
+
+                std::string error;
+                auto leasedClient = pool.lease(session->target, password, error);
+                if (leasedClient) {
+                    // 保留登录前设置的进度上报参数
+                    leasedClient->progressOptions = client->progressOptions;
+                    client = leasedClient;
+                    session->leased = true;
+                    session->pendingLease = false;
+                    session->loggedIn = true;
+                    response["status"] = "success";
+                } else {
+                    response["status"] = "error";
+                    response["error"] = error;
+                }
+            } else if (client->login(username, password)) {
+                session->loggedIn = true;
                 response["status"] = "success";
             } else {
                 response["status"] = "error";
                 response["error"] = client->getLastError();
             }
 
+            if (session->loggedIn && response["status"].asString() == "success") {
+                // 登录时已获取（或取自缓存）的服务器特性
+                response["features"] = json(Json::arrayValue);
+                for (const auto& feature : client->getFeatures()) {
+                    response["features"].append(feature);
+                }
+            }
+
         } else if (cmd == "list") {
-            auto files = client->listFiles();
-            response["status"] = "success";
-            response["files"] = Json::Value(Json::arrayValue);
-            for (const auto& file : files) {
-                response["files"].append(file);
+            std::string path = command.get("path", "").asString();
+            int pageSize = std::max(0, command.get("pageSize", 0).asInt());
+
+            // pageSize > 0 时每凑满一页即发送一帧，最终响应只包含统计信息
+            json page(Json::arrayValue);
+            Json::Int64 count = 0;
+            int pages = 0;
+            auto flushPage = [&]() {
+                json frame;
+                frame["type"] = "listPage";
+                frame["page"] = pages++;
+                frame["files"].swap(page);
+                sendResponse(hdl, frame);
+                page = json(Json::arrayValue);
+            };
+
+            bool ok = client->listDirectory(path, [&](const FileEntry& entry) {
+                page.append(fileEntryToJson(entry));
+                ++count;
+                if (pageSize > 0 && static_cast<int>(page.size()) >= pageSize) {
+                    flushPage();
+                }
+            });
+
+            if (pageSize > 0) {
+                if (!page.empty()) {
+                    flushPage();
+                }
+                response["count"] = count;
+                response["pages"] = pages;
+            } else if (ok) {
+                response["files"].swap(page);
+            }
+
+            if (ok) {
+                response["status"] = "success";
+            } else {
+                response["status"] = "error";
+                response["error"] = client->getLastError();
+            }
+
+        } else if ((cmd == "upload" || cmd == "download" || cmd == "mirror") &&
+                   command.get("queue", false).asBool()) {
+            submitTransferJob(hdl, session, command, response);
+
+        } else if (cmd == "upload" && command.get("stream", false).asBool()) {
+            // 数据来自本连接随后的二进制帧，空帧表示结束
+            std::string remotePath = command["remotePath"].asString();
+            int64_t offset = command.get("offset", 0).asInt64();
+            int64_t size = command.get("size", -1).asInt64();
+
+            auto progressCallback = std::bind(&FTPWebSocketServer::onProgress,
+                                              this, hdl,
+                                              std::placeholders::_1);
+
+            int64_t bytes = 0;
+            bool ok = client->uploadStream(remotePath, offset, size,
+                [&](char* buffer, size_t capacity, size_t& n) {
+                    if (!session->upload.read(buffer, capacity, n)) {
+                        return false;
+                    }
+                    bytes += static_cast<int64_t>(n);
+                    return true;
+                },
+                progressCallback);
+
+            response["bytes"] = static_cast<Json::Int64>(bytes);
+            if (ok) {
+                response["status"] = "success";
+            } else {
+                response["status"] = "error";
+                response["error"] = client->getLastError();
+            }
+
+        } else if (cmd == "download" && command.get("stream", false).asBool()) {
+            // 数据以二进制帧发给本连接，不写入本地文件
+            std::string remotePath = command["remotePath"].asString();
+            int64_t offset = command.get("offset", 0).asInt64();
+
+            auto progressCallback = std::bind(&FTPWebSocketServer::onProgress,
+                                              this, hdl,
+                                              std::placeholders::_1);
+
+            int64_t bytes = 0;
+            bool ok = client->downloadStream(remotePath, offset,
+                [&](int64_t size) {
+                    json frame;
+                    frame["type"] = "streamStart";
+                    frame["size"] = static_cast<Json::Int64>(size);
+                    frame["offset"] = static_cast<Json::Int64>(offset);
+                    sendResponse(hdl, frame);
+                },
+                [&](const char* data, size_t size) {
+                    bytes += static_cast<int64_t>(size);
+                    return sendBinary(hdl, session, data, size);
+                },
+                progressCallback);
+
+            response["bytes"] = static_cast<Json::Int64>(bytes);
+            if (ok) {
+                response["status"] = "success";
+            } else {
+                response["status"] = "error";
+                response["error"] = client->getLastError();
             }
 
         } else if (cmd == "upload") {
@@ -202,8 +759,7 @@ void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const json
 
             auto progressCallback = std::bind(&FTPWebSocketServer::onProgress,
                                               this, hdl,
-                                              std::placeholders::_1,
-                                              std::placeholders::_2);
+                                              std::placeholders::_1);
 
             if (client->uploadFile(localPath, remotePath, resume, progressCallback)) {
                 response["status"] = "success";
@@ -211,24 +767,62 @@ void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const json
                 response["status"] = "error";
                 response["error"] = client->getLastError();
             }
+            if (command.get("verify", false).asBool()) {
+                response["integrity"] = integrityToJson(client->getLastIntegrity());
+            }
 
         } else if (cmd == "download") {
             std::string remotePath = command["remotePath"].asString();
             std::string localPath = command["localPath"].asString();
             bool resume = command.get("resume", false).asBool();
+            int segments = command.get("segments", 1).asInt();
+
+            auto progressCallback = std::bind(&FTPWebSocketServer::onProgress,
+                                              this, hdl,
+                                              std::placeholders::_1);
+
+            if (client->downloadFileSegmented(remotePath, localPath, segments, resume, progressCallback)) {
+                response["status"] = "success";
+            } else {
+                response["status"] = "error";
+                response["error"] = client->getLastError();
+            }
+            if (command.get("verify", false).asBool()) {
+                response["integrity"] = integrityToJson(client->getLastIntegrity());
+            }
+
+        } else if (cmd == "mirror") {
+            std::string localPath = command["localPath"].asString();
+            std::string remotePath = command["remotePath"].asString();
+            std::string direction = command.get("direction", "download").asString();
+
+            MirrorOptions options;
+            options.parallel = command.get("parallel", 4).asInt();
+            options.dryRun = command.get("dryRun", false).asBool();
+
+            if (direction != "download" && direction != "upload") {
+                response["status"] = "error";
+                response["error"] = "Invalid mirror direction";
+                sendResponse(hdl, response);
+                return;
+            }
+            options.direction = direction == "upload" ? MirrorOptions::Direction::UPLOAD
+                                                      : MirrorOptions::Direction::DOWNLOAD;
 
             auto progressCallback = std::bind(&FTPWebSocketServer::onProgress,
                                               this, hdl,
-                                              std::placeholders::_1,
-                                              std::placeholders::_2);
+                                              std::placeholders::_1);
 
-            if (client->downloadFile(remotePath, localPath, resume, progressCallback)) {
+            MirrorSummary summary;
+            if (client->mirror(localPath, remotePath, options, summary, progressCallback)) {
                 response["status"] = "success";
             } else {
                 response["status"] = "error";
                 response["error"] = client->getLastError();
             }
 
+            response["summary"] = mirrorSummaryToJson(summary);
+
         } else if (cmd == "pwd") {
             std::string currentDir = client->getCurrentDir();
             if (!currentDir.empty()) {
@@ -275,6 +869,20 @@ void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const json
                 response["error"] = client->getLastError();
             }
 
+        } else if (cmd == "batchDelete") {
+            std::vector<std::string> paths;
+            for (const auto& path : command["paths"]) {
+                paths.push_back(path.asString());
+            }
+            bool recursive = command.get("recursive", false).asBool();
+
+            if (batchDeleteFiles(paths, recursive, client, response["results"])) {
+                response["status"] = "success";
+            } else {
+                response["status"] = "error";
+                response["error"] = client->getLastError();
+            }
+
         } else if (cmd == "setTransferMode") {
             std::string mode = command["mode"].asString();
             if (mode == "ACTIVE" || mode == "PASSIVE") {
@@ -287,6 +895,16 @@ void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const json
                 response["error"] = "Invalid transfer mode";
             }
 
+        } else if (cmd == "setProgress") {
+            // 调整本会话的进度上报频率
+            if (command.isMember("intervalMs")) {
+                client->progressOptions.intervalMs = std::max(0, command["intervalMs"].asInt());
+            }
+            if (command.isMember("minBytes")) {
+                client->progressOptions.minBytes = std::max<Json::Int64>(0, command["minBytes"].asInt64());
+            }
+            response["status"] = "success";
+
         } else if (cmd == "setTransferType") {
             std::string type = command["type"].asString();
             if (type == "ASCII" || type == "BINARY") {
@@ -316,24 +934,491 @@ void FTPWebSocketServer::handleFTPCommand(WebSocketConnectionPtr hdl, const json
     sendResponse(hdl, response);
 }
 
+bool FTPWebSocketServer::handleAsyncCommand(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                                            const json& command) {
+    std::string cmd = command.get("cmd", "").asString();
+
+    // 操作完成时在 io_context 线程中发送结果
+    auto respond = [this, hdl](bool ok, const std::string& error) {
+        json response;
+        response["status"] = ok ? "success" : "error";
+        if (!ok) {
+            response["error"] = error;
+        }
+        sendResponse(hdl, response);
+    };
+
+    if (cmd == "connect") {
+        if (session->asyncClient) {
+            session->asyncClient->close();
+            session->asyncClient.reset();
+        }
+        if (!command.get("async", false).asBool()) {
+            return false;
+        }
+        if (command.get("useTLS", false).asBool()) {
+            respond(false, "TLS is not supported in async sessions");
+            return true;
+        }
+
+        session->asyncClient = std::make_shared<AsyncFTPClient>(server.get_io_service());
+        session->asyncClient->setProgressOptions(session->asyncProgress);
+
+        // 该会话已提交到工作线程的命令执行完毕、同步客户端归还或断开之后才开始连接，
+        // 之后的 async 命令在客户端队列中排在连接之后
+        SessionDispatcher::SessionKey key = hdl.lock().get();
+        session->asyncClient->asyncWait([this, key, session](std::function<void()> done) {
+            auto reset = [session, done]() {
+                session->resetClient();
+                done();
+            };
+            if (!dispatcher.post(key, reset)) {
+                reset();    // 分发器已停止或队列已满，不再等待
+            }
+        });
+        session->asyncClient->asyncConnect(command["host"].asString(),
+                                           static_cast<uint16_t>(command["port"].asUInt()), respond);
+        return true;
+    }
+
+    if (!session->asyncClient) {
+        return false;
+    }
+    const std::shared_ptr<AsyncFTPClient>& client = session->asyncClient;
+
+    if (cmd == "login") {
+        client->asyncLogin(command["username"].asString(), command["password"].asString(), respond);
+
+    } else if (cmd == "list") {
+        // 与同步会话相同：pageSize > 0 时每凑满一页即发送一帧，最终响应只包含统计信息
+        struct ListPages {
+            json page = json(Json::arrayValue);
+            Json::Int64 count = 0;
+            int pages = 0;
+        };
+        auto state = std::make_shared<ListPages>();
+        int pageSize = std::max(0, command.get("pageSize", 0).asInt());
+        auto flushPage = [this, hdl, state]() {
+            json frame;
+            frame["type"] = "listPage";
+            frame["page"] = state->pages++;
+            frame["files"].swap(state->page);
+            sendResponse(hdl, frame);
+            state->page = json(Json::arrayValue);
+        };
+
+        client->asyncList(command.get("path", "").asString(),
+            [state, pageSize, flushPage](const FileEntry& entry) {
+                state->page.append(fileEntryToJson(entry));
+                ++state->count;
+                if (pageSize > 0 && static_cast<int>(state->page.size()) >= pageSize) {
+                    flushPage();
+                }
+            },
+            [this, hdl, state, pageSize, flushPage](bool ok, const std::string& error) {
+                json response;
+                if (pageSize > 0) {
+                    if (!state->page.empty()) {
+                        flushPage();
+                    }
+                    response["count"] = state->count;
+                    response["pages"] = state->pages;
+                } else if (ok) {
+                    response["files"].swap(state->page);
+                }
+
+                response["status"] = ok ? "success" : "error";
+                if (!ok) {
+                    response["error"] = error;
+                }
+                sendResponse(hdl, response);
+            });
+
+    } else if ((cmd == "upload" || cmd == "download") && command.get("stream", false).asBool()) {
+        respond(false, "Streaming is not supported in async sessions");
+
+    } else if (cmd == "upload" || cmd == "download") {
+        auto progressCallback = std::bind(&FTPWebSocketServer::onProgress,
+                                          this, hdl,
+                                          std::placeholders::_1);
+        bool resume = command.get("resume", false).asBool();
+        if (cmd == "upload") {
+            client->asyncUpload(command["localPath"].asString(), command["remotePath"].asString(),
+                                resume, progressCallback, respond);
+        } else {
+            client->asyncDownload(command["remotePath"].asString(), command["localPath"].asString(),
+                                  resume, progressCallback, respond);
+        }
+
+    } else if (cmd == "setProgress") {
+        if (command.isMember("intervalMs")) {
+            session->asyncProgress.intervalMs = std::max(0, command["intervalMs"].asInt());
+        }
+        if (command.isMember("minBytes")) {
+            session->asyncProgress.minBytes = std::max<Json::Int64>(0, command["minBytes"].asInt64());
+        }
+        client->setProgressOptions(session->asyncProgress);
+        respond(true, "");
+
+    } else {
+        respond(false, "Command not supported in async session: " + cmd);
+    }
+    return true;
+}
+
 void FTPWebSocketServer::sendResponse(WebSocketConnectionPtr hdl, const json& response) {
-    try {
-        Json::FastWriter writer;
-        std::string message = writer.write(response);
-        server.send(hdl, message, websocketpp::frame::opcode::text);
-    } catch (const std::exception& e) {
-        std::cerr << "Error sending response: " << e.what() << std::endl;
+    Json::FastWriter writer;
+    std::string message = writer.write(response);
+
+    // 同一连接的消息经会话的 strand 按提交顺序发送
+    auto send = [this, hdl, message]() {
+        try {
+            server.send(hdl, message, websocketpp::frame::opcode::text);
+        } catch (const std::exception& e) {
+            std::cerr << "Error sending response: " << e.what() << std::endl;
+        }
+    };
+    auto session = findSession(hdl);
+    if (session) {
+        websocketpp::lib::asio::post(session->strand, send);
+    } else {
+        websocketpp::lib::asio::post(server.get_io_service(), send);
     }
 }
 
-void FTPWebSocketServer::onProgress(WebSocketConnectionPtr hdl, int64_t current, int64_t total) {
-    json progress;
-    progress["type"] = "progress";
-    progress["current"] = static_cast<Json::Int64>(current);
-    progress["total"] = static_cast<Json::Int64>(total);
-    progress["percentage"] = (total > 0) ? (current * 100 / total) : 0;
+bool FTPWebSocketServer::batchDeleteFiles(const std::vector<std::string>& files, bool recursive,
+                                          std::shared_ptr<FTPClient> client, json& results) {
+    std::vector<FTPResponse> replies;
+    bool ok = client->deleteFiles(files, recursive, replies);
 
-    sendResponse(hdl, progress);
+    results = Json::Value(Json::arrayValue);
+    for (size_t i = 0; i < files.size() && i < replies.size(); ++i) {
+        json item;
+        item["path"] = files[i];
+        item["code"] = replies[i].code;
+        if (replies[i].code == 250) {
+            item["status"] = "success";
+        } else {
+            item["status"] = "error";
+            item["error"] = replies[i].msg;
+        }
+        results.append(item);
+    }
+    return ok;
+}
+
+void FTPWebSocketServer::submitTransferJob(WebSocketConnectionPtr hdl, const std::shared_ptr<Session>& session,
+                                           const json& command, json& response) {
+    std::string cmd = command["cmd"].asString();
+
+    if (!session->loggedIn) {
+        response["status"] = "error";
+        response["error"] = "Not logged in";
+        return;
+    }
+    if (command.get("stream", false).asBool()) {
+        response["status"] = "error";
+        response["error"] = "Streaming transfers cannot be queued";
+        return;
+    }
+    std::string direction = command.get("direction", "download").asString();
+    if (cmd == "mirror" && direction != "download" && direction != "upload") {
+        response["status"] = "error";
+        response["error"] = "Invalid mirror direction";
+        return;
+    }
+
+    // 任务借用独立的连接执行，沿用会话当前的传输设置；
+    // 连接借出后位于登录时的初始目录，相对路径以该目录为准
+    FTPConnectionPool::Target target = session->target;
+    std::string password = session->password;
+    TransferMode transferMode = session->client->getTransferMode();
+    TransferType transferType = session->client->getTransferType();
+    ProgressOptions progressOptions = session->client->progressOptions;
+    std::shared_ptr<const RateLimits> limits = session->limits;
+    auto summary = std::make_shared<MirrorSummary>();
+    auto integrity = std::make_shared<IntegrityResult>();
+
+    auto attempts = std::make_shared<int>(0);
+
+    auto work = [this, hdl, command, cmd, direction, target, password, transferMode, transferType,
+                 progressOptions, limits, summary, integrity, attempts](TransferScheduler::JobId id,
+                                                     const std::shared_ptr<TransferControl>& control,
+                                                     std::string& error) {
+        std::shared_ptr<FTPClient> client = pool.lease(target, password, error);
+        if (!client) {
+            return false;
+        }
+        client->setTransferMode(transferMode);
+        client->progressOptions = progressOptions;
+        std::unique_ptr<TransferScope> scope(new TransferScope(*client, control, limits, command));
+        std::unique_ptr<TimeoutScope> timeoutScope(new TimeoutScope(*client, command));
+
+        // 暂停后再次执行时以续传方式继续（目录同步会跳过已完成的文件）
+        bool resume = command.get("resume", false).asBool() || (*attempts)++ > 0;
+
+        auto progressCallback = [this, hdl, id](const TransferProgress& progress) {
+            scheduler.updateProgress(id, progress.current, progress.total);
+            json message = progressToJson(progress);
+            message["jobId"] = static_cast<Json::UInt64>(id);
+            sendResponse(hdl, message);
+        };
+
+        bool ok = transferType == TransferType::BINARY || client->setTransferType(transferType);
+        if (ok && cmd == "upload") {
+            ok = client->uploadFile(command["localPath"].asString(), command["remotePath"].asString(),
+                                    resume, progressCallback);
+        } else if (ok && cmd == "download") {
+            ok = client->downloadFileSegmented(command["remotePath"].asString(),
+                                               command["localPath"].asString(),
+                                               command.get("segments", 1).asInt(),
+                                               resume, progressCallback);
+        } else if (ok) {
+            MirrorOptions options;
+            options.parallel = command.get("parallel", 4).asInt();
+            options.dryRun = command.get("dryRun", false).asBool();
+            options.direction = direction == "upload" ? MirrorOptions::Direction::UPLOAD
+                                                      : MirrorOptions::Direction::DOWNLOAD;
+            ok = client->mirror(command["localPath"].asString(), command["remotePath"].asString(),
+                                options, *summary, progressCallback);
+        }
+
+        if (!ok) {
+            error = client->getLastError();
+        }
+        if (cmd != "mirror") {
+            *integrity = client->getLastIntegrity();
+        }
+        timeoutScope.reset();
+        scope.reset();
+        pool.release(client);
+        return ok;
+    };
+
+    bool verify = command.get("verify", false).asBool();
+    auto onDone = [this, hdl, cmd, summary, integrity, verify](const TransferScheduler::JobInfo& info) {
+        json message = jobToJson(info);
+        message["type"] = "jobComplete";
+        message["status"] = info.state == TransferScheduler::JobState::SUCCEEDED ? "success" : "error";
+        if (cmd == "mirror" && info.state != TransferScheduler::JobState::CANCELLED) {
+            message["summary"] = mirrorSummaryToJson(*summary);
+        }
+        if (cmd != "mirror" && verify && info.state != TransferScheduler::JobState::CANCELLED) {
+            message["integrity"] = integrityToJson(*integrity);
+        }
+        sendResponse(hdl, message);
+    };
+
+    TransferScheduler::JobId id = scheduler.submit(session->id, cmd, hostKeyOf(target),
+                                                   command.get("priority", 0).asInt(),
+                                                   std::move(work), std::move(onDone));
+    if (id == 0) {
+        response["status"] = "error";
+        response["error"] = "Server is shutting down";
+        return;
+    }
+
+    response["status"] = "success";
+    response["jobId"] = static_cast<Json::UInt64>(id);
+}
+
+void FTPWebSocketServer::handleJobCommand(const std::shared_ptr<Session>& session, const std::string& cmd,
+                                          const json& command, json& response) {
+    TransferScheduler::JobId id = command.get("jobId", 0).asUInt64();
+
+    if (cmd == "jobStatus" && !command.isMember("jobId")) {
+        // 未指定任务时列出本会话的全部任务
+        response["status"] = "success";
+        response["jobs"] = json(Json::arrayValue);
+        for (const auto& info : scheduler.list(session->id)) {
+            response["jobs"].append(jobToJson(info));
+        }
+        return;
+    }
+
+    if (cmd == "jobStatus") {
+        TransferScheduler::JobInfo info;
+        if (scheduler.status(session->id, id, info)) {
+            response["status"] = "success";
+            response["job"] = jobToJson(info);
+        } else {
+            response["status"] = "error";
+            response["error"] = "Job not found";
+        }
+        return;
+    }
+
+    if ((cmd == "cancel" || cmd == "pause") && !command.isMember("jobId")) {
+        // 作用于本会话直接执行的传输：被中止的命令以 "Transfer cancelled"/"Transfer paused" 结束，
+        // 暂停的传输可以 resume 参数重新发起
+        if (session->pendingTransfers == 0) {
+            response["status"] = "error";
+            response["error"] = "No transfer in progress";
+            return;
+        }
+        if (cmd == "cancel") {
+            session->transfer->cancel();
+        } else {
+            session->transfer->pause();
+        }
+        // 流式上传可能正阻塞在等待二进制帧上
+        session->upload.interrupt();
+        response["status"] = "success";
+        return;
+    }
+
+    std::string error;
+    bool ok;
+    if (cmd == "cancel") {
+        ok = scheduler.cancel(session->id, id, error);
+    } else if (cmd == "pause") {
+        ok = scheduler.pause(session->id, id, error);
+    } else {
+        ok = scheduler.resume(session->id, id, error);
+    }
+
+    if (ok) {
+        response["status"] = "success";
+    } else {
+        response["status"] = "error";
+        response["error"] = error;
+    }
+}
+
+void FTPWebSocketServer::handleRateLimitCommand(const std::shared_ptr<Session>& session,
+                                                const json& command, json& response) {
+    // 速率单位为字节/秒，0 表示不限速；未给出的项保持不变
+    for (const char* key : {"transfer", "session", "host"}) {
+        if (command.isMember(key) && (!command[key].isNumeric() || command[key].asInt64() < 0)) {
+            response["status"] = "error";
+            response["error"] = std::string("Invalid rate limit: ") + key;
+            return;
+        }
+    }
+
+    // 主机级令牌桶在 connect 后加入
+    std::vector<std::shared_ptr<TokenBucket>> shared = session->limits->getShared();
+    std::shared_ptr<TokenBucket> host = shared.size() > 1 ? shared[1] : nullptr;
+    if (command.isMember("host") && !host) {
+        response["status"] = "error";
+        response["error"] = "Not connected";
+        return;
+    }
+
+    if (command.isMember("transfer")) {
+        session->limits->setTransferRate(command["transfer"].asInt64());
+    }
+    if (command.isMember("session")) {
+        session->sessionLimit->setRate(command["session"].asInt64());
+    }
+    if (command.isMember("host")) {
+        host->setRate(command["host"].asInt64());
+    }
+
+    response["status"] = "success";
+    response["transfer"] = static_cast<Json::Int64>(session->limits->getTransferRate());
+    response["session"] = static_cast<Json::Int64>(session->sessionLimit->getRate());
+    if (host) {
+        response["host"] = static_cast<Json::Int64>(host->getRate());
+    }
+}
+
+std::shared_ptr<TokenBucket> FTPWebSocketServer::hostLimit(const std::string& hostKey) {
+    std::lock_guard<std::mutex> lock(hostLimitMutex);
+    for (auto it = hostLimits.begin(); it != hostLimits.end();) {
+        if (it->second.expired()) {
+            it = hostLimits.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::weak_ptr<TokenBucket>& entry = hostLimits[hostKey];
+    std::shared_ptr<TokenBucket> bucket = entry.lock();
+    if (!bucket) {
+        bucket = std::make_shared<TokenBucket>();
+        entry = bucket;
+    }
+    return bucket;
+}
+
+json FTPWebSocketServer::fileEntryToJson(const FileEntry& entry) {
+    static const char* const TYPE_NAMES[] = { "file", "dir", "link", "other" };
+
+    json item;
+    item["name"] = entry.name;
+    item["type"] = TYPE_NAMES[static_cast<int>(entry.type)];
+    item["size"] = static_cast<Json::Int64>(entry.size);
+    item["mtime"] = static_cast<Json::Int64>(entry.mtime);
+    if (entry.perms >= 0) {
+        // 八进制权限字符串，例如 "0755"
+        char perms[8];
+        snprintf(perms, sizeof(perms), "%04o", static_cast<unsigned>(entry.perms));
+        item["perms"] = perms;
+    }
+    return item;
+}
+
+void FTPWebSocketServer::onProgress(WebSocketConnectionPtr hdl, const TransferProgress& progress) {
+    sendResponse(hdl, progressToJson(progress));
+}
+
+json FTPWebSocketServer::progressToJson(const TransferProgress& progress) {
+    json message;
+    message["type"] = "progress";
+    message["current"] = static_cast<Json::Int64>(progress.current);
+    message["total"] = static_cast<Json::Int64>(progress.total);
+    message["percentage"] = static_cast<Json::Int64>(
+        (progress.total > 0) ? (progress.current * 100 / progress.total) : 100);
+    message["rate"] = static_cast<Json::Int64>(progress.instantRate);
+    message["averageRate"] = static_cast<Json::Int64>(progress.averageRate);
+    message["eta"] = progress.etaSeconds;
+    return message;
+}
+
+json FTPWebSocketServer::jobToJson(const TransferScheduler::JobInfo& info) {
+    json item;
+    item["jobId"] = static_cast<Json::UInt64>(info.id);
+    item["jobType"] = info.type;
+    item["priority"] = info.priority;
+    item["state"] = jobStateName(info.state);
+    item["current"] = static_cast<Json::Int64>(info.current);
+    item["total"] = static_cast<Json::Int64>(info.total);
+    if (!info.error.empty()) {
+        item["error"] = info.error;
+    }
+    return item;
+}
+
+json FTPWebSocketServer::integrityToJson(const IntegrityResult& integrity) {
+    json result;
+    result["verified"] = integrity.verified;
+    result["restarted"] = integrity.restarted;
+    result["algorithm"] = integrity.algorithm;
+    result["digest"] = integrity.digest;
+    return result;
+}
+
+json FTPWebSocketServer::mirrorSummaryToJson(const MirrorSummary& summary) {
+    json result;
+    result["dirsCreated"] = summary.dirsCreated;
+    result["filesTransferred"] = summary.filesTransferred;
+    result["filesSkipped"] = summary.filesSkipped;
+    result["filesFailed"] = summary.filesFailed;
+    result["bytesTransferred"] = static_cast<Json::Int64>(summary.bytesTransferred);
+    result["dirs"] = Json::Value(Json::arrayValue);
+    for (const auto& dir : summary.dirs) {
+        result["dirs"].append(dir.empty() ? "." : dir);
+    }
+    result["files"] = Json::Value(Json::arrayValue);
+    for (const auto& file : summary.files) {
+        result["files"].append(file);
+    }
+    result["errors"] = Json::Value(Json::arrayValue);
+    for (const auto& error : summary.errors) {
+        result["errors"].append(error);
+    }
+    return result;
 }
 
 } // namespace ftp
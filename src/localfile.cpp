@@ -0,0 +1,137 @@
+/**
+ * @file localfile.cpp
+ * @brief 本地文件句柄封装的实现文件
+ */
+
+#include "localfile.h"
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace ftp {
+
+LocalFile::LocalFile() : fd(-1) {}
+
+LocalFile::~LocalFile() {
+    close();
+}
+
+bool LocalFile::open(const std::string& path, Mode mode) {
+    close();
+
+    int flags = 0;
+    switch (mode) {
+        case Mode::READ:
+            flags = O_RDONLY;
+            break;
+        case Mode::WRITE:
+            flags = O_RDWR | O_CREAT | O_TRUNC;
+            break;
+        case Mode::READ_WRITE:
+            flags = O_RDWR | O_CREAT;
+            break;
+    }
+
+#ifdef _WIN32
+    fd = _open(path.c_str(), flags | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    fd = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+#endif
+    return fd >= 0;
+}
+
+void LocalFile::close() {
+    if (fd >= 0) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+        fd = -1;
+    }
+}
+
+int64_t LocalFile::size() const {
+#ifdef _WIN32
+    struct _stati64 st;
+    if (_fstati64(fd, &st) != 0) {
+        return -1;
+    }
+#else
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return -1;
+    }
+#endif
+    return static_cast<int64_t>(st.st_size);
+}
+
+int64_t LocalFile::readAt(int64_t offset, void* buffer, size_t length) {
+#ifdef _WIN32
+    if (_lseeki64(fd, offset, SEEK_SET) != offset) {
+        return -1;
+    }
+    return _read(fd, buffer, static_cast<unsigned int>(length));
+#else
+    return pread(fd, buffer, length, static_cast<off_t>(offset));
+#endif
+}
+
+bool LocalFile::writeAt(int64_t offset, const void* data, size_t length) {
+    const char* ptr = static_cast<const char*>(data);
+
+#ifdef _WIN32
+    if (_lseeki64(fd, offset, SEEK_SET) != offset) {
+        return false;
+    }
+#endif
+
+    while (length > 0) {
+#ifdef _WIN32
+        int written = _write(fd, ptr, static_cast<unsigned int>(length));
+#else
+        ssize_t written = pwrite(fd, ptr, length, static_cast<off_t>(offset));
+#endif
+        if (written <= 0) {
+            return false;
+        }
+        ptr += written;
+        offset += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool LocalFile::resize(int64_t length) {
+#ifdef _WIN32
+    return _chsize_s(fd, length) == 0;
+#else
+    if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+        return false;
+    }
+#ifdef __linux__
+    // 预先分配磁盘块，避免并发写入稀疏文件时产生碎片；文件系统不支持时忽略
+    posix_fallocate(fd, 0, static_cast<off_t>(length));
+#endif
+    return true;
+#endif
+}
+
+bool LocalFile::preallocate(int64_t length) {
+#ifdef __linux__
+    // FALLOC_FL_KEEP_SIZE：只分配磁盘块，文件大小仍反映已写入的数据，断点续传依赖这一点
+    return fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(length)) == 0;
+#else
+    (void)length;
+    return false;
+#endif
+}
+
+} // namespace ftp
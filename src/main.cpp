@@ -6,6 +6,8 @@
 #include "ftpwebsocket.h"
 #include <iostream>
 #include <csignal>
+#include <cstdlib>
+#include <cstring>
 
 ftp::FTPWebSocketServer* server = nullptr;
 
@@ -17,15 +19,70 @@ void signalHandler(int signum) {
     exit(signum);
 }
 
-int main() {
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--port N] [--workers N] [--io-threads N]"
+              << " [--max-transfers N] [--max-transfers-per-host N]\n"
+              << "  --port N                    WebSocket listen port (default 9002)\n"
+              << "  --workers N                 FTP command worker threads, 0 = hardware concurrency (default 0)\n"
+              << "  --io-threads N              threads running the network event loop, 0 = hardware concurrency (default 1)\n"
+              << "  --max-transfers N           queued transfer jobs running at once (default 8)\n"
+              << "  --max-transfers-per-host N  queued transfer jobs running at once per FTP host (default 4)"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long port = 9002;
+    unsigned long workers = 0;
+    unsigned long ioThreads = 1;
+    unsigned long maxTransfers = 8;
+    unsigned long maxTransfersPerHost = 4;
+
+    // 解析命令行参数
+    for (int i = 1; i < argc; ++i) {
+        unsigned long* target = nullptr;
+        if (std::strcmp(argv[i], "--port") == 0) {
+            target = &port;
+        } else if (std::strcmp(argv[i], "--workers") == 0) {
+            target = &workers;
+        } else if (std::strcmp(argv[i], "--io-threads") == 0) {
+            target = &ioThreads;
+        } else if (std::strcmp(argv[i], "--max-transfers") == 0) {
+            target = &maxTransfers;
+        } else if (std::strcmp(argv[i], "--max-transfers-per-host") == 0) {
+            target = &maxTransfersPerHost;
+        } else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        char* end = nullptr;
+        if (!target || i + 1 >= argc ||
+            (*target = std::strtoul(argv[++i], &end, 10), *end != '\0') ||
+            (target == &port && (port == 0 || port > 65535)) ||
+            ((target == &maxTransfers || target == &maxTransfersPerHost) && *target == 0)) {
+            std::cerr << "Invalid argument: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
     // 注册信号处理
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+#ifndef _WIN32
+    // 对端关闭或传输被中止时写 socket 返回错误，而不是终止进程
+    signal(SIGPIPE, SIG_IGN);
+#endif
 
     try {
         // 创建并启动WebSocket服务器
-        server = new ftp::FTPWebSocketServer(9002);
-        std::cout << "WebSocket server starting on port 9002..." << std::endl;
+        ftp::TransferScheduler::Options schedulerOptions;
+        schedulerOptions.maxConcurrent = maxTransfers;
+        schedulerOptions.maxPerHost = maxTransfersPerHost;
+
+        server = new ftp::FTPWebSocketServer(static_cast<uint16_t>(port), workers, ioThreads,
+                                             schedulerOptions);
+        std::cout << "WebSocket server starting on port " << port << "..." << std::endl;
         std::cout << "Press Ctrl+C to stop the server." << std::endl;
         server->run();
     } catch (const std::exception& e) {
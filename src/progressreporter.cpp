@@ -0,0 +1,64 @@
+/**
+ * @file progressreporter.cpp
+ * @brief 进度上报器的实现文件
+ */
+
+#include "progressreporter.h"
+
+namespace ftp {
+
+ProgressReporter::ProgressReporter(const ProgressCallback& callback, const ProgressOptions& options,
+                                   int64_t total, int64_t start) :
+    callback(callback),
+    options(options),
+    total(total),
+    startBytes(start),
+    startTime(Clock::now()),
+    lastBytes(start),
+    lastTime(startTime),
+    smoothedRate(0.0),
+    emitted(false) {}
+
+void ProgressReporter::maybeEmit(int64_t current) {
+    // 字节数条件满足后才读取时钟
+    Clock::time_point now = Clock::now();
+    if (now - lastTime >= std::chrono::milliseconds(options.intervalMs)) {
+        emit(current, now);
+    }
+}
+
+void ProgressReporter::finish(int64_t current) {
+    if (callback && (current != lastBytes || !emitted)) {
+        emit(current, Clock::now());
+    }
+}
+
+void ProgressReporter::emit(int64_t current, Clock::time_point now) {
+    double sinceLast = std::chrono::duration<double>(now - lastTime).count();
+    double sinceStart = std::chrono::duration<double>(now - startTime).count();
+
+    TransferProgress progress;
+    progress.current = current;
+    progress.total = total;
+    progress.instantRate = sinceLast > 0 ? (current - lastBytes) / sinceLast : 0.0;
+    progress.averageRate = sinceStart > 0 ? (current - startBytes) / sinceStart : 0.0;
+
+    // 指数平滑，避免剩余时间随瞬时速率剧烈跳动
+    smoothedRate = emitted ? smoothedRate * 0.7 + progress.instantRate * 0.3
+                           : progress.instantRate;
+    if (current >= total) {
+        progress.etaSeconds = 0.0;
+    } else if (smoothedRate > 0) {
+        progress.etaSeconds = (total - current) / smoothedRate;
+    } else {
+        progress.etaSeconds = -1.0;
+    }
+
+    lastBytes = current;
+    lastTime = now;
+    emitted = true;
+
+    callback(progress);
+}
+
+} // namespace ftp
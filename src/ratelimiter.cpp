@@ -0,0 +1,130 @@
+/**
+ * @file ratelimiter.cpp
+ * @brief 令牌桶限速的实现文件
+ */
+
+#include "ratelimiter.h"
+#include <algorithm>
+#include <thread>
+
+namespace ftp {
+
+namespace {
+
+/**
+ * @brief 等待期间检查停止请求的间隔
+ */
+const std::chrono::milliseconds STOP_CHECK_INTERVAL(50);
+
+} // namespace
+
+TokenBucket::TokenBucket(int64_t bytesPerSecond) :
+    rate(std::max<int64_t>(bytesPerSecond, 0)),
+    tokens(0),
+    last(std::chrono::steady_clock::now()) {}
+
+void TokenBucket::setRate(int64_t bytesPerSecond) {
+    bytesPerSecond = std::max<int64_t>(bytesPerSecond, 0);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (rate.load() == bytesPerSecond) {
+        return;
+    }
+    rate = bytesPerSecond;
+    tokens = 0;
+    last = std::chrono::steady_clock::now();
+}
+
+std::chrono::nanoseconds TokenBucket::consume(size_t bytes) {
+    if (rate.load() <= 0) {
+        return std::chrono::nanoseconds(0);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    double r = static_cast<double>(rate.load());
+    if (r <= 0) {
+        return std::chrono::nanoseconds(0);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last).count();
+    last = now;
+    tokens = std::min(tokens + elapsed * r, r * BURST_SECONDS);
+    tokens -= static_cast<double>(bytes);
+    if (tokens >= 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    return std::chrono::nanoseconds(static_cast<int64_t>(-tokens / r * 1e9));
+}
+
+void RateLimits::setShared(std::vector<std::shared_ptr<TokenBucket>> buckets) {
+    std::lock_guard<std::mutex> lock(mutex);
+    shared = std::move(buckets);
+}
+
+std::vector<std::shared_ptr<TokenBucket>> RateLimits::getShared() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return shared;
+}
+
+RateLimiter::RateLimiter(std::shared_ptr<const RateLimits> limits) :
+    limits(std::move(limits)) {
+
+    if (this->limits) {
+        transfer.setRate(this->limits->getTransferRate());
+        shared = this->limits->getShared();
+    }
+}
+
+size_t RateLimiter::batchSize(size_t max) const {
+    if (!limits) {
+        return max;
+    }
+
+    int64_t lowest = limits->getTransferRate();
+    for (const auto& bucket : shared) {
+        int64_t rate = bucket->getRate();
+        if (rate > 0 && (lowest <= 0 || rate < lowest)) {
+            lowest = rate;
+        }
+    }
+    if (lowest <= 0) {
+        return max;
+    }
+
+    size_t batch = static_cast<size_t>(lowest * BATCH_MILLISECONDS / 1000);
+    if (batch < MIN_BATCH) {
+        batch = MIN_BATCH;
+    }
+    return std::min(batch, max);
+}
+
+bool RateLimiter::consume(size_t bytes, const std::function<bool()>& stopped) {
+    if (!limits || bytes == 0) {
+        return true;
+    }
+
+    // 单个传输的速率可在传输中修改
+    transfer.setRate(limits->getTransferRate());
+    std::chrono::nanoseconds wait = transfer.consume(bytes);
+    for (const auto& bucket : shared) {
+        wait = std::max(wait, bucket->consume(bytes));
+    }
+    if (wait.count() <= 0) {
+        return true;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + wait;
+    while (true) {
+        if (stopped && stopped()) {
+            return false;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            deadline - now, STOP_CHECK_INTERVAL));
+    }
+}
+
+} // namespace ftp
@@ -0,0 +1,109 @@
+/**
+ * @file replybuffer.cpp
+ * @brief 控制连接响应解析器的实现文件
+ */
+
+#include "replybuffer.h"
+#include <cstring>
+
+namespace ftp {
+
+namespace {
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+} // namespace
+
+ReplyBuffer::ReplyBuffer() : head(0), tail(0), scanPos(0), replyEnd(0) {}
+
+char* ReplyBuffer::prepare(size_t& available) {
+    if (head == tail) {
+        head = tail = scanPos = 0;
+    }
+    if (tail - head >= MAX_BUFFERED) {
+        available = 0;
+        return nullptr;
+    }
+
+    if (storage.size() - tail < MIN_READ_SIZE) {
+        // 先把未取出的数据移到开头，空间仍不足时再扩容
+        if (head > 0) {
+            std::memmove(storage.data(), storage.data() + head, tail - head);
+            tail -= head;
+            scanPos -= head;
+            if (replyEnd != 0) {
+                replyEnd -= head;
+            }
+            head = 0;
+        }
+        if (storage.size() - tail < MIN_READ_SIZE) {
+            storage.resize(storage.size() * 2 > tail + MIN_READ_SIZE
+                               ? storage.size() * 2 : tail + MIN_READ_SIZE);
+        }
+    }
+
+    available = storage.size() - tail;
+    return storage.data() + tail;
+}
+
+bool ReplyBuffer::hasReply() {
+    if (replyEnd != 0) {
+        return true;
+    }
+
+    const char* base = storage.data();
+    while (scanPos < tail) {
+        const char* lineStart = base + scanPos;
+        const char* eol = static_cast<const char*>(std::memchr(lineStart, '\n', tail - scanPos));
+        if (!eol) {
+            return false;
+        }
+        size_t lineLength = static_cast<size_t>(eol - lineStart);
+
+        bool isFinal;
+        if (scanPos == head) {
+            // 格式不符合 "ddd-" 的首行按单行响应处理
+            isFinal = !(lineLength >= 4 && isDigit(lineStart[0]) && isDigit(lineStart[1]) &&
+                        isDigit(lineStart[2]) && lineStart[3] == '-');
+        } else {
+            isFinal = lineLength >= 4 && std::memcmp(lineStart, base + head, 3) == 0 &&
+                      lineStart[3] == ' ';
+        }
+
+        scanPos += lineLength + 1;
+        if (isFinal) {
+            replyEnd = scanPos;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ReplyBuffer::next(int& code, std::string_view& text) {
+    if (!hasReply()) {
+        return false;
+    }
+
+    std::string_view reply(storage.data() + head, replyEnd - head);
+    head = scanPos = replyEnd;
+    replyEnd = 0;
+
+    code = 0;
+    if (reply.size() >= 3 && isDigit(reply[0]) && isDigit(reply[1]) && isDigit(reply[2])) {
+        code = (reply[0] - '0') * 100 + (reply[1] - '0') * 10 + (reply[2] - '0');
+        reply.remove_prefix(reply.size() >= 4 ? 4 : 3);
+    }
+    while (!reply.empty() && (reply.back() == '\n' || reply.back() == '\r')) {
+        reply.remove_suffix(1);
+    }
+    text = reply;
+    return true;
+}
+
+void ReplyBuffer::clear() {
+    head = tail = scanPos = replyEnd = 0;
+}
+
+} // namespace ftp
@@ -0,0 +1,139 @@
+/**
+ * @file sessiondispatcher.cpp
+ * @brief 会话任务分发器的实现文件
+ */
+
+#include "sessiondispatcher.h"
+#include <iostream>
+#include <exception>
+
+namespace ftp {
+
+SessionDispatcher::SessionDispatcher(size_t workerCount, size_t maxPendingPerSession) :
+    maxPending(maxPendingPerSession),
+    stopping(false) {
+
+    if (workerCount == 0) {
+        workerCount = std::thread::hardware_concurrency();
+        if (workerCount == 0) {
+            workerCount = 4;
+        }
+    }
+
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&SessionDispatcher::workerLoop, this);
+    }
+}
+
+SessionDispatcher::~SessionDispatcher() {
+    shutdown();
+}
+
+bool SessionDispatcher::post(SessionKey key, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return false;
+        }
+
+        // 连接句柄地址可能被新会话复用，已关闭的队列不再接收任务
+        auto& queue = sessions[key];
+        if (!queue || queue->removed) {
+            queue = std::make_shared<SessionQueue>(key);
+        }
+
+        if (queue->tasks.size() >= maxPending) {
+            return false;
+        }
+
+        queue->tasks.push_back(std::move(task));
+        if (queue->scheduled) {
+            // 该会话正在执行或已在就绪队列中，保持顺序，无需唤醒
+            return true;
+        }
+        queue->scheduled = true;
+        ready.push_back(queue);
+    }
+    cv.notify_one();
+    return true;
+}
+
+void SessionDispatcher::removeSession(SessionKey key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sessions.find(key);
+    if (it == sessions.end()) {
+        return;
+    }
+
+    it->second->removed = true;
+    if (!it->second->scheduled) {
+        sessions.erase(it);
+    }
+}
+
+void SessionDispatcher::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+        ready.clear();
+        sessions.clear();
+    }
+    cv.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable() && worker.get_id() != std::this_thread::get_id()) {
+            worker.join();
+        }
+    }
+}
+
+void SessionDispatcher::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        cv.wait(lock, [this] { return stopping || !ready.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        std::shared_ptr<SessionQueue> queue = ready.front();
+        ready.pop_front();
+        Task task = std::move(queue->tasks.front());
+        queue->tasks.pop_front();
+
+        lock.unlock();
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Session task error: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Session task error: unknown exception" << std::endl;
+        }
+        task = nullptr;
+        lock.lock();
+
+        if (stopping) {
+            return;
+        }
+
+        if (!queue->tasks.empty()) {
+            // 每次只执行一个任务后重新排队，使繁忙会话不会饿死其它会话
+            ready.push_back(queue);
+            cv.notify_one();
+        } else {
+            queue->scheduled = false;
+            if (queue->removed) {
+                auto it = sessions.find(queue->key);
+                if (it != sessions.end() && it->second == queue) {
+                    sessions.erase(it);
+                }
+            }
+        }
+    }
+}
+
+} // namespace ftp
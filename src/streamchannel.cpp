@@ -0,0 +1,152 @@
+/**
+ * @file streamchannel.cpp
+ * @brief 流式上传数据通道的实现文件
+ */
+
+#include "streamchannel.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ftp {
+
+StreamChannel::StreamChannel() :
+    frontOffset(0),
+    buffered(0),
+    paused(false),
+    interrupted(false),
+    state(State::IDLE) {}
+
+void StreamChannel::setResumeCallback(ResumeCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    onResume = std::move(callback);
+}
+
+bool StreamChannel::open() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state != State::IDLE) {
+        return false;
+    }
+    state = State::OPEN;
+    return true;
+}
+
+bool StreamChannel::push(std::string data, bool& pause) {
+    pause = false;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    switch (state) {
+    case State::OPEN:
+        if (data.empty()) {
+            state = State::FINISHED;
+        } else {
+            buffered += data.size();
+            chunks.push_back(std::move(data));
+            if (!paused && buffered >= HIGH_WATERMARK) {
+                paused = true;
+                pause = true;
+            }
+        }
+        cv.notify_all();
+        return true;
+
+    case State::DISCARDING:
+        if (data.empty()) {
+            state = State::IDLE;
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool StreamChannel::read(char* buffer, size_t capacity, size_t& size) {
+    size = 0;
+    bool resume = false;
+    ResumeCallback callback;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() {
+            return !chunks.empty() || state != State::OPEN || interrupted;
+        });
+        if (state == State::ABORTED || interrupted) {
+            return false;
+        }
+
+        // 尽量填满调用方的缓冲区，减少数据连接上的小块写入
+        while (size < capacity && !chunks.empty()) {
+            const std::string& front = chunks.front();
+            size_t n = std::min(capacity - size, front.size() - frontOffset);
+            std::memcpy(buffer + size, front.data() + frontOffset, n);
+            size += n;
+            frontOffset += n;
+            buffered -= n;
+            if (frontOffset == front.size()) {
+                chunks.pop_front();
+                frontOffset = 0;
+            }
+        }
+
+        if (paused && buffered <= LOW_WATERMARK) {
+            paused = false;
+            resume = true;
+            callback = onResume;
+        }
+    }
+
+    if (resume && callback) {
+        callback();
+    }
+    return true;
+}
+
+void StreamChannel::close() {
+    bool resume;
+    ResumeCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (state == State::ABORTED || state == State::IDLE) {
+            return;
+        }
+        state = state == State::FINISHED ? State::IDLE : State::DISCARDING;
+        interrupted = false;
+        resume = discardLocked();
+        callback = onResume;
+    }
+
+    if (resume && callback) {
+        callback();
+    }
+}
+
+void StreamChannel::interrupt() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (state != State::OPEN && state != State::FINISHED) {
+            return;
+        }
+        interrupted = true;
+    }
+    cv.notify_all();
+}
+
+void StreamChannel::abort() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        state = State::ABORTED;
+        discardLocked();
+        onResume = nullptr;
+    }
+    cv.notify_all();
+}
+
+bool StreamChannel::discardLocked() {
+    chunks.clear();
+    frontOffset = 0;
+    buffered = 0;
+    bool wasPaused = paused;
+    paused = false;
+    return wasPaused;
+}
+
+} // namespace ftp
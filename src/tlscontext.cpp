@@ -0,0 +1,187 @@
+/**
+ * @file tlscontext.cpp
+ * @brief SSL_CTX 缓存与 TLS 会话缓存的实现文件
+ */
+
+#include "tlscontext.h"
+#include <algorithm>
+
+namespace ftp {
+
+TLSContextCache& TLSContextCache::instance() {
+    static TLSContextCache cache;
+    return cache;
+}
+
+std::string TLSContextCache::makeKey(const FTPClient::TLSConfig& config) {
+    std::string key = config.verify_peer ? "1" : "0";
+    key += '\n' + config.ca_file;
+    key += '\n' + config.ca_path;
+    key += '\n' + config.cert_file;
+    key += '\n' + config.key_file;
+    return key;
+}
+
+std::shared_ptr<SSL_CTX> TLSContextCache::acquire(const FTPClient::TLSConfig& config, std::string& error) {
+    std::string key = makeKey(config);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = contexts.find(key);
+    if (it != contexts.end()) {
+        return it->second;
+    }
+
+    std::shared_ptr<SSL_CTX> ctx = create(config, error);
+    if (ctx) {
+        contexts[key] = ctx;
+    }
+    return ctx;
+}
+
+void TLSContextCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    contexts.clear();
+}
+
+std::shared_ptr<SSL_CTX> TLSContextCache::create(const FTPClient::TLSConfig& config, std::string& error) {
+    const SSL_METHOD* method = TLS_client_method();
+    if (!method) {
+        error = "Failed to create SSL method";
+        return nullptr;
+    }
+
+    std::shared_ptr<SSL_CTX> ctx(SSL_CTX_new(method), SSL_CTX_free);
+    if (!ctx) {
+        error = "Failed to create SSL context";
+        return nullptr;
+    }
+
+#ifdef SSL_OP_ENABLE_KTLS
+    // 允许在内核支持时启用内核TLS，上传时可通过 SSL_sendfile 零拷贝发送
+    SSL_CTX_set_options(ctx.get(), SSL_OP_ENABLE_KTLS);
+#endif
+
+    // 会话由 TLSSessionCache 按服务器地址管理，不使用 OpenSSL 内部缓存
+    SSL_CTX_set_session_cache_mode(ctx.get(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx.get(), &TLSSessionCache::onNewSession);
+
+    // 配置证书验证
+    if (config.verify_peer) {
+        SSL_CTX_set_verify(ctx.get(), SSL_VERIFY_PEER, nullptr);
+
+        // 加载CA证书
+        if (!config.ca_file.empty() || !config.ca_path.empty()) {
+            if (!SSL_CTX_load_verify_locations(ctx.get(),
+                config.ca_file.empty() ? nullptr : config.ca_file.c_str(),
+                config.ca_path.empty() ? nullptr : config.ca_path.c_str())) {
+                error = "Failed to load CA certificates";
+                return nullptr;
+            }
+        } else {
+            SSL_CTX_set_default_verify_paths(ctx.get());
+        }
+    }
+
+    // 加载客户端证书
+    if (!config.cert_file.empty()) {
+        if (SSL_CTX_use_certificate_file(ctx.get(), config.cert_file.c_str(), SSL_FILETYPE_PEM) <= 0) {
+            error = "Failed to load client certificate";
+            return nullptr;
+        }
+    }
+
+    // 加载客户端私钥
+    if (!config.key_file.empty()) {
+        if (SSL_CTX_use_PrivateKey_file(ctx.get(), config.key_file.c_str(), SSL_FILETYPE_PEM) <= 0) {
+            error = "Failed to load client private key";
+            return nullptr;
+        }
+
+        // 验证私钥
+        if (!SSL_CTX_check_private_key(ctx.get())) {
+            error = "Client private key does not match the certificate public key";
+            return nullptr;
+        }
+    }
+
+    return ctx;
+}
+
+TLSSessionCache& TLSSessionCache::instance() {
+    static TLSSessionCache cache;
+    return cache;
+}
+
+TLSSessionCache::~TLSSessionCache() {
+    for (auto& pair : sessions) {
+        SSL_SESSION_free(pair.second);
+    }
+}
+
+int TLSSessionCache::keyIndex() {
+    static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+SSL_SESSION* TLSSessionCache::get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sessions.find(key);
+    if (it == sessions.end()) {
+        return nullptr;
+    }
+
+    // 返回副本：OpenSSL 在 TLS 1.3 下使用过的会话会被标记为不可再恢复
+    return SSL_SESSION_dup(it->second);
+}
+
+void TLSSessionCache::put(const std::string& key, SSL_SESSION* session) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sessions.find(key);
+    if (it != sessions.end()) {
+        SSL_SESSION_free(it->second);
+        it->second = session;
+        return;
+    }
+
+    if (sessions.size() >= MAX_SESSIONS && !order.empty()) {
+        auto oldest = sessions.find(order.front());
+        if (oldest != sessions.end()) {
+            SSL_SESSION_free(oldest->second);
+            sessions.erase(oldest);
+        }
+        order.pop_front();
+    }
+
+    sessions[key] = session;
+    order.push_back(key);
+}
+
+void TLSSessionCache::remove(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sessions.find(key);
+    if (it != sessions.end()) {
+        SSL_SESSION_free(it->second);
+        sessions.erase(it);
+        auto pos = std::find(order.begin(), order.end(), key);
+        if (pos != order.end()) {
+            order.erase(pos);
+        }
+    }
+}
+
+int TLSSessionCache::onNewSession(SSL* ssl, SSL_SESSION* session) {
+    // 只有登记了缓存键的控制连接会话才被保存，数据连接复用控制连接的会话
+    const std::string* key = static_cast<const std::string*>(SSL_get_ex_data(ssl, keyIndex()));
+    if (!key || !SSL_SESSION_is_resumable(session)) {
+        return 0;
+    }
+
+    // 保存副本，控制连接的会话随后还会被数据连接复用
+    SSL_SESSION* copy = SSL_SESSION_dup(session);
+    if (copy) {
+        instance().put(*key, copy);
+    }
+    return 0;
+}
+
+} // namespace ftp
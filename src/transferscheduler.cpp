@@ -0,0 +1,399 @@
+/**
+ * @file transferscheduler.cpp
+ * @brief 传输任务调度器的实现文件
+ */
+
+#include "transferscheduler.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace ftp {
+
+const char* jobStateName(TransferScheduler::JobState state) {
+    switch (state) {
+    case TransferScheduler::JobState::QUEUED:    return "queued";
+    case TransferScheduler::JobState::PAUSED:    return "paused";
+    case TransferScheduler::JobState::RUNNING:   return "running";
+    case TransferScheduler::JobState::SUCCEEDED: return "succeeded";
+    case TransferScheduler::JobState::FAILED:    return "failed";
+    case TransferScheduler::JobState::CANCELLED: return "cancelled";
+    }
+    return "unknown";
+}
+
+TransferScheduler::TransferScheduler(const Options& options) :
+    options(options),
+    nextId(1),
+    running(0),
+    stopping(false) {
+
+    if (this->options.maxConcurrent == 0) {
+        this->options.maxConcurrent = 1;
+    }
+    if (this->options.maxPerHost == 0) {
+        this->options.maxPerHost = this->options.maxConcurrent;
+    }
+
+    workers.reserve(this->options.maxConcurrent);
+    for (size_t i = 0; i < this->options.maxConcurrent; ++i) {
+        workers.emplace_back(&TransferScheduler::workerLoop, this);
+    }
+}
+
+TransferScheduler::~TransferScheduler() {
+    shutdown();
+}
+
+TransferScheduler::JobId TransferScheduler::submit(OwnerId owner, const std::string& type,
+                                                   const std::string& host, int priority,
+                                                   Work work, DoneCallback onDone) {
+    auto job = std::make_shared<Job>();
+    job->info.owner = owner;
+    job->info.type = type;
+    job->info.host = host;
+    job->info.priority = priority;
+    job->info.state = JobState::QUEUED;
+    job->info.current = 0;
+    job->info.total = -1;
+    job->work = std::move(work);
+    job->onDone = std::move(onDone);
+    job->control = std::make_shared<TransferControl>();
+    job->detached = false;
+    job->resumed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return 0;
+        }
+        job->info.id = nextId++;
+        jobs[job->info.id] = job;
+        queued[job->info.id] = job;
+    }
+    cv.notify_one();
+    return job->info.id;
+}
+
+bool TransferScheduler::status(OwnerId owner, JobId id, JobInfo& info) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto job = findLocked(owner, id);
+    if (!job) {
+        return false;
+    }
+    info = job->info;
+    return true;
+}
+
+std::vector<TransferScheduler::JobInfo> TransferScheduler::list(OwnerId owner) const {
+    std::vector<JobInfo> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& pair : jobs) {
+            if (pair.second->info.owner == owner) {
+                result.push_back(pair.second->info);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const JobInfo& a, const JobInfo& b) {
+        return a.id < b.id;
+    });
+    return result;
+}
+
+bool TransferScheduler::cancel(OwnerId owner, JobId id, std::string& error) {
+    JobInfo info;
+    DoneCallback onDone;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto job = findLocked(owner, id);
+        if (!job) {
+            error = "Job not found";
+            return false;
+        }
+        if (job->info.state == JobState::RUNNING) {
+            // 执行线程在传输中止后把任务标记为已取消
+            job->control->cancel();
+            return true;
+        }
+        if (job->info.state != JobState::QUEUED && job->info.state != JobState::PAUSED) {
+            error = "Job has already finished";
+            return false;
+        }
+
+        queued.erase(id);
+        job->info.state = JobState::CANCELLED;
+        job->info.error = "Cancelled";
+        info = job->info;
+        onDone = std::move(job->onDone);
+        job->work = nullptr;
+        finishLocked(job);
+    }
+
+    if (onDone) {
+        onDone(info);
+    }
+    return true;
+}
+
+bool TransferScheduler::pause(OwnerId owner, JobId id, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto job = findLocked(owner, id);
+    if (!job) {
+        error = "Job not found";
+        return false;
+    }
+    if (job->info.state == JobState::PAUSED) {
+        return true;
+    }
+    if (job->info.state == JobState::RUNNING) {
+        job->control->pause();
+        job->resumed = false;
+        return true;
+    }
+    if (job->info.state != JobState::QUEUED) {
+        error = "Job has already finished";
+        return false;
+    }
+
+    queued.erase(id);
+    job->info.state = JobState::PAUSED;
+    return true;
+}
+
+bool TransferScheduler::resume(OwnerId owner, JobId id, std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto job = findLocked(owner, id);
+        if (!job) {
+            error = "Job not found";
+            return false;
+        }
+        if (job->info.state == JobState::RUNNING) {
+            // 暂停请求已发出时传输仍会停止，由执行线程在停止后重新排队
+            if (job->control->pending() == TransferControl::Request::PAUSE) {
+                job->resumed = true;
+            }
+            return true;
+        }
+        if (job->info.state == JobState::QUEUED) {
+            return true;
+        }
+        if (job->info.state != JobState::PAUSED) {
+            error = "Job has already finished";
+            return false;
+        }
+
+        // 以原任务 ID 重新排队，恢复其原有的先后顺序
+        job->info.state = JobState::QUEUED;
+        queued[id] = job;
+    }
+    cv.notify_one();
+    return true;
+}
+
+void TransferScheduler::updateProgress(JobId id, int64_t current, int64_t total) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it != jobs.end()) {
+        it->second->info.current = current;
+        it->second->info.total = total;
+    }
+}
+
+void TransferScheduler::removeOwner(OwnerId owner) {
+    std::vector<std::shared_ptr<Job>> dropped;  // 在锁外释放任务体
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = jobs.begin(); it != jobs.end();) {
+        const std::shared_ptr<Job>& job = it->second;
+        if (job->info.owner != owner) {
+            ++it;
+            continue;
+        }
+        if (job->info.state == JobState::RUNNING) {
+            // 中止正在执行的任务，结束后直接丢弃，不再回调
+            job->control->cancel();
+            job->detached = true;
+            dropped.push_back(job);
+            job->onDone = nullptr;
+            ++it;
+            continue;
+        }
+        queued.erase(job->info.id);
+        dropped.push_back(job);
+        it = jobs.erase(it);
+    }
+
+    finished.erase(std::remove_if(finished.begin(), finished.end(), [this](JobId id) {
+        return jobs.find(id) == jobs.end();
+    }), finished.end());
+}
+
+void TransferScheduler::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return;
+        }
+        stopping = true;
+        queued.clear();
+        for (const auto& pair : jobs) {
+            if (pair.second->info.state == JobState::RUNNING) {
+                pair.second->control->cancel();
+            }
+        }
+    }
+    cv.notify_all();
+
+    for (auto& worker : workers) {
+        if (!worker.joinable()) {
+            continue;
+        }
+        if (worker.get_id() == std::this_thread::get_id()) {
+            // 在任务回调中调用：当前线程无法等待自己，返回后随 workerLoop 结束
+            worker.detach();
+        } else {
+            worker.join();
+        }
+    }
+}
+
+size_t TransferScheduler::queuedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queued.size();
+}
+
+size_t TransferScheduler::runningCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return running;
+}
+
+void TransferScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        std::shared_ptr<Job> job;
+        cv.wait(lock, [this, &job] {
+            return stopping || (job = pickLocked()) != nullptr;
+        });
+        if (stopping) {
+            return;
+        }
+
+        const JobInfo& info = job->info;
+        queued.erase(info.id);
+        job->info.state = JobState::RUNNING;
+        ++running;
+        ++runningPerHost[info.host];
+        ++runningPerOwner[info.owner];
+        // 暂停后还会再次执行，保留任务体
+        Work work = job->work;
+        std::shared_ptr<TransferControl> control = job->control;
+        control->reset();
+        job->resumed = false;
+        lock.unlock();
+
+        std::string error;
+        bool ok = false;
+        try {
+            ok = work(info.id, control, error);
+        } catch (const std::exception& e) {
+            error = e.what();
+        } catch (...) {
+            error = "Unknown error";
+        }
+        work = nullptr;
+
+        lock.lock();
+        --running;
+        if (--runningPerHost[info.host] == 0) {
+            runningPerHost.erase(info.host);
+        }
+        if (--runningPerOwner[info.owner] == 0) {
+            runningPerOwner.erase(info.owner);
+        }
+
+        // 传输完成后才到达的停止请求不影响结果
+        TransferControl::Request request = ok ? TransferControl::Request::NONE : control->pending();
+        if (request == TransferControl::Request::PAUSE && !job->detached && !stopping) {
+            if (job->resumed) {
+                // 暂停期间已被恢复，以原任务 ID 重新排队
+                job->resumed = false;
+                job->info.state = JobState::QUEUED;
+                queued[info.id] = job;
+            } else {
+                job->info.state = JobState::PAUSED;
+            }
+            cv.notify_all();
+            continue;
+        }
+
+        if (request == TransferControl::Request::NONE) {
+            job->info.state = ok ? JobState::SUCCEEDED : JobState::FAILED;
+            job->info.error = ok ? std::string() : error;
+        } else {
+            job->info.state = JobState::CANCELLED;
+            job->info.error = "Cancelled";
+        }
+        job->work = nullptr;
+        JobInfo result = job->info;
+        DoneCallback onDone = std::move(job->onDone);
+        finishLocked(job);
+
+        // 释放了主机名额，其它线程可能有任务可以运行
+        cv.notify_all();
+
+        if (onDone) {
+            lock.unlock();
+            onDone(result);
+            onDone = nullptr;
+            lock.lock();
+        }
+    }
+}
+
+std::shared_ptr<TransferScheduler::Job> TransferScheduler::pickLocked() {
+    std::shared_ptr<Job> best;
+    size_t bestOwnerRunning = 0;
+
+    // queued 按提交顺序遍历，只有严格更优时才替换，优先级与会话负载相同时先提交的优先
+    for (const auto& pair : queued) {
+        const std::shared_ptr<Job>& job = pair.second;
+        auto host = runningPerHost.find(job->info.host);
+        if (host != runningPerHost.end() && host->second >= options.maxPerHost) {
+            continue;
+        }
+
+        auto owner = runningPerOwner.find(job->info.owner);
+        size_t ownerRunning = owner != runningPerOwner.end() ? owner->second : 0;
+        if (!best || job->info.priority > best->info.priority ||
+            (job->info.priority == best->info.priority && ownerRunning < bestOwnerRunning)) {
+            best = job;
+            bestOwnerRunning = ownerRunning;
+        }
+    }
+    return best;
+}
+
+void TransferScheduler::finishLocked(const std::shared_ptr<Job>& job) {
+    if (job->detached) {
+        jobs.erase(job->info.id);
+        return;
+    }
+
+    finished.push_back(job->info.id);
+    while (finished.size() > options.maxFinishedJobs) {
+        jobs.erase(finished.front());
+        finished.pop_front();
+    }
+}
+
+std::shared_ptr<TransferScheduler::Job> TransferScheduler::findLocked(OwnerId owner, JobId id) const {
+    auto it = jobs.find(id);
+    if (it == jobs.end() || it->second->info.owner != owner) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+} // namespace ftp
@@ -0,0 +1,125 @@
+/**
+ * @file ftplistparser_test.cpp
+ * @brief 目录列表解析器（MLSD、Unix 与 Windows/IIS 格式的 LIST）的单元测试
+ */
+
+#include "ftplistparser.h"
+#include "testing.h"
+
+using namespace ftp;
+
+namespace {
+
+void testTimestamp() {
+    EXPECT_EQ(parseFTPTimestamp("20240131101500"), 1706696100);
+    EXPECT_EQ(parseFTPTimestamp("20240131101500.123"), 1706696100);
+    EXPECT_EQ(parseFTPTimestamp("2024013110150"), -1);
+    EXPECT_EQ(parseFTPTimestamp("2024013110150x"), -1);
+}
+
+void testMLSD() {
+    ListingParser parser(ListingParser::Format::MLSD);
+    FileEntry entry;
+
+    EXPECT_TRUE(parser.parseLine("type=file;size=1024;modify=20240131101500;unix.mode=0644; report.txt\r\n", entry));
+    EXPECT_EQ(entry.name, "report.txt");
+    EXPECT_EQ(entry.size, 1024);
+    EXPECT_EQ(entry.mtime, 1706696100);
+    EXPECT_EQ(entry.perms, 0644);
+    EXPECT_TRUE(entry.type == FileEntry::Type::FILE);
+
+    // 事实名不区分大小写，文件名可以包含空格与分号
+    EXPECT_TRUE(parser.parseLine("Type=DIR;Modify=20231205000000; my dir;v2", entry));
+    EXPECT_EQ(entry.name, "my dir;v2");
+    EXPECT_EQ(entry.size, -1);
+    EXPECT_EQ(entry.mtime, 1701734400);
+    EXPECT_EQ(entry.perms, -1);
+    EXPECT_TRUE(entry.type == FileEntry::Type::DIRECTORY);
+
+    EXPECT_TRUE(parser.parseLine("type=OS.unix=slink:/target;size=7; link", entry));
+    EXPECT_TRUE(entry.type == FileEntry::Type::LINK);
+
+    EXPECT_TRUE(parser.parseLine("type=OS.unix=chr-13/29; tty", entry));
+    EXPECT_TRUE(entry.type == FileEntry::Type::OTHER);
+
+    // 当前目录、父目录与无法识别的行
+    EXPECT_FALSE(parser.parseLine("type=cdir;modify=20240131101500; /home/user", entry));
+    EXPECT_FALSE(parser.parseLine("type=pdir;modify=20240131101500; ..", entry));
+    EXPECT_FALSE(parser.parseLine("type=file;size=1;", entry));
+    EXPECT_FALSE(parser.parseLine("", entry));
+}
+
+void testUnixList() {
+    ListingParser parser(ListingParser::Format::LIST);
+    FileEntry entry;
+
+    EXPECT_TRUE(parser.parseLine("-rw-r--r--   1 user  group     1024 Jan 31  2024 report.txt\r\n", entry));
+    EXPECT_EQ(entry.name, "report.txt");
+    EXPECT_EQ(entry.size, 1024);
+    EXPECT_EQ(entry.mtime, 1706659200);
+    EXPECT_EQ(entry.perms, 0644);
+    EXPECT_TRUE(entry.type == FileEntry::Type::FILE);
+
+    // 省略链接数与组，文件名以空格开头
+    EXPECT_TRUE(parser.parseLine("drwxr-xr-x user 4096 Jun 30 2019  spaced", entry));
+    EXPECT_EQ(entry.name, " spaced");
+    EXPECT_EQ(entry.size, 4096);
+    EXPECT_EQ(entry.perms, 0755);
+    EXPECT_TRUE(entry.type == FileEntry::Type::DIRECTORY);
+
+    // 符号链接去掉 " -> 目标"，特殊权限位
+    EXPECT_TRUE(parser.parseLine("lrwsr-sr-t 1 root root 11 Dec  5  2023 latest -> release-1.2", entry));
+    EXPECT_EQ(entry.name, "latest");
+    EXPECT_EQ(entry.perms, 07755);
+    EXPECT_TRUE(entry.type == FileEntry::Type::LINK);
+
+    // 只显示时间的近期文件，年份由当前日期推断
+    EXPECT_TRUE(parser.parseLine("-rw-r--r-- 1 user group 5 Jan  1 00:00 recent", entry));
+    EXPECT_EQ(entry.name, "recent");
+    EXPECT_TRUE(entry.mtime > 0);
+    EXPECT_EQ(entry.mtime % 86400, 0);
+
+    EXPECT_TRUE(parser.parseLine("crw-rw-rw- 1 root root 0 Jan 31 2024 null", entry));
+    EXPECT_TRUE(entry.type == FileEntry::Type::OTHER);
+
+    EXPECT_FALSE(parser.parseLine("drwxr-xr-x 2 user group 4096 Jan 31 2024 .", entry));
+    EXPECT_FALSE(parser.parseLine("drwxr-xr-x 2 user group 4096 Jan 31 2024 ..", entry));
+    EXPECT_FALSE(parser.parseLine("total 42", entry));
+    EXPECT_FALSE(parser.parseLine("-rw-r--r-- 1 user group 1024 Foo 31 2024 bad", entry));
+    EXPECT_FALSE(parser.parseLine("-rw-r--r-- 1 user group 1024 Jan 31 2024", entry));
+}
+
+void testDOSList() {
+    ListingParser parser(ListingParser::Format::LIST);
+    FileEntry entry;
+
+    EXPECT_TRUE(parser.parseLine("01-31-24  10:15AM       <DIR>          Program Files\r\n", entry));
+    EXPECT_EQ(entry.name, "Program Files");
+    EXPECT_EQ(entry.size, -1);
+    EXPECT_EQ(entry.mtime, 1706696100);
+    EXPECT_TRUE(entry.type == FileEntry::Type::DIRECTORY);
+
+    EXPECT_TRUE(parser.parseLine("01-31-2024  10:15PM                 2048 setup.exe", entry));
+    EXPECT_EQ(entry.name, "setup.exe");
+    EXPECT_EQ(entry.size, 2048);
+    EXPECT_EQ(entry.mtime, 1706739300);
+    EXPECT_TRUE(entry.type == FileEntry::Type::FILE);
+
+    // 12 点的 AM/PM
+    EXPECT_TRUE(parser.parseLine("06-30-19  12:30AM  1 midnight", entry));
+    EXPECT_EQ(entry.mtime % 86400, 30 * 60);
+
+    EXPECT_FALSE(parser.parseLine("01-31-24  10:15AM  <DIR>  ..", entry));
+    EXPECT_FALSE(parser.parseLine("01-31-24  10:15AM  abc  name", entry));
+    EXPECT_FALSE(parser.parseLine("01/31/24  10:15AM  1 name", entry));
+}
+
+} // namespace
+
+int main() {
+    testTimestamp();
+    testMLSD();
+    testUnixList();
+    testDOSList();
+    return ftp::testing::testResult();
+}
@@ -0,0 +1,146 @@
+/**
+ * @file ratelimiter_test.cpp
+ * @brief 令牌桶（TokenBucket）欠账计算与 RateLimiter 的单元测试
+ */
+
+#include "ratelimiter.h"
+#include "testing.h"
+#include <thread>
+
+using namespace ftp;
+
+namespace {
+
+/**
+ * @brief 等待时间（秒）是否在 [low, high] 之内
+ */
+bool waitBetween(std::chrono::nanoseconds wait, double low, double high) {
+    double seconds = std::chrono::duration<double>(wait).count();
+    if (seconds < low || seconds > high) {
+        std::cout << "  wait " << seconds << "s not in [" << low << ", " << high << "]" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void testUnlimited() {
+    TokenBucket bucket;
+    EXPECT_EQ(bucket.getRate(), 0);
+    EXPECT_EQ(bucket.consume(1 << 30).count(), 0);
+
+    // 负数按不限速处理
+    TokenBucket negative(-5);
+    EXPECT_EQ(negative.getRate(), 0);
+    EXPECT_EQ(negative.consume(1 << 20).count(), 0);
+}
+
+void testDebt() {
+    // 初始没有令牌：扣除立即生效，返回还清欠账所需的时间
+    TokenBucket bucket(1000000);
+    EXPECT_TRUE(waitBetween(bucket.consume(500000), 0.49, 0.5));
+
+    // 调用方未等待时欠账累积，后续扣除需要等待更久
+    EXPECT_TRUE(waitBetween(bucket.consume(500000), 0.99, 1.0));
+    EXPECT_TRUE(waitBetween(bucket.consume(250000), 1.24, 1.25));
+}
+
+void testRepayment() {
+    // 等待返回的时间后欠账已还清，下一块只需等待它自己的时间
+    TokenBucket bucket(1000000);
+    std::chrono::nanoseconds wait = bucket.consume(100000);
+    EXPECT_TRUE(waitBetween(wait, 0.09, 0.1));
+    std::this_thread::sleep_for(wait);
+    EXPECT_TRUE(waitBetween(bucket.consume(100000), 0.05, 0.1));
+}
+
+void testBurst() {
+    // 空闲期间最多积累 BURST_SECONDS 秒的令牌
+    TokenBucket bucket(4000000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    EXPECT_EQ(bucket.consume(1000000).count(), 0);
+    EXPECT_TRUE(waitBetween(bucket.consume(1000000), 0.24, 0.25));
+}
+
+void testSetRate() {
+    TokenBucket bucket(1000000);
+    bucket.consume(1000000);
+
+    // 速率不变时保留欠账
+    bucket.setRate(1000000);
+    EXPECT_TRUE(waitBetween(bucket.consume(0), 0.99, 1.0));
+
+    // 修改速率清空欠账，之后按新速率计算
+    bucket.setRate(2000000);
+    EXPECT_EQ(bucket.getRate(), 2000000);
+    EXPECT_TRUE(waitBetween(bucket.consume(1000000), 0.49, 0.5));
+
+    bucket.setRate(0);
+    EXPECT_EQ(bucket.consume(1000000).count(), 0);
+}
+
+void testBatchSize() {
+    RateLimiter unlimited;
+    EXPECT_EQ(unlimited.batchSize(1 << 20), static_cast<size_t>(1 << 20));
+
+    auto limits = std::make_shared<RateLimits>();
+    auto host = std::make_shared<TokenBucket>(400000);
+    limits->setShared({std::make_shared<TokenBucket>(), host});
+
+    // 取所有令牌桶中最低的速率，约 BATCH_MILLISECONDS 的流量
+    limits->setTransferRate(1000000);
+    RateLimiter limiter(limits);
+    EXPECT_EQ(limiter.batchSize(1 << 20), static_cast<size_t>(400000 * RateLimiter::BATCH_MILLISECONDS / 1000));
+    EXPECT_EQ(limiter.batchSize(1000), static_cast<size_t>(1000));
+
+    // 速率很低时不小于 MIN_BATCH
+    host->setRate(1000);
+    EXPECT_EQ(limiter.batchSize(1 << 20), RateLimiter::MIN_BATCH);
+
+    host->setRate(0);
+    limits->setTransferRate(0);
+    EXPECT_EQ(limiter.batchSize(1 << 20), static_cast<size_t>(1 << 20));
+}
+
+void testConsume() {
+    auto limits = std::make_shared<RateLimits>();
+    limits->setTransferRate(1000000);
+
+    // 每个 RateLimiter 有独立的单传输令牌桶：second 的令牌在 first 等待期间积累，无需再等待
+    RateLimiter first(limits);
+    RateLimiter second(limits);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(first.consume(100000));
+    EXPECT_TRUE(second.consume(100000));
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_TRUE(elapsed >= 0.09 && elapsed < 0.19);
+
+    // 共享令牌桶按扣除顺序分配：两个传输合计受同一速率限制
+    auto shared = std::make_shared<RateLimits>();
+    shared->setShared({std::make_shared<TokenBucket>(1000000)});
+    RateLimiter third(shared);
+    RateLimiter fourth(shared);
+    start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(third.consume(100000));
+    EXPECT_TRUE(fourth.consume(100000));
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_TRUE(elapsed >= 0.19 && elapsed < 0.3);
+
+    // 等待期间停止时提前返回
+    start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(first.consume(10000000, []() { return true; }));
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_TRUE(elapsed < 0.1);
+}
+
+} // namespace
+
+int main() {
+    testUnlimited();
+    testDebt();
+    testRepayment();
+    testBurst();
+    testSetRate();
+    testBatchSize();
+    testConsume();
+    return ftp::testing::testResult();
+}
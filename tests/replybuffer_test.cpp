@@ -0,0 +1,158 @@
+/**
+ * @file replybuffer_test.cpp
+ * @brief 控制连接响应解析器（ReplyBuffer）的单元测试
+ */
+
+#include "replybuffer.h"
+#include "testing.h"
+#include <cstring>
+#include <string>
+
+using namespace ftp;
+
+namespace {
+
+/**
+ * @brief 按 prepare/commit 的方式写入数据，与从套接字读取相同
+ */
+void feed(ReplyBuffer& buffer, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        size_t available = 0;
+        char* dest = buffer.prepare(available);
+        if (!dest) {
+            return;
+        }
+        size_t n = std::min(available, data.size() - offset);
+        std::memcpy(dest, data.data() + offset, n);
+        buffer.commit(n);
+        offset += n;
+    }
+}
+
+void testSingleLine() {
+    ReplyBuffer buffer;
+    int code = -1;
+    std::string_view text;
+
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_FALSE(buffer.next(code, text));
+
+    feed(buffer, "220 Service ready\r\n");
+    EXPECT_TRUE(buffer.hasReply());
+    EXPECT_TRUE(buffer.next(code, text));
+    EXPECT_EQ(code, 220);
+    EXPECT_EQ(text, "Service ready");
+    EXPECT_TRUE(buffer.empty());
+}
+
+void testMultiLine() {
+    ReplyBuffer buffer;
+    int code = 0;
+    std::string_view text;
+
+    // 中间行以空格开头，或以其他响应码开头，都不结束响应
+    feed(buffer, "211-Features:\r\n MLST type*;size*;\r\n200 not the end\r\n211-still not\r\n211 End\r\n");
+    EXPECT_TRUE(buffer.next(code, text));
+    EXPECT_EQ(code, 211);
+    EXPECT_EQ(text, "Features:\r\n MLST type*;size*;\r\n200 not the end\r\n211-still not\r\n211 End");
+    EXPECT_FALSE(buffer.hasReply());
+}
+
+void testPartialReads() {
+    ReplyBuffer buffer;
+    int code = 0;
+    std::string_view text;
+
+    // 逐字节到达：结束行完整之前不算一条响应
+    std::string reply = "250-Listing /pub\r\n type=dir; /pub\r\n250 End\r\n";
+    for (size_t i = 0; i + 1 < reply.size(); ++i) {
+        feed(buffer, reply.substr(i, 1));
+        EXPECT_FALSE(buffer.hasReply());
+    }
+    feed(buffer, reply.substr(reply.size() - 1));
+    EXPECT_TRUE(buffer.next(code, text));
+    EXPECT_EQ(code, 250);
+    EXPECT_EQ(text, "Listing /pub\r\n type=dir; /pub\r\n250 End");
+}
+
+void testPipelinedReplies() {
+    ReplyBuffer buffer;
+    int code = 0;
+    std::string_view text;
+
+    // 一次读取包含多条响应，最后一条不完整
+    feed(buffer, "200 ok\r\n213-Status\r\n size 10\r\n213 End\r\n350 Restarting");
+    EXPECT_TRUE(buffer.next(code, text));
+    EXPECT_EQ(code, 200);
+    EXPECT_EQ(text, "ok");
+    EXPECT_TRUE(buffer.next(code, text));
+    EXPECT_EQ(code, 213);
+    EXPECT_EQ(text, "Status\r\n size 10\r\n213 End");
+    EXPECT_FALSE(buffer.hasReply());
+    EXPECT_FALSE(buffer.empty());
+
+    feed(buffer, " at 100\n");
+    EXPECT_TRUE(buffer.next(code, text));
+    EXPECT_EQ(code, 350);
+    EXPECT_EQ(text, "Restarting at 100");
+}
+
+void testMalformed() {
+    ReplyBuffer buffer;
+    int code = -1;
+    std::string_view text;
+
+    // 首行不是 "ddd-" 时按单行响应处理，响应码无法识别时为 0
+    feed(buffer, "hello\r\n12-x\r\n500\r\n");
+    EXPECT_TRUE(buffer.next(code, text));
+    EXPECT_EQ(code, 0);
+    EXPECT_EQ(text, "hello");
+    EXPECT_TRUE(buffer.next(code, text));
+    EXPECT_EQ(code, 0);
+    EXPECT_TRUE(buffer.next(code, text));
+    EXPECT_EQ(code, 500);
+    EXPECT_EQ(text, "");
+}
+
+void testCompaction() {
+    ReplyBuffer buffer;
+    int code = 0;
+    std::string_view text;
+
+    // 反复取出响应并保留不完整的尾部，缓冲区前移后解析位置保持正确
+    std::string line = "226-" + std::string(1000, 'x') + "\r\n";
+    for (int round = 0; round < 50; ++round) {
+        feed(buffer, line + line + "226 Done\r\n200 pa");
+        EXPECT_TRUE(buffer.next(code, text));
+        EXPECT_EQ(code, 226);
+        EXPECT_EQ(text.size(), line.size() * 2 - 4 + 8);
+        feed(buffer, "rtial\r\n");
+        EXPECT_TRUE(buffer.next(code, text));
+        EXPECT_EQ(text, "partial");
+    }
+    EXPECT_TRUE(buffer.empty());
+
+    // 超过 MAX_BUFFERED 仍没有结束行时不再接收数据
+    std::string huge(ReplyBuffer::MAX_BUFFERED, 'y');
+    feed(buffer, "150-" + huge);
+    size_t available = 1;
+    EXPECT_TRUE(buffer.prepare(available) == nullptr);
+    EXPECT_EQ(available, 0u);
+
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_TRUE(buffer.prepare(available) != nullptr);
+}
+
+} // namespace
+
+int main() {
+    testSingleLine();
+    testMultiLine();
+    testPartialReads();
+    testPipelinedReplies();
+    testMalformed();
+    testCompaction();
+    return ftp::testing::testResult();
+}
@@ -0,0 +1,55 @@
+// Include Guards - testing.h
+#ifndef FTP_TESTING_H
+#define FTP_TESTING_H
+
+#include <iostream>
+
+/**
+ * @brief 单元测试使用的断言宏
+ *
+ * 断言失败时输出文件、行号与表达式并记录失败次数，继续执行后续检查；
+ * 测试程序以 testResult() 作为退出码，由 ctest 判断是否通过。
+ */
+
+namespace ftp {
+namespace testing {
+
+inline int& failureCount() {
+    static int count = 0;
+    return count;
+}
+
+inline int testResult() {
+    if (failureCount() == 0) {
+        std::cout << "All checks passed" << std::endl;
+        return 0;
+    }
+    std::cout << failureCount() << " check(s) failed" << std::endl;
+    return 1;
+}
+
+} // namespace testing
+} // namespace ftp
+
+#define EXPECT_TRUE(expr)                                                           \
+    do {                                                                            \
+        if (!(expr)) {                                                              \
+            std::cout << __FILE__ << ":" << __LINE__ << ": expected " #expr << std::endl; \
+            ++ftp::testing::failureCount();                                         \
+        }                                                                           \
+    } while (0)
+
+#define EXPECT_FALSE(expr) EXPECT_TRUE(!(expr))
+
+#define EXPECT_EQ(actual, expected)                                                 \
+    do {                                                                            \
+        auto actualValue = (actual);                                                \
+        auto expectedValue = (expected);                                            \
+        if (!(actualValue == expectedValue)) {                                      \
+            std::cout << __FILE__ << ":" << __LINE__ << ": " #actual " is "         \
+                      << actualValue << ", expected " << expectedValue << std::endl; \
+            ++ftp::testing::failureCount();                                         \
+        }                                                                           \
+    } while (0)
+
+#endif // FTP_TESTING_H